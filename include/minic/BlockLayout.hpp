@@ -0,0 +1,39 @@
+#ifndef MINIC_BLOCKLAYOUT_HPP
+#define MINIC_BLOCKLAYOUT_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class BlockLayout
+ * @brief Order the blocks of a function so that as many jumps as possible
+ * become fall-throughs into the next block.
+ *
+ * Blocks are placed in chains. Starting from the entry, each block is followed
+ * by an unplaced successor if one qualifies: the target of a JUMP, and for a
+ * conditional jump preferably the successor that stays in the innermost loop
+ * around the block, otherwise the one IRGenerator puts next (the result
+ * operand: the then side of an if, the body of a loop). A successor waits
+ * until all its predecessors other than back edges are placed, so a join
+ * comes after both arms, and no chain leaves a loop that still has unplaced
+ * blocks. When a chain ends, the next one starts at the first unplaced block
+ * in reverse postorder within the innermost loop around the last placed
+ * block, or anywhere once that loop is done, so every loop is laid out as one
+ * contiguous run. Blocks that passes appended at the end of the function
+ * (preheaders, split edges, clones) move next to the code they belong to.
+ *
+ * The code generator omits a jmp to the next block and inverts a conditional
+ * jump whose taken target is next, so every chain link saves one jump.
+ */
+class BlockLayout : public IRPass
+{
+public:
+    std::string name() const override { return "block-layout"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_BLOCKLAYOUT_HPP
@@ -0,0 +1,106 @@
+#ifndef MINIC_CFG_HPP
+#define MINIC_CFG_HPP
+
+#include "minic/IR.hpp"
+#include <vector>
+
+namespace minic
+{
+
+/**
+ * @class ControlFlowGraph
+ * @brief Successor/predecessor edges and dominance information for an IRFunction.
+ *
+ * Edges are read from the terminator of every block when the graph is built,
+ * so the function must be well formed (IRFunction::verify). The reverse
+ * postorder, the dominator tree and dominance frontiers are computed on first use and cached; the
+ * graph is a snapshot, so rebuild it after a pass changes control flow.
+ */
+class ControlFlowGraph
+{
+public:
+    /**
+     * @brief Build the edge lists for a function.
+     * @param func Function to analyze; must outlive the graph.
+     */
+    explicit ControlFlowGraph(const IRFunction& func);
+
+    /**
+     * @brief Number of blocks (reachable or not).
+     */
+    size_t size() const { return succs_.size(); }
+
+    /**
+     * @brief Distinct successors of a block, in terminator operand order.
+     */
+    const std::vector<BlockId>& successors(BlockId id) const { return succs_[id]; }
+
+    /**
+     * @brief Distinct predecessors of a block, in block order.
+     */
+    const std::vector<BlockId>& predecessors(BlockId id) const { return preds_[id]; }
+
+    /**
+     * @brief Blocks reachable from the entry, in reverse postorder.
+     */
+    const std::vector<BlockId>& reverse_postorder() const;
+
+    /**
+     * @brief Position of a block in reverse_postorder(), or -1 if unreachable.
+     */
+    int rpo_index(BlockId id) const;
+
+    /**
+     * @brief Whether the block is reachable from the entry.
+     */
+    bool reachable(BlockId id) const { return rpo_index(id) >= 0; }
+
+    /**
+     * @brief Immediate dominator of a block.
+     *
+     * The entry is its own immediate dominator; unreachable blocks return -1.
+     */
+    BlockId idom(BlockId id) const;
+
+    /**
+     * @brief Children of a block in the dominator tree.
+     */
+    const std::vector<BlockId>& dom_children(BlockId id) const;
+
+    /**
+     * @brief Whether a dominates b (every block dominates itself).
+     */
+    bool dominates(BlockId a, BlockId b) const;
+
+    /**
+     * @brief Dominance frontier of a block: the blocks where its dominance ends.
+     *
+     * These are the join points that need a phi for a value defined in the block.
+     */
+    const std::vector<BlockId>& dominance_frontier(BlockId id) const;
+
+private:
+    void compute_rpo() const;
+    void compute_dominators() const;
+    void compute_frontiers() const;
+
+    std::vector<std::vector<BlockId>> succs_; ///< Successor lists by block
+    std::vector<std::vector<BlockId>> preds_; ///< Predecessor lists by block
+
+    mutable bool rpo_valid_ = false; ///< Whether rpo_/rpo_index_ are computed
+    mutable std::vector<BlockId> rpo_; ///< Reachable blocks in reverse postorder
+    mutable std::vector<int> rpo_index_; ///< Position in rpo_ by block, -1 if unreachable
+
+    mutable bool dom_valid_ = false; ///< Whether the dominator tree is computed
+    mutable std::vector<BlockId> idom_; ///< Immediate dominator by block
+    mutable std::vector<std::vector<BlockId>> dom_children_; ///< Dominator tree children by block
+    mutable std::vector<int> dom_pre_; ///< Preorder number in the dominator tree
+    mutable std::vector<int> dom_post_; ///< Postorder number in the dominator tree
+
+    mutable bool df_valid_ = false; ///< Whether df_ is computed
+    mutable std::vector<std::vector<BlockId>> df_; ///< Dominance frontier by block
+};
+
+} // namespace minic
+
+#endif // MINIC_CFG_HPP
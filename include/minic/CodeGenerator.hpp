@@ -6,7 +6,6 @@
 #include <ostream>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace minic
@@ -67,11 +66,58 @@ private:
     /**
      * @brief Emit a basic block.
      *
-     * Writes the block label (if needed) and emits contained instructions in order.
+     * Writes the block label and emits contained instructions in order. The
+     * IR is verified up front, so every block ends in its own terminator.
      *
-     * @param block BasicBlock to emit.
+     * @param id ID of the block within the current function.
      */
-    void emit_block(const BasicBlock& block);
+    void emit_block(BlockId id);
+
+    /**
+     * @brief Emit a jump to a block, or nothing when it is laid out next.
+     *
+     * Used for JUMP and for the non-branching target of a conditional jump;
+     * control falls through to the next block on its own.
+     *
+     * @param target BLOCK operand to continue at.
+     */
+    void emit_fallthrough(const IROperand& target);
+
+    /**
+     * @brief Emit the jcc of a conditional jump once the flags are set.
+     *
+     * Jumps to the taken target (operand2) on condition and falls through or
+     * jumps to the other one. When the taken target is the next block, it
+     * jumps to the other target on the inverse condition and falls through instead.
+     *
+     * @param condition Condition code under which operand2 is taken, e.g. "ne".
+     * @param inverse The opposite condition code.
+     * @param branch The block's JUMPIF or JUMPIFNOT.
+     */
+    void emit_branch(const std::string& condition, const std::string& inverse, const IRInstruction& branch);
+
+    /**
+     * @brief The comparison a block's conditional jump can branch on directly.
+     *
+     * Returns the instruction computing the jump's condition when it is a
+     * comparison, the jump is the only reader of its result, and no
+     * instruction between the two writes the comparison's operands; nullptr
+     * otherwise.
+     *
+     * @param id ID of the block within the current function.
+     */
+    const IRInstruction* fused_comparison(BlockId id) const;
+
+    /**
+     * @brief Emit a comparison and the conditional jump reading it as one cmp and jcc.
+     *
+     * The condition code is the comparison's for JUMPIF and its inverse for
+     * JUMPIFNOT, so the 0/1 result is never materialized or stored.
+     *
+     * @param compare Comparison found by fused_comparison().
+     * @param branch The block's JUMPIF or JUMPIFNOT.
+     */
+    void emit_compare_and_branch(const IRInstruction& compare, const IRInstruction& branch);
 
     /**
      * @brief Emit a single IR instruction.
@@ -94,46 +140,36 @@ private:
     void allocate_stack(const IRFunction& func);
 
     /**
-     * @brief Get the textual location for a variable name.
+     * @brief Get the textual location for an operand.
      *
-     * Returns a string describing where the named variable is stored
-     * (e.g., a stack reference or register name) based on current offsets.
+     * Returns a string describing where the operand lives: a stack reference
+     * for variables and temporaries, the number for immediates, and the label
+     * for blocks and string constants.
      *
-     * @param name Variable name or temporary.
+     * @param op Operand to locate.
      * @return Textual location used in emitted code.
      */
-    std::string get_loc(const std::string& name);
+    std::string get_loc(const IROperand& op);
 
     /**
-     * @brief Find a label that contains the provided substring.
-     *
-     * Useful for heuristics when mapping control-flow targets back to labels.
-     *
-     * @param substr Substring to search for inside known labels.
-     * @return Matching label name, or empty string if none found.
-     */
-    std::string find_label_with_substr(const std::string& substr) const;
-
-    /**
-     * @brief Infer the branch target label for the current block.
-     *
-     * Uses block ordering and label maps to determine the most reasonable
-     * fall-through or explicit target for branches emitted from the current block.
+     * @brief Get the data label for a string constant, recording its bytes for the data section.
      *
-     * @return Inferred label name for the current block's primary target.
+     * @param op STR operand of the current function.
+     * @return Label of the emitted string data.
      */
-    std::string infer_target_label_for_current_block() const;
+    std::string string_label(const IROperand& op);
 
     std::ostream* out_; ///< Output stream used for emitted code.
     std::unordered_map<TokenType, std::string> type_map_; ///< Mapping IR types to textual types.
     std::string current_function_; ///< Name of the function currently being emitted.
+    const IRFunction* current_ir_function_ = nullptr; ///< Function currently being emitted (non-owning).
+    BlockId current_block_ = 0; ///< ID of the current basic block.
     std::string current_block_label_; ///< Label of the current basic block.
     int stack_offset_; ///< Current stack offset for locals within the active function.
-    std::unordered_map<std::string, int> var_offsets_; ///< Map from variable name to stack offset.
-    std::vector<std::string> block_labels_; ///< Ordered list of block labels for the current function.
-    std::unordered_map<std::string, size_t> block_index_; ///< Mapping block label -> index in block_labels_.
-    std::unordered_set<std::string> labels_; ///< Set of labels already emitted/known.
-    std::string last_written_loc_; ///< Last emitted location string (to avoid redundant moves).
+    std::vector<int> var_offsets_; ///< Stack offset by VAR ID (0 = not allocated).
+    std::vector<int> temp_offsets_; ///< Stack offset by TEMP ID (0 = not allocated).
+    std::vector<std::string> string_data_; ///< Data-section lines for string constants.
+    std::vector<int> temp_reads_; ///< Number of reads of each TEMP ID in the current function.
 
     friend class PublicCodeGenerator;
 };
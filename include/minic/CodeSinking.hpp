@@ -0,0 +1,35 @@
+#ifndef MINIC_CODESINKING_HPP
+#define MINIC_CODESINKING_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class CodeSinking
+ * @brief Move computations down into the blocks that use them, so paths that
+ * do not need a value skip computing it.
+ *
+ * An instruction is sunk when it computes a value without side effects and
+ * cannot trap (see is_speculatable) and nothing in its own block reads it.
+ * It moves to the start of the nearest block that dominates all its uses,
+ * where a phi operand counts as a use at the end of the predecessor it flows
+ * in from. The target is moved back up the dominator tree while it lies in a
+ * loop the original block is not in, so nothing is sunk into a loop and
+ * executed more often than before.
+ *
+ * Blocks are visited in postorder and their instructions from last to first,
+ * so an instruction whose only user was just sunk can follow it. Only valid
+ * in SSA form.
+ */
+class CodeSinking : public IRPass
+{
+public:
+    std::string name() const override { return "sink"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_CODESINKING_HPP
@@ -0,0 +1,34 @@
+#ifndef MINIC_COPYPROPAGATION_HPP
+#define MINIC_COPYPROPAGATION_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class CopyPropagation
+ * @brief Rewrite uses of copies to read the copied value directly.
+ *
+ * A temp with a single definition that is a copy (`ASSIGN t, x`) of an
+ * immediate, a single-definition temp or a variable nothing writes names the
+ * same value everywhere, so every use of t is rewritten to x and the copy is
+ * deleted. A phi whose incoming values are all the same value (apart from the
+ * phi itself) is such a copy too; removing one can make others trivial, so
+ * this repeats until no more are found. Chains of copies resolve to their
+ * original source.
+ *
+ * Copies into variables and multiply-defined temps are propagated within
+ * their block, up to the next write of either side; the copies themselves
+ * are left for dead code elimination.
+ */
+class CopyPropagation : public IRPass
+{
+public:
+    std::string name() const override { return "copyprop"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_COPYPROPAGATION_HPP
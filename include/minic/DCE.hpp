@@ -0,0 +1,35 @@
+#ifndef MINIC_DCE_HPP
+#define MINIC_DCE_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class DeadCodeElimination
+ * @brief Delete instructions and phis whose results are never used, and dead stores.
+ *
+ * Two sweeps repeat until neither changes anything:
+ *  - a mark phase starting from terminators and trapping divisions marks
+ *    every temp and variable a useful instruction reads; instructions and
+ *    phis defining nothing useful are deleted (this also removes dead cycles,
+ *    such as a loop counter that is only read to increment itself);
+ *  - a backward liveness analysis over temps and variables deletes every
+ *    instruction whose result is dead right after it, which catches stores
+ *    to a variable that is overwritten or never read before the function returns.
+ *
+ * An instruction is removable when it writes a temp or variable and
+ * is_speculatable holds for it; everything else is assumed to have an effect.
+ * The pass works both in and out of SSA form.
+ */
+class DeadCodeElimination : public IRPass
+{
+public:
+    std::string name() const override { return "dce"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_DCE_HPP
@@ -0,0 +1,35 @@
+#ifndef MINIC_GVN_HPP
+#define MINIC_GVN_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class GVN
+ * @brief Dominator-based global value numbering: reuse an earlier identical computation.
+ *
+ * Walks the dominator tree with a scoped hash table keyed by opcode plus the
+ * value numbers of the operands (commutative operations and mirrored
+ * comparisons share one key). An instruction whose key is already in scope
+ * is redundant: the dominating instruction computed the same value, so every
+ * use is rewritten to it and the instruction is deleted. Copies number their
+ * result like their source, and phis in the same block with the same incoming
+ * values are merged.
+ *
+ * Only single-definition temps are numbered, and only instructions whose
+ * operands are immediates, single-definition temps or variables nothing
+ * writes take part, so the pass is safe outside SSA form but finds the most
+ * after SSAConstruction.
+ */
+class GVN : public IRPass
+{
+public:
+    std::string name() const override { return "gvn"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_GVN_HPP
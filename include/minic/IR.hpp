@@ -2,7 +2,10 @@
 #define MINIC_IR_HPP
 
 #include "AST.hpp"
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -15,12 +18,16 @@ namespace minic
  * Represents a compact set of operations used by the IR layer:
  * arithmetic, comparisons, assignments, memory access, control flow, and labels.
  */
-enum class IROpcode
+enum class IROpcode : std::uint8_t
 {
     ADD,
     SUB,
     MUL,
     DIV, // Arithmetic
+    SHL,
+    SHR,
+    SAR,
+    MULH, // Shifts and high multiply, emitted by strength reduction
     NEG,
     NOT,
     EQ,
@@ -30,6 +37,7 @@ enum class IROpcode
     LE,
     GE, // Comparisons
     ASSIGN, // Assignment
+    SELECT, // Conditional move, emitted by if-conversion out of SSA form
     LOAD,
     STORE, // Variable access
     JUMP,
@@ -39,51 +47,245 @@ enum class IROpcode
     LABEL // Block label
 };
 
+/**
+ * @brief Kinds of values an IR operand slot can hold.
+ */
+enum class IROperandKind : std::uint8_t
+{
+    NONE, // Unused operand slot
+    TEMP, // Compiler temporary, ID is the temp number
+    VAR, // Source variable or parameter, ID indexes IRFunction::variables
+    IMM, // Integer immediate
+    BLOCK, // Basic block reference, ID indexes IRFunction::blocks
+    STR // String constant, ID indexes IRFunction::strings
+};
+
+/**
+ * @class IROperand
+ * @brief A tagged 8-byte operand: a kind plus a 32-bit ID or immediate.
+ *
+ * Immediates are limited to 32 bits because that is what x86-64 instructions
+ * accept as a sign-extended immediate; wider values live in temporaries.
+ */
+class IROperand
+{
+public:
+    IROperandKind kind = IROperandKind::NONE; ///< What the value field means
+    std::int32_t value = 0; ///< Temp/var/block/string ID or the immediate itself
+
+    static IROperand temp(std::int32_t id) { return { IROperandKind::TEMP, id }; }
+    static IROperand var(std::int32_t id) { return { IROperandKind::VAR, id }; }
+    static IROperand imm(std::int32_t v) { return { IROperandKind::IMM, v }; }
+    static IROperand block(std::int32_t id) { return { IROperandKind::BLOCK, id }; }
+    static IROperand str(std::int32_t id) { return { IROperandKind::STR, id }; }
+
+    bool empty() const { return kind == IROperandKind::NONE; }
+    bool is_temp() const { return kind == IROperandKind::TEMP; }
+    bool is_var() const { return kind == IROperandKind::VAR; }
+    bool is_imm() const { return kind == IROperandKind::IMM; }
+    bool is_block() const { return kind == IROperandKind::BLOCK; }
+    bool is_str() const { return kind == IROperandKind::STR; }
+
+    bool operator==(const IROperand&) const = default;
+};
+
+static_assert(sizeof(IROperand) == 8, "IROperand must stay a compact 8-byte value");
+
 /**
  * @class IRInstruction
  * @brief A single IR instruction.
  *
  * An IR instruction has an opcode and up to two operands plus an optional
  * result (used for temporary variables or label names).
+ *
+ * Terminators use their slots as follows:
+ *  - JUMP: operand1 = target block.
+ *  - JUMPIF: operand1 = condition, operand2 = block taken when it is non-zero,
+ *    result = block taken otherwise.
+ *  - JUMPIFNOT: operand1 = condition, operand2 = block taken when it is zero,
+ *    result = block taken otherwise.
+ *  - RETURN: operand1 = optional return value.
+ *
+ * SELECT is a two-address conditional move: result = operand2 when operand1 is
+ * non-zero, and keeps its value otherwise. Since it reads its own result it
+ * only appears out of SSA form.
  */
 class IRInstruction
 {
 public:
     IROpcode opcode; ///< The opcode for this instruction
-    std::string result; ///< Destination (temp var or label)
-    std::string operand1; ///< First operand (or sole operand)
-    std::string operand2; ///< Second operand (for binary ops)
+    IROperand result; ///< Destination (temp var or label)
+    IROperand operand1; ///< First operand (or sole operand)
+    IROperand operand2; ///< Second operand (for binary ops)
 
     /**
      * @brief Construct an IRInstruction.
      * @param op The opcode.
-     * @param res Optional result name.
+     * @param res Optional result operand.
      * @param op1 Optional first operand.
      * @param op2 Optional second operand.
      */
     IRInstruction(IROpcode op,
-        const std::string& res = {},
-        const std::string& op1 = {},
-        const std::string& op2 = {})
+        IROperand res = {},
+        IROperand op1 = {},
+        IROperand op2 = {})
         : opcode(op)
         , result(res)
         , operand1(op1)
         , operand2(op2)
     {
     }
+
+    /**
+     * @brief Whether this instruction ends a basic block.
+     */
+    bool is_terminator() const
+    {
+        return opcode == IROpcode::JUMP || opcode == IROpcode::JUMPIF || opcode == IROpcode::JUMPIFNOT || opcode == IROpcode::RETURN;
+    }
+
+    /**
+     * @brief Blocks control may transfer to after this instruction (empty unless a jump).
+     */
+    std::vector<IROperand> targets() const
+    {
+        switch (opcode)
+        {
+        case IROpcode::JUMP:
+            return { operand1 };
+        case IROpcode::JUMPIF:
+        case IROpcode::JUMPIFNOT:
+            return { operand2, result };
+        default:
+            return {};
+        }
+    }
+
+    /**
+     * @brief Make every jump target naming block from name block to instead.
+     */
+    void retarget(std::int32_t from, std::int32_t to)
+    {
+        if (opcode == IROpcode::JUMP && operand1 == IROperand::block(from))
+            operand1 = IROperand::block(to);
+        if (opcode == IROpcode::JUMPIF || opcode == IROpcode::JUMPIFNOT)
+        {
+            if (operand2 == IROperand::block(from))
+                operand2 = IROperand::block(to);
+            if (result == IROperand::block(from))
+                result = IROperand::block(to);
+        }
+    }
+};
+
+/**
+ * @brief Whether the opcode is one of the six comparisons (EQ through GE).
+ */
+bool is_comparison(IROpcode op);
+
+/**
+ * @brief The comparison that gives the same answer with its operands swapped (a < b is b > a).
+ */
+IROpcode swap_comparison(IROpcode op);
+
+/**
+ * @brief The comparison that gives the opposite answer for the same operands (a < b is !(a >= b)).
+ */
+IROpcode invert_comparison(IROpcode op);
+
+/**
+ * @brief Whether an instruction only computes its result: no effect besides
+ * writing it and no way to trap (DIV qualifies only with an immediate divisor
+ * other than 0 and -1), so it may be deleted when unused or executed speculatively.
+ */
+bool is_speculatable(const IRInstruction& instr);
+
+/**
+ * @brief Rough x86-64 latency of an instruction in cycles: 40 for DIV (idiv),
+ * 3 for MUL (imul, or 1 by 3, 5 or 9, which becomes lea) and MULH, 1 for
+ * anything else.
+ */
+std::uint64_t estimated_cycles(const IRInstruction& instr);
+
+/**
+ * @brief Evaluate a value-computing opcode on constants.
+ *
+ * Uses the target's 64-bit semantics: ADD, SUB, MUL and NEG wrap, DIV truncates
+ * toward zero, SHL, SHR (logical) and SAR (arithmetic) shift a by the low six
+ * bits of b, MULH is the high half of the 128-bit signed product, comparisons
+ * and NOT yield 0 or 1, ASSIGN yields a. Unary opcodes
+ * ignore b. Returns std::nullopt for opcodes that compute no value and for a
+ * DIV that traps (divisor 0, or INT64_MIN / -1).
+ */
+std::optional<std::int64_t> evaluate(IROpcode op, std::int64_t a, std::int64_t b = 0);
+
+/**
+ * @brief Fold an operation over immediate operands into an immediate.
+ *
+ * Returns std::nullopt unless every operand the opcode reads is an immediate,
+ * evaluate() succeeds and the result fits an imm32.
+ */
+std::optional<IROperand> fold_constant(IROpcode op, const IROperand& a, const IROperand& b);
+
+/**
+ * @brief Index of a basic block within its IRFunction (the value of a BLOCK operand).
+ */
+using BlockId = std::int32_t;
+
+/**
+ * @struct PhiIncoming
+ * @brief One incoming edge of a phi: the value flowing in from a predecessor block.
+ */
+struct PhiIncoming
+{
+    BlockId block; ///< Predecessor block
+    IROperand value; ///< Value when control arrives from that predecessor
+};
+
+/**
+ * @class PhiNode
+ * @brief An SSA phi function at the top of a basic block.
+ *
+ * The result takes the value of the incoming entry for the predecessor control
+ * arrived from. Phis only exist while a function is in SSA form (between the
+ * SSAConstruction and SSADestruction passes) and are kept beside the block
+ * rather than in the instruction arena, since they are executed "on the edge".
+ */
+class PhiNode
+{
+public:
+    IROperand result; ///< Temp defined by the phi
+    std::vector<PhiIncoming> incoming; ///< One entry per predecessor
+
+    /**
+     * @brief The incoming value for a predecessor, or an empty operand if there is none.
+     */
+    IROperand value_from(BlockId pred) const
+    {
+        for (const auto& in : incoming)
+        {
+            if (in.block == pred)
+                return in.value;
+        }
+        return {};
+    }
 };
 
 /**
  * @class BasicBlock
- * @brief A sequence of IR instructions with a label.
+ * @brief A labelled range of instructions in the owning function's arena.
  *
  * Basic blocks group instructions and are the unit of control-flow in the IR.
+ * A block does not own its instructions: it names the contiguous range
+ * [begin, begin + size) of IRFunction::instructions.
  */
 class BasicBlock
 {
 public:
     std::string label; ///< Unique label for the block
-    std::vector<IRInstruction> instructions; ///< Instructions contained in the block
+    std::uint32_t begin = 0; ///< Index of the first instruction in the function arena
+    std::uint32_t size = 0; ///< Number of instructions in the block
+    std::vector<PhiNode> phis; ///< Phi nodes (SSA form only)
 
     /**
      * @brief Construct a BasicBlock with the given label.
@@ -99,7 +301,12 @@ public:
  * @class IRFunction
  * @brief Represents a function in the IR.
  *
- * Stores function name, return type, parameter list, and a sequence of basic blocks.
+ * Stores function name, return type, parameter list, and a sequence of basic
+ * blocks. All instructions of the function live in one contiguous arena; blocks
+ * are index ranges into it and are referred to by BlockId (block 0 is the entry).
+ * Blocks are laid out in the arena in block order, so walking every instruction
+ * streams through memory; edits that grow a block move it to the end of the
+ * arena until compact() restores the layout.
  */
 class IRFunction
 {
@@ -107,10 +314,17 @@ public:
     std::string name; ///< Function name
     TokenType return_type; ///< Function return type (from AST/Token)
     std::vector<Parameter> parameters; ///< Function parameters
-    std::vector<std::unique_ptr<BasicBlock>> blocks; ///< Owned basic blocks
+    std::vector<IRInstruction> instructions; ///< Instruction arena shared by all blocks
+    std::vector<BasicBlock> blocks; ///< Basic blocks indexed by BlockId
+    std::vector<std::string> variables; ///< Variable names by VAR ID, parameters first
+    std::vector<std::string> strings; ///< String constants by STR ID
+    std::int32_t temp_count = 0; ///< Number of temporaries allocated so far
 
     /**
      * @brief Construct an IRFunction.
+     *
+     * Parameters are registered as the first variables, so parameter i has VAR ID i.
+     *
      * @param n Function name.
      * @param rt Return type.
      * @param params Parameter list (moved).
@@ -120,6 +334,139 @@ public:
         , return_type(rt)
         , parameters(std::move(params))
     {
+        for (const auto& param : parameters)
+            variable(param.name);
+    }
+
+    /**
+     * @brief Get the VAR operand for a variable name, registering it if new.
+     * @param var_name Source-level variable name.
+     */
+    IROperand variable(const std::string& var_name)
+    {
+        for (size_t i = 0; i < variables.size(); ++i)
+        {
+            if (variables[i] == var_name)
+                return IROperand::var(static_cast<std::int32_t>(i));
+        }
+        variables.push_back(var_name);
+        return IROperand::var(static_cast<std::int32_t>(variables.size() - 1));
+    }
+
+    /**
+     * @brief Allocate a fresh temporary.
+     */
+    IROperand new_temp() { return IROperand::temp(temp_count++); }
+
+    /**
+     * @brief Register a string constant and return its STR operand.
+     * @param value String contents.
+     */
+    IROperand add_string(const std::string& value)
+    {
+        strings.push_back(value);
+        return IROperand::str(static_cast<std::int32_t>(strings.size() - 1));
+    }
+
+    /**
+     * @brief Append a new, empty block and return its ID.
+     * @param label Block label.
+     */
+    BlockId add_block(const std::string& label);
+
+    /**
+     * @brief A label built from a prefix that no existing block uses yet.
+     * @param prefix Label prefix, e.g. "split".
+     */
+    std::string new_label(const std::string& prefix) const;
+
+    /**
+     * @brief Delete blocks and renumber the rest.
+     *
+     * Block operands and phi incoming entries are rewritten to the new IDs;
+     * phi entries for deleted predecessors are dropped. Jumps into a deleted
+     * block must already be gone. The entry block cannot be removed.
+     *
+     * @param dead dead[id] is true for every block to delete.
+     */
+    void remove_blocks(const std::vector<bool>& dead);
+
+    /**
+     * @brief Lay the blocks out in a new order and renumber them.
+     *
+     * Block operands and phi incoming entries are rewritten to the new IDs.
+     *
+     * @param order Every block ID exactly once, starting with the entry (0).
+     */
+    void reorder_blocks(const std::vector<BlockId>& order);
+
+    /**
+     * @brief The instructions of a block, in order.
+     */
+    std::span<IRInstruction> block_instructions(BlockId id);
+    std::span<const IRInstruction> block_instructions(BlockId id) const;
+    std::span<const IRInstruction> block_instructions(const BasicBlock& block) const;
+
+    /**
+     * @brief Append an instruction to the end of a block.
+     *
+     * Cheap when the block is the last one in the arena (the IRGenerator case);
+     * otherwise the block is first moved to the end of the arena.
+     */
+    void append(BlockId id, const IRInstruction& instr);
+
+    /**
+     * @brief Replace the contents of a block.
+     *
+     * Shrinking rewrites the block in place; growing moves it to the end of the arena.
+     */
+    void set_block_instructions(BlockId id, const std::vector<IRInstruction>& instrs);
+
+    /**
+     * @brief Re-lay the arena so blocks are contiguous and in block order, dropping stale slots.
+     */
+    void compact();
+
+    /**
+     * @brief The terminator ending a block.
+     *
+     * Only meaningful on well-formed IR (see verify()).
+     */
+    const IRInstruction& terminator(BlockId id) const { return block_instructions(id).back(); }
+    IRInstruction& terminator(BlockId id) { return block_instructions(id).back(); }
+
+    /**
+     * @brief Check structural invariants, throwing std::runtime_error on violation.
+     *
+     * Every block must end in exactly one terminator, conditional jumps need a
+     * condition, and every block operand (including phi predecessors) must
+     * name an existing block.
+     */
+    void verify() const;
+
+    /**
+     * @brief Human-readable spelling of an operand (for dumps, logs and tests).
+     *
+     * Temps print as "tN", variables and blocks by name, immediates as numbers
+     * and strings as "strN". Unused slots print as an empty string.
+     */
+    std::string operand_name(const IROperand& op) const
+    {
+        switch (op.kind)
+        {
+        case IROperandKind::TEMP:
+            return "t" + std::to_string(op.value);
+        case IROperandKind::VAR:
+            return variables.at(op.value);
+        case IROperandKind::IMM:
+            return std::to_string(op.value);
+        case IROperandKind::BLOCK:
+            return blocks.at(op.value).label;
+        case IROperandKind::STR:
+            return "str" + std::to_string(op.value);
+        default:
+            return "";
+        }
     }
 };
 
@@ -71,17 +71,17 @@ public:
 private:
     std::unique_ptr<IRProgram> ir_program_; ///< Owned IRProgram being built
     IRFunction* current_function_ = nullptr; ///< Currently emitting function (non-owning)
-    BasicBlock* current_block_ = nullptr; ///< Currently emitting basic block (non-owning)
+    BlockId current_block_ = 0; ///< Block of current_function_ being emitted into
     int temp_counter_ = 0; ///< Counter to generate unique temporary names
     int label_counter_ = 0; ///< Counter to generate unique labels
-    std::map<std::string, std::string> var_map_; ///< Map from source var name to IR var/temp
+    std::map<std::string, IROperand> var_map_; ///< Map from source var name to IR var/temp
 
     /**
-     * @brief Create a fresh temporary variable name.
+     * @brief Create a fresh temporary.
      *
-     * Returns a unique temporary string (used as result names for instructions).
+     * Returns a unique TEMP operand (used as result of instructions).
      */
-    std::string new_temp();
+    IROperand new_temp();
 
     /**
      * @brief Create a fresh label with the given prefix.
@@ -92,31 +92,49 @@ private:
      */
     std::string new_label(const std::string& prefix);
 
+    /**
+     * @brief Append a new basic block to the current function and make it current.
+     *
+     * @param label Label for the new block.
+     * @return BLOCK operand referring to the new block.
+     */
+    IROperand start_block(const std::string& label);
+
     /**
      * @brief Emit an IR instruction into the current basic block.
      *
      * Convenience helper to append an IRInstruction with the supplied opcode
-     * and operands to the current_block_. If no current block is set, this
-     * function should handle that error state appropriately.
+     * and operands to current_block_ of current_function_. Once the block
+     * holds a terminator, further instructions are unreachable and dropped.
      *
      * @param op Opcode for the instruction.
      * @param res Optional result destination (temp/variable/label).
      * @param op1 Optional first operand.
      * @param op2 Optional second operand.
      */
-    void emit(IROpcode op, const std::string& res = "", const std::string& op1 = "", const std::string& op2 = "");
+    void emit(IROpcode op, IROperand res = {}, IROperand op1 = {}, IROperand op2 = {});
+
+    /**
+     * @brief Fill in the pending target of the jump that ends a block.
+     *
+     * Used for forward jumps emitted before their target block exists. Does
+     * nothing if the block ended in something else (e.g. a return).
+     *
+     * @param from Block whose terminator is patched.
+     * @param target BLOCK operand of the now-existing target.
+     */
+    void patch_jump(BlockId from, IROperand target);
 
     /**
-     * @brief Generate IR for an expression and return its result name.
+     * @brief Generate IR for an expression and return its result operand.
      *
      * Traverses the expression subtree, emits instructions to compute its
-     * value, and returns the name of the temporary or variable holding the
-     * computed value.
+     * value, and returns the temporary or variable holding the computed value.
      *
      * @param expr Expression AST node to translate.
-     * @return Name of the IR temporary or variable that contains the result.
+     * @return IR temporary or variable operand that contains the result.
      */
-    std::string generate_expr(const Expr& expr); // Returns result temp/var
+    IROperand generate_expr(const Expr& expr); // Returns result temp/var
 
     friend class PublicIRGenerator; // Allow testing class to access private members
 };
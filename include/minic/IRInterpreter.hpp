@@ -0,0 +1,64 @@
+#ifndef MINIC_IRINTERPRETER_HPP
+#define MINIC_IRINTERPRETER_HPP
+
+#include "minic/IR.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace minic
+{
+
+/**
+ * @class IRInterpreter
+ * @brief Reference executor for IR functions.
+ *
+ * Runs a function directly on the IR, in or out of SSA form, with the same
+ * 64-bit semantics as the generated code: arithmetic wraps, DIV truncates and
+ * traps on division by zero or overflow, comparisons yield 0 or 1. It exists
+ * so tests (and benchmarks) can check that a pass preserves what a program
+ * computes and measure how many instructions it executes. Since one MUL or
+ * DIV costs far more than an ADD on the target, each run also sums a rough
+ * latency per instruction (see estimated_cycles) and counts the conditional
+ * jumps taken, each of which the target may mispredict.
+ */
+class IRInterpreter
+{
+public:
+    /**
+     * @brief Outcome of one run.
+     */
+    struct Result
+    {
+        std::int64_t value = 0; ///< Returned value (0 for a bare return)
+        std::uint64_t steps = 0; ///< Instructions executed (phis are free)
+        std::uint64_t cycles = 0; ///< Rough x86-64 latency of those instructions
+        std::uint64_t branches = 0; ///< Conditional jumps executed
+    };
+
+    /**
+     * @brief Construct an interpreter.
+     * @param step_limit Maximum instructions per run before giving up.
+     */
+    explicit IRInterpreter(std::uint64_t step_limit = 10000000)
+        : step_limit_(step_limit)
+    {
+    }
+
+    /**
+     * @brief Execute a function.
+     *
+     * Throws std::runtime_error on a trap, a wrong argument count, malformed
+     * IR or when the step limit is exceeded.
+     *
+     * @param func Function to run.
+     * @param args One value per parameter.
+     */
+    Result run(const IRFunction& func, const std::vector<std::int64_t>& args) const;
+
+private:
+    std::uint64_t step_limit_; ///< Maximum instructions per run
+};
+
+} // namespace minic
+
+#endif // MINIC_IRINTERPRETER_HPP
@@ -0,0 +1,46 @@
+#ifndef MINIC_IFCONVERSION_HPP
+#define MINIC_IFCONVERSION_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class IfConversion
+ * @brief Replace small if/else diamonds with straight-line code and SELECTs,
+ * which the code generator emits as cmov, so no branch can be mispredicted.
+ *
+ * A diamond is a block ending in a conditional jump whose two targets each
+ * have that block as their only predecessor, hold only speculatable
+ * instructions (see is_speculatable) and jump to the same join block; one of
+ * the targets may also be the join itself. Both arms are then executed
+ * unconditionally in the branching block. Values an arm writes that are read
+ * outside it go to fresh temps, and one SELECT per such value picks the taken
+ * arm's result. When the join is left with a single predecessor it is merged
+ * in, so nested diamonds convert from the inside out.
+ *
+ * The conversion is only done when it is estimated to be cheaper: both arms
+ * plus the selects, in estimated_cycles, against one arm on average plus half
+ * the mispredict penalty for a branch that goes either way.
+ *
+ * SELECT reads its own result, so the pass only runs out of SSA form.
+ */
+class IfConversion : public IRPass
+{
+public:
+    /**
+     * @param mispredict_penalty Cycles lost when the target mispredicts a branch.
+     */
+    explicit IfConversion(unsigned mispredict_penalty = 16);
+
+    std::string name() const override { return "if-conversion"; }
+    bool run(IRFunction& func) override;
+
+private:
+    unsigned mispredict_penalty_;
+};
+
+} // namespace minic
+
+#endif // MINIC_IFCONVERSION_HPP
@@ -0,0 +1,37 @@
+#ifndef MINIC_INSTCOMBINE_HPP
+#define MINIC_INSTCOMBINE_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class InstCombine
+ * @brief Constant folding and algebraic simplification of single instructions.
+ *
+ * Repeats until nothing changes:
+ *  - operations on immediates fold (see fold_constant), and a temp with a
+ *    single constant definition is replaced by the constant at its uses;
+ *  - identities: x+0, x-0, x*1, x/1 become copies, x*0 becomes 0, 0-x
+ *    becomes NEG x, and x-x, x==x, x<x (etc.) fold to 0 or 1;
+ *  - immediates move to operand2 (swapping comparisons as needed) and x-c
+ *    becomes x+(-c), so constant chains (x+c1)+c2 and (x*c1)*c2 combine;
+ *  - NEG NEG x and NOT of a comparison simplify, and a branch on a constant
+ *    becomes a JUMP.
+ *
+ * Rewrites that look through a definition only use operands that cannot be
+ * redefined in between (immediates, single-definition temps and variables
+ * that are never written), so the pass is valid both in and out of SSA form.
+ * Instructions whose value becomes unused are left for dead code elimination.
+ */
+class InstCombine : public IRPass
+{
+public:
+    std::string name() const override { return "instcombine"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_INSTCOMBINE_HPP
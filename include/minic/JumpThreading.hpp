@@ -0,0 +1,49 @@
+#ifndef MINIC_JUMPTHREADING_HPP
+#define MINIC_JUMPTHREADING_HPP
+
+#include "minic/Pass.hpp"
+#include <cstddef>
+
+namespace minic
+{
+
+/**
+ * @class JumpThreading
+ * @brief Send edges whose branch outcome is known straight to the block the
+ * branch would take, duplicating the block in between.
+ *
+ * For every small block ending in a conditional branch, each incoming edge is
+ * checked for a condition that is decided when control arrives along it. The
+ * block's instructions are evaluated with its phis replaced by the values that
+ * flow in from the predecessor, so a flag set to 1 on one side of an if and to
+ * 0 on the other is a constant on each edge. Walking up from the predecessor
+ * through blocks with a single predecessor collects the outcomes of the
+ * branches on the way; a condition tested there again, or a comparison of the
+ * same operands (`x < 5` after `x >= 5` was false), is decided too.
+ *
+ * The block is then cloned for that edge with its branch replaced by a jump,
+ * and the predecessor jumps to the clone instead. The clone keeps the
+ * original temps; SSAConstruction then repairs SSA form. Loop headers are
+ * never threaded, so loops keep a single entry.
+ *
+ * Blocks are cloned for as long as they add up to no more than the budget in
+ * instructions in one run.
+ */
+class JumpThreading : public IRPass
+{
+public:
+    /**
+     * @param budget Number of instructions the clones may add to a function in one run.
+     */
+    explicit JumpThreading(size_t budget = 64);
+
+    std::string name() const override { return "jump-threading"; }
+    bool run(IRFunction& func) override;
+
+private:
+    size_t budget_;
+};
+
+} // namespace minic
+
+#endif // MINIC_JUMPTHREADING_HPP
@@ -0,0 +1,35 @@
+#ifndef MINIC_LICM_HPP
+#define MINIC_LICM_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class LICM
+ * @brief Loop-invariant code motion: hoist invariant computations into loop preheaders.
+ *
+ * Every loop first gets a preheader (see ensure_preheader). Then, innermost
+ * loops first, an instruction in the loop is hoisted to the end of the
+ * preheader when
+ *  - it computes a value without side effects and cannot trap (a division
+ *    only by an immediate other than 0 and -1), so executing it even when
+ *    the loop body would not have is harmless;
+ *  - its result is a temp with a single definition; and
+ *  - each operand is an immediate, a variable the loop never writes, or a
+ *    single-definition temp defined outside the loop or by a hoisted instruction.
+ * Blocks are visited in reverse postorder so chains of invariant instructions
+ * move together, and a value hoisted out of an inner loop can move on out of
+ * the enclosing one.
+ */
+class LICM : public IRPass
+{
+public:
+    std::string name() const override { return "licm"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_LICM_HPP
@@ -0,0 +1,32 @@
+#ifndef MINIC_LSR_HPP
+#define MINIC_LSR_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class LoopStrengthReduction
+ * @brief Replace multiplications of induction variables with additions, and
+ * drop induction variables that duplicate another one.
+ *
+ * Works on loops in SSA form that find_induction_variables can analyze. For a
+ * basic induction variable i (starting at a, growing by c) and an instruction
+ * `t = MUL i, s` in the loop with s invariant, a new header phi p is added that
+ * starts at a * s (computed in the preheader) and grows by c * s at the end of
+ * the latch; the multiplication becomes `t = ASSIGN p`. Uses of the same i and
+ * s share one p. An induction variable with the same step as an earlier one
+ * whose start differs from it by a constant is rewritten as `ADD` of that
+ * earlier variable at the top of the header, removing its phi.
+ */
+class LoopStrengthReduction : public IRPass
+{
+public:
+    std::string name() const override { return "lsr"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_LSR_HPP
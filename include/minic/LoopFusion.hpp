@@ -0,0 +1,42 @@
+#ifndef MINIC_LOOPFUSION_HPP
+#define MINIC_LOOPFUSION_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class LoopFusion
+ * @brief Merge a loop into the loop right before it when both run the same
+ * number of times and the second does not read what the first computes.
+ *
+ * Two loops are adjacent when the first one's exit block is the second one's
+ * preheader. Each must be in SSA form and tested at the top: one latch ending
+ * in a jump, a header that branches into a body block with no other
+ * predecessor or out to an exit only it reaches. They are fused when:
+ *  - their exit tests (ScalarEvolution::loop_test) compare counters with the
+ *    same start and step against the same bound with the same comparison, so
+ *    they decide the same way in every iteration;
+ *  - the block between them only holds speculatable instructions that read
+ *    nothing from the first loop, and the second header's instructions are
+ *    speculatable;
+ *  - no instruction or phi of the second loop reads a value the first loop
+ *    defines. With scalars in SSA form that is the only way one body could
+ *    depend on the other.
+ *
+ * The block between the loops moves into the first preheader, the second
+ * header's phis and instructions join the first header, and the second body
+ * runs after the first one in each iteration. Its exit test is left to dead
+ * code elimination.
+ */
+class LoopFusion : public IRPass
+{
+public:
+    std::string name() const override { return "fuse"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_LOOPFUSION_HPP
@@ -0,0 +1,47 @@
+#ifndef MINIC_LOOPROTATION_HPP
+#define MINIC_LOOPROTATION_HPP
+
+#include "minic/Pass.hpp"
+#include <cstddef>
+
+namespace minic
+{
+
+/**
+ * @class LoopRotation
+ * @brief Turn loops that test at the top into guarded loops that test at the bottom.
+ *
+ * A while loop runs its header's test and then, at the end of the body, an
+ * unconditional jump back to it: two branches per iteration. Rotation copies
+ * the header's instructions and branch into the preheader, where they decide
+ * whether the loop is entered at all, and into the latch, which then branches
+ * back to the body or leaves the loop itself. The old header disappears and the
+ * first block of the body becomes the new header, with phis merging what the
+ * guard and the latch computed; the exit gets phis for the values used after
+ * the loop. The same instructions run in the same order as before, so the
+ * header may contain anything.
+ *
+ * A loop qualifies when it is in SSA form with a preheader, one latch ending
+ * in a jump, a header that ends in a conditional branch into a body block with
+ * no other predecessor, and a single exit that only the header branches to.
+ * An exit that blocks outside the loop also reach gets a new block in
+ * between first, so it has the two predecessors its phis expect.
+ */
+class LoopRotation : public IRPass
+{
+public:
+    /**
+     * @param max_header Largest number of header instructions (besides the branch) worth copying.
+     */
+    explicit LoopRotation(size_t max_header = 16);
+
+    std::string name() const override { return "rotate"; }
+    bool run(IRFunction& func) override;
+
+private:
+    size_t max_header_;
+};
+
+} // namespace minic
+
+#endif // MINIC_LOOPROTATION_HPP
@@ -0,0 +1,53 @@
+#ifndef MINIC_LOOPUNROLL_HPP
+#define MINIC_LOOPUNROLL_HPP
+
+#include "minic/Pass.hpp"
+#include <cstddef>
+
+namespace minic
+{
+
+/**
+ * @class LoopUnroll
+ * @brief Unroll innermost loops, fully when the trip count is a small constant
+ * and by a factor with the original loop as remainder otherwise.
+ *
+ * A loop qualifies when it is innermost, is in SSA form with a preheader and a
+ * single latch ending in a jump, and is left only from its header to an exit
+ * with no other predecessor. Its size is the number of instructions in its blocks.
+ *
+ * With a constant trip count k and k * size within the budget the loop is
+ * replaced by k copies of its body, each preceded by a copy of the header's
+ * instructions (the test itself is dropped), plus a last header copy for the
+ * values the exit reads.
+ *
+ * Otherwise, when the header's exit test counts towards a bound (see
+ * ScalarEvolution::loop_test: `<` or `<=` stepping up, `>` or `>=` stepping
+ * down), an unrolled loop runs in front of the original one. Its header checks
+ * that the next factor iterations all pass the original test by comparing with
+ * the bound moved factor - 1 steps closer, and its body chains factor copies
+ * without tests in between. When that check fails the original loop takes
+ * over and finishes the remaining iterations. A bound that is not an immediate
+ * is first checked in the preheader for room to move it without wrapping. The
+ * factor shrinks until factor * size fits the budget; below 2 nothing is done.
+ */
+class LoopUnroll : public IRPass
+{
+public:
+    /**
+     * @param factor Number of iterations per trip around an unrolled loop.
+     * @param budget Instruction count the copies of one loop may take up.
+     */
+    explicit LoopUnroll(int factor = 4, size_t budget = 64);
+
+    std::string name() const override { return "unroll"; }
+    bool run(IRFunction& func) override;
+
+private:
+    int factor_;
+    size_t budget_;
+};
+
+} // namespace minic
+
+#endif // MINIC_LOOPUNROLL_HPP
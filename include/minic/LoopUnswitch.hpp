@@ -0,0 +1,43 @@
+#ifndef MINIC_LOOPUNSWITCH_HPP
+#define MINIC_LOOPUNSWITCH_HPP
+
+#include "minic/Pass.hpp"
+#include <cstddef>
+
+namespace minic
+{
+
+/**
+ * @class LoopUnswitch
+ * @brief Move branches on loop-invariant conditions out of loops by keeping a
+ * copy of the loop for each outcome.
+ *
+ * A conditional branch inside a loop qualifies when both its targets are in
+ * the loop and its condition is an immediate, a parameter, or a temp defined
+ * outside the loop (LICM has usually moved the comparison out by now). The
+ * loop's blocks are cloned, the preheader branches on the condition to the
+ * original loop or the clone, and in each the branch becomes a jump to the
+ * target its outcome takes. Clones keep the original temps; SSAConstruction
+ * then repairs SSA form, merging the two versions' values where the loops exit.
+ *
+ * Loops are tried innermost first, one branch at a time, for as long as the
+ * loops cloned in one run add up to no more than the budget in instructions.
+ */
+class LoopUnswitch : public IRPass
+{
+public:
+    /**
+     * @param budget Number of instructions the clones may add to a function in one run.
+     */
+    explicit LoopUnswitch(size_t budget = 64);
+
+    std::string name() const override { return "unswitch"; }
+    bool run(IRFunction& func) override;
+
+private:
+    size_t budget_;
+};
+
+} // namespace minic
+
+#endif // MINIC_LOOPUNSWITCH_HPP
@@ -0,0 +1,104 @@
+#ifndef MINIC_LOOPS_HPP
+#define MINIC_LOOPS_HPP
+
+#include "minic/CFG.hpp"
+#include <vector>
+
+namespace minic
+{
+
+/**
+ * @struct Loop
+ * @brief A natural loop: a header plus every block that reaches one of its back edges.
+ */
+struct Loop
+{
+    BlockId header; ///< The single entry block; it dominates the whole loop
+    std::vector<BlockId> blocks; ///< Blocks of the loop (header included), sorted by BlockId
+    std::vector<BlockId> latches; ///< Blocks in the loop with an edge back to the header
+    std::vector<BlockId> exits; ///< Blocks outside the loop with a predecessor inside it
+    int parent = -1; ///< Index of the innermost enclosing loop in LoopInfo::loops(), -1 if outermost
+    int depth = 1; ///< Nesting depth, 1 for an outermost loop
+
+    /**
+     * @brief Whether a block belongs to the loop (or to a loop nested in it).
+     */
+    bool contains(BlockId id) const;
+};
+
+/**
+ * @class LoopInfo
+ * @brief The natural loops of a function and how they nest.
+ *
+ * A back edge is an edge u -> h where h dominates u; all back edges into the
+ * same header form one loop. Retreating edges into a block that does not
+ * dominate their source (irreducible control flow) form no loop. Like the
+ * ControlFlowGraph it is built from, this is a snapshot.
+ */
+class LoopInfo
+{
+public:
+    /**
+     * @brief Find the loops of the function the graph was built for.
+     */
+    explicit LoopInfo(const ControlFlowGraph& cfg);
+
+    /**
+     * @brief All loops, with every loop listed before the loops nested in it.
+     */
+    const std::vector<Loop>& loops() const { return loops_; }
+
+    /**
+     * @brief Index of the innermost loop containing a block, or -1.
+     */
+    int loop_of(BlockId id) const { return loop_of_[id]; }
+
+private:
+    std::vector<Loop> loops_;
+    std::vector<int> loop_of_;
+};
+
+/**
+ * @brief Give a loop a preheader: a block outside the loop whose only successor
+ * is the header and which is the header's only predecessor outside the loop.
+ *
+ * If an existing block already qualifies it is returned; otherwise a new block
+ * is added at the end of the function, every entering edge is redirected to it,
+ * and header phi entries from outside the loop are merged (with a new phi in the
+ * preheader where they differ). Invalidates any ControlFlowGraph of the function.
+ *
+ * @return The preheader's BlockId, or -1 if nothing enters the loop from
+ *         outside (its header is the entry block).
+ */
+BlockId ensure_preheader(IRFunction& func, const ControlFlowGraph& cfg, const Loop& loop);
+
+/**
+ * @brief Give every loop of the function a preheader.
+ * @return Whether any block was added.
+ */
+bool ensure_preheaders(IRFunction& func);
+
+/**
+ * @struct InductionVariable
+ * @brief A basic induction variable: a header phi that grows by a constant each iteration.
+ */
+struct InductionVariable
+{
+    IROperand phi; ///< Header phi: the value at the start of each iteration
+    IROperand init; ///< Value entering from outside the loop
+    IROperand next; ///< Temp defined as phi + step, fed back by the latch
+    std::int32_t step; ///< Amount added per iteration
+};
+
+/**
+ * @brief The basic induction variables of a loop in SSA form.
+ *
+ * Only loops with a single latch and a single entering edge are analyzed; a
+ * header phi qualifies when the latch feeds back a temp defined in the loop as
+ * `ADD phi, c` (or `SUB phi, -c`) with an immediate c.
+ */
+std::vector<InductionVariable> find_induction_variables(const IRFunction& func, const ControlFlowGraph& cfg, const Loop& loop);
+
+} // namespace minic
+
+#endif // MINIC_LOOPS_HPP
@@ -0,0 +1,40 @@
+#ifndef MINIC_PRE_HPP
+#define MINIC_PRE_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class PartialRedundancyElimination
+ * @brief Remove computations that are redundant on some paths by lazy code
+ * motion (Knoop, Rüthing and Steffen).
+ *
+ * Expressions are an opcode over the same operands, so in SSA form an
+ * expression is killed only in the blocks that define one of its operands.
+ * For each expression computed more than once, the classic four dataflow
+ * problems run over the CFG, with a node of its own for every critical edge:
+ * anticipation and availability give the earliest points the value can be
+ * computed without computing it on a path that did not before, postponing
+ * moves those points as late as possible, and a liveness problem drops the
+ * ones nothing reads. Computing as late as possible keeps the new temp's live
+ * range, and so register pressure, as short as it can be.
+ *
+ * The expression is computed into a fresh temp at the chosen points (critical
+ * edges are split where one of them lies on one), and the original
+ * computations that the temp now reaches become copies of it. The temp is
+ * defined once per point; SSAConstruction then merges the definitions with
+ * phis. Only expressions safe to compute speculatively are moved. Only valid
+ * in SSA form.
+ */
+class PartialRedundancyElimination : public IRPass
+{
+public:
+    std::string name() const override { return "pre"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_PRE_HPP
@@ -0,0 +1,86 @@
+#ifndef MINIC_PASS_HPP
+#define MINIC_PASS_HPP
+
+#include "minic/IR.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace minic
+{
+
+/**
+ * @class IRPass
+ * @brief Interface for a transformation (or analysis-driven rewrite) over one IRFunction.
+ *
+ * Passes receive well-formed IR and must leave it well formed. A pass reports
+ * whether it changed anything so the PassManager can skip re-verification and
+ * iterate pipelines to a fixed point.
+ */
+class IRPass
+{
+public:
+    /**
+     * @brief Virtual destructor.
+     */
+    virtual ~IRPass() = default;
+
+    /**
+     * @brief Short name used in logs.
+     */
+    virtual std::string name() const = 0;
+
+    /**
+     * @brief Run the pass over a function.
+     * @param func Function to transform in place.
+     * @return True if the function was modified.
+     */
+    virtual bool run(IRFunction& func) = 0;
+};
+
+/**
+ * @class PassManager
+ * @brief Runs an ordered pipeline of IRPass objects over every function of a program.
+ *
+ * After a pass changes a function, the arena is compacted and the function is
+ * re-verified, so a broken pass is reported by name instead of surfacing as bad
+ * assembly later.
+ */
+class PassManager
+{
+public:
+    /**
+     * @brief Create an empty pipeline.
+     *
+     * @param verbose Log every pass that changes a function to std::cerr.
+     */
+    explicit PassManager(bool verbose = false)
+        : verbose_(verbose)
+    {
+    }
+
+    /**
+     * @brief Append a pass to the pipeline.
+     */
+    void add(std::unique_ptr<IRPass> pass);
+
+    /**
+     * @brief Run the pipeline over one function.
+     * @return True if any pass changed it.
+     */
+    bool run(IRFunction& func);
+
+    /**
+     * @brief Run the pipeline over every function of a program.
+     * @return True if any function changed.
+     */
+    bool run(IRProgram& program);
+
+private:
+    std::vector<std::unique_ptr<IRPass>> passes_; ///< Pipeline in execution order
+    bool verbose_; ///< Whether changes are logged
+};
+
+} // namespace minic
+
+#endif // MINIC_PASS_HPP
@@ -0,0 +1,35 @@
+#ifndef MINIC_SCCP_HPP
+#define MINIC_SCCP_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class SCCP
+ * @brief Sparse conditional constant propagation (Wegman-Zadeck).
+ *
+ * Every temp starts out "undefined" and is only lowered to a constant or to
+ * "overdefined" once its definition is reached, and a block is only analyzed
+ * once some executable edge leads into it. A branch on a constant therefore
+ * never makes its other side executable, so values that differ only on dead
+ * paths (a phi merging 1 with a value from an `if (0)` arm, a loop variable
+ * multiplied by 1) are still found to be constant.
+ *
+ * Afterwards constant temps are replaced by immediates at their uses, branches
+ * with a single executable successor become JUMPs and blocks that were never
+ * executable are deleted. Temps with more than one definition, variables and
+ * strings are always overdefined, so the pass is valid outside SSA form too,
+ * but it finds the most in SSA form.
+ */
+class SCCP : public IRPass
+{
+public:
+    std::string name() const override { return "sccp"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_SCCP_HPP
@@ -0,0 +1,58 @@
+#ifndef MINIC_SSA_HPP
+#define MINIC_SSA_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class SSAConstruction
+ * @brief Put a function into SSA form (the classic "mem2reg" transformation).
+ *
+ * Source variables are mutable slots in the IR produced by IRGenerator. This
+ * pass removes unreachable blocks, places phi nodes at the iterated dominance
+ * frontier of each slot's definitions (semi-pruned: only slots live across a
+ * block boundary get phis) and renames every definition to a fresh temp by
+ * walking the dominator tree. Plain copies into a slot disappear: later reads
+ * use the copied value directly.
+ *
+ * In SSA form every temp has exactly one definition (an instruction or a phi)
+ * that dominates its uses, nothing writes a VAR, and a VAR operand only
+ * appears as a read of a parameter's incoming value. Reads of a variable
+ * before any assignment become the immediate 0.
+ *
+ * Temps with more than one definition are treated as slots too, so running the
+ * pass again repairs SSA after a transformation that duplicated definitions
+ * (or after SSADestruction). A function containing a SELECT is rejected with
+ * std::runtime_error, since a SELECT reads the result it writes.
+ */
+class SSAConstruction : public IRPass
+{
+public:
+    std::string name() const override { return "ssa-construction"; }
+    bool run(IRFunction& func) override;
+};
+
+/**
+ * @class SSADestruction
+ * @brief Take a function out of SSA form by replacing phis with copies.
+ *
+ * Edges from a block ending in a conditional branch into a block with phis are
+ * split first, so each predecessor of a phi block jumps unconditionally to it.
+ * Back edges are the exception when nothing on the branch's other way reads the
+ * phis' results: their copies can run before the branch, and a loop that tests
+ * at the bottom keeps one conditional jump per iteration. The phis of a block
+ * then become one parallel copy at the end of every predecessor, sequentialized
+ * so swaps and cycles get a scratch temp.
+ */
+class SSADestruction : public IRPass
+{
+public:
+    std::string name() const override { return "ssa-destruction"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_SSA_HPP
@@ -0,0 +1,147 @@
+#ifndef MINIC_SCALAREVOLUTION_HPP
+#define MINIC_SCALAREVOLUTION_HPP
+
+#include "minic/Loops.hpp"
+#include "minic/Pass.hpp"
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace minic
+{
+
+/**
+ * @struct Recurrence
+ * @brief A value as a polynomial in the iteration number k of a loop (k = 0 on entry).
+ *
+ * The value in iteration k is coeffs[0] + coeffs[1] * k + coeffs[2] * k(k-1)/2,
+ * the chain of recurrences {c0, +, c1, +, c2}: c0 to start with, growing by c1
+ * and then by c2 more each iteration. Every coefficient is an immediate or a
+ * value that does not change in the loop.
+ */
+struct Recurrence
+{
+    std::array<IROperand, 3> coeffs { IROperand::imm(0), IROperand::imm(0), IROperand::imm(0) };
+
+    /**
+     * @brief Index of the last nonzero coefficient (0 for a loop-invariant value).
+     */
+    int degree() const;
+};
+
+/**
+ * @struct LoopTest
+ * @brief A loop's exit test in the form "the loop runs while value op bound".
+ */
+struct LoopTest
+{
+    IROperand value; ///< Header value compared each iteration, a recurrence of degree 1
+    IROpcode op; ///< Comparison that holds while the loop keeps running
+    IROperand bound; ///< Loop-invariant side of the comparison, as computed outside the loop (maybe by code())
+    Recurrence rec; ///< Recurrence of value; its step coeffs[1] is an immediate
+};
+
+/**
+ * @class ScalarEvolution
+ * @brief Recurrences and the trip count of one loop in SSA form.
+ *
+ * Header phis are solved when the latch feeds back the phi plus a value of
+ * degree at most 1, and instructions in the loop when they add, subtract,
+ * negate, copy or multiply values with recurrences, as long as the result stays
+ * within degree 2. Coefficients that need computing (a product of two
+ * parameters, say) get new temps whose instructions are collected in code();
+ * they only read values from outside the loop, so they can be placed anywhere
+ * those are available. Like the ControlFlowGraph, it is a snapshot.
+ */
+class ScalarEvolution
+{
+public:
+    /**
+     * @brief Prepare to analyze a loop of the function; new temps are taken from func.
+     */
+    ScalarEvolution(IRFunction& func, const Loop& loop);
+
+    /**
+     * @brief The recurrence of a value in the loop, or std::nullopt if it has none.
+     */
+    std::optional<Recurrence> recurrence(const IROperand& value);
+
+    /**
+     * @brief The header's exit test, if it compares a recurrence of degree 1
+     * with a constant step against a loop-invariant bound.
+     */
+    std::optional<LoopTest> loop_test();
+
+    /**
+     * @brief How many times the body runs, if the header's branch allows knowing.
+     *
+     * Requires a loop_test(). With constant start and bound the count is exact (and an imm32); with a
+     * varying start or bound only steps of 1 towards a strict bound (`i < n`,
+     * `i > n` counting down) are handled, and the count is only meaningful
+     * when the loop is entered at all. Loops whose counter would wrap are rejected.
+     */
+    std::optional<IROperand> trip_count();
+
+    /**
+     * @brief Operand holding a recurrence's value in iteration k.
+     */
+    IROperand evaluate(const Recurrence& rec, const IROperand& k);
+
+    /**
+     * @brief Instructions computing the temps created so far, in order.
+     */
+    const std::vector<IRInstruction>& code() const { return code_; }
+
+private:
+    /**
+     * @brief A recurrence plus `self` times the phi being solved.
+     */
+    struct Term
+    {
+        int self;
+        Recurrence rec;
+    };
+
+    std::optional<Term> analyze(const IROperand& op);
+    std::optional<Term> analyze_instruction(const IRInstruction& instr);
+    std::optional<Term> solve_phi(const PhiNode& phi);
+    bool invariant(const IROperand& op) const;
+
+    IROperand compute(IROpcode op, const IROperand& a, const IROperand& b);
+    IROperand add(const IROperand& a, const IROperand& b);
+    IROperand sub(const IROperand& a, const IROperand& b);
+    IROperand mul(const IROperand& a, const IROperand& b);
+
+    IRFunction& func_;
+    const Loop& loop_;
+    std::vector<BlockId> def_block_;
+    std::vector<const IRInstruction*> def_;
+    std::vector<bool> var_written_;
+    std::vector<std::optional<Recurrence>> cache_;
+    std::vector<bool> in_progress_;
+    IROperand solving_;
+    std::vector<IRInstruction> code_;
+};
+
+/**
+ * @class LoopFolding
+ * @brief Replace loops that only compute values by the closed form of those values.
+ *
+ * A loop qualifies when it has one latch, leaves only from its header to an
+ * exit block with no other predecessor, contains nothing but speculatable
+ * instructions and branches, has a trip count, and every value it defines that
+ * is used after it has a recurrence. The header stays, so the loop condition
+ * is still tested once; where the loop used to be entered, a new block now
+ * evaluates the recurrences at the trip count and jumps to the exit, where
+ * phis merge those values with the ones from the header.
+ */
+class LoopFolding : public IRPass
+{
+public:
+    std::string name() const override { return "loopfold"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_SCALAREVOLUTION_HPP
@@ -0,0 +1,37 @@
+#ifndef MINIC_SIMPLIFYCFG_HPP
+#define MINIC_SIMPLIFYCFG_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class SimplifyCFG
+ * @brief Remove blocks that only jump elsewhere, merge straight-line chains
+ * of blocks and delete unreachable ones.
+ *
+ * The following rewrites repeat, re-reading the control flow graph after
+ * each, until none applies:
+ *  - blocks the entry cannot reach are deleted;
+ *  - a conditional jump whose two targets are the same block becomes a JUMP;
+ *  - every jump into a block that holds nothing but a JUMP (other than the
+ *    entry and a block jumping to itself) is retargeted past it; when the
+ *    final target has phis, the jumping block gets the phi entries of the
+ *    block it skips, unless it already reaches the target another way, in
+ *    which case that jump keeps going through the empty block;
+ *  - a block whose only predecessor ends in a JUMP to it is appended to that
+ *    predecessor; its phis, which have a single entry, become copies.
+ *
+ * Works both in and out of SSA form.
+ */
+class SimplifyCFG : public IRPass
+{
+public:
+    std::string name() const override { return "simplify-cfg"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_SIMPLIFYCFG_HPP
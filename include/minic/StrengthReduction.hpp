@@ -0,0 +1,61 @@
+#ifndef MINIC_STRENGTHREDUCTION_HPP
+#define MINIC_STRENGTHREDUCTION_HPP
+
+#include "minic/Pass.hpp"
+#include <cstdint>
+
+namespace minic
+{
+
+/**
+ * @brief Multiplier and shift that turn a signed division by a constant into a
+ * multiplication: x / d is the high half of x * multiplier, corrected by x when
+ * the multiplier's sign differs from d's, shifted right by shift, plus one when
+ * that is negative.
+ */
+struct DivisionMagic
+{
+    std::int64_t multiplier;
+    int shift;
+};
+
+/**
+ * @brief Compute the magic numbers for a 64-bit signed division by d
+ * (Hacker's Delight, 10-1). d must not be -1, 0 or 1.
+ */
+DivisionMagic division_magic(std::int64_t d);
+
+/**
+ * @class StrengthReduction
+ * @brief Replace multiplications and divisions by constants with shifts,
+ * additions and multiply-high sequences.
+ *
+ * For `MUL x, c` (the constant may be either operand):
+ *  - c = -1 becomes NEG, c = 2^k a SHL, c = -2^k a SHL and a NEG;
+ *  - c = 2^k + 1 and c = 2^k - 1 become a SHL and an ADD or SUB, and
+ *    c = -(2^k - 1) a SHL subtracted from x;
+ *  - c = 3, 5 or 9 times 2^k becomes a MUL by 3, 5 or 9 (a single lea in the
+ *    code generator) and a SHL; 3, 5 and 9 themselves stay as they are.
+ * Other factors keep their imul, which beats three or more simple instructions.
+ *
+ * For `DIV x, d` with an immediate d other than -1, 0 and 1 (which trap or
+ * are InstCombine's business), the quotient is computed without idiv: for
+ * d = ±2^k a negative x is biased by 2^k - 1 before an arithmetic shift, so it
+ * rounds toward zero; for other d, MULH by the division_magic multiplier and
+ * shifts give the exact quotient for every 64-bit x. Multipliers that do not
+ * fit an immediate are built once at the top of the entry block and shared by
+ * every division by the same d.
+ *
+ * Runs late, after the loop passes that look for MUL (LoopStrengthReduction,
+ * ScalarEvolution) are done with them.
+ */
+class StrengthReduction : public IRPass
+{
+public:
+    std::string name() const override { return "strength"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_STRENGTHREDUCTION_HPP
@@ -0,0 +1,42 @@
+#ifndef MINIC_VRP_HPP
+#define MINIC_VRP_HPP
+
+#include "minic/Pass.hpp"
+
+namespace minic
+{
+
+/**
+ * @class ValueRangePropagation
+ * @brief Fold comparisons and branches whose outcome follows from the ranges
+ * values can take.
+ *
+ * Every single-definition temp and every variable that is never written (the
+ * parameters, in SSA form) gets an interval of 64-bit values it may hold. The
+ * analysis is optimistic like SCCP: intervals start empty and blocks
+ * unreachable until an executable edge leads into them, and a branch whose
+ * condition is known to be zero or non-zero only marks the edge it takes.
+ *
+ * Intervals are narrowed along conditional edges. A block with a single
+ * predecessor that ends in `JUMPIF c` knows that c is non-zero (or zero), and
+ * when c is a comparison `a < b`, that a is below the largest b and b above
+ * the smallest a; these facts hold in every block the edge dominates, and on
+ * the edge itself they narrow the value a phi receives. A loop phi whose
+ * interval keeps growing is widened to the end of the 64-bit range after a
+ * few rounds, so the analysis terminates. Arithmetic that may overflow gives
+ * the full range.
+ *
+ * Afterwards comparisons and NOTs with a known result become `ASSIGN t, 0/1`,
+ * branches with a single executable successor become JUMPs, and blocks that
+ * never became executable are removed. Only valid in SSA form.
+ */
+class ValueRangePropagation : public IRPass
+{
+public:
+    std::string name() const override { return "vrp"; }
+    bool run(IRFunction& func) override;
+};
+
+} // namespace minic
+
+#endif // MINIC_VRP_HPP
@@ -0,0 +1,99 @@
+#include "minic/BlockLayout.hpp"
+#include "minic/Loops.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace minic
+{
+
+bool BlockLayout::run(IRFunction& func)
+{
+    if (func.blocks.size() < 2)
+        return false;
+
+    ControlFlowGraph cfg(func);
+    LoopInfo loops(cfg);
+    std::vector<bool> placed(func.blocks.size(), false);
+    std::vector<BlockId> order;
+
+    // Whether a successor stays inside the innermost loop around a block.
+    auto stays_in_loop = [&](BlockId from, BlockId to) {
+        int loop = loops.loop_of(from);
+        return loop < 0 || loops.loops()[loop].contains(to);
+    };
+    // Whether every block of the innermost loop around a block is placed.
+    auto loop_done = [&](BlockId id) {
+        int loop = loops.loop_of(id);
+        return loop < 0 || std::ranges::all_of(loops.loops()[loop].blocks, [&](BlockId b) { return placed[b]; });
+    };
+    // Whether every predecessor of a block, other than through a back edge, is placed.
+    auto ready = [&](BlockId id) {
+        return std::ranges::all_of(cfg.predecessors(id), [&](BlockId pred) { return placed[pred] || !cfg.reachable(pred) || cfg.dominates(id, pred); });
+    };
+    // The successor a block should fall through to, or -1. A join waits for
+    // all its predecessors, and nothing leaves a loop before the loop is placed.
+    auto next_of = [&](BlockId id) {
+        const IRInstruction& term = func.terminator(id);
+        std::vector<IROperand> targets;
+        if (term.opcode == IROpcode::JUMP)
+            targets = { term.operand1 };
+        else if (term.opcode == IROpcode::JUMPIF || term.opcode == IROpcode::JUMPIFNOT)
+            targets = { term.result, term.operand2 };
+        BlockId best = -1;
+        for (const IROperand& target : targets)
+        {
+            BlockId to = target.value;
+            if (to == 0 || placed[to] || !ready(to) || (!stays_in_loop(id, to) && !loop_done(id)))
+                continue;
+            if (best < 0 || (stays_in_loop(id, to) && !stays_in_loop(id, best)))
+                best = to;
+        }
+        return best;
+    };
+
+    const auto& rpo = cfg.reverse_postorder();
+    for (BlockId seed = 0; seed >= 0;)
+    {
+        BlockId last = seed;
+        for (BlockId id = seed; id >= 0; id = next_of(id))
+        {
+            placed[id] = true;
+            order.push_back(id);
+            last = id;
+        }
+
+        // Finish the innermost loop around the chain's end before leaving it.
+        seed = -1;
+        for (int loop = loops.loop_of(last); loop >= 0 && seed < 0; loop = loops.loops()[loop].parent)
+        {
+            for (BlockId id : rpo)
+            {
+                if (!placed[id] && loops.loops()[loop].contains(id))
+                {
+                    seed = id;
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < rpo.size() && seed < 0; ++i)
+        {
+            if (!placed[rpo[i]])
+                seed = rpo[i];
+        }
+    }
+    // Unreachable blocks keep their relative order at the end.
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (!placed[id])
+            order.push_back(id);
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < order.size(); ++i)
+        changed = changed || order[i] != static_cast<BlockId>(i);
+    if (changed)
+        func.reorder_blocks(order);
+    return changed;
+}
+
+} // namespace minic
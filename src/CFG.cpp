@@ -0,0 +1,211 @@
+#include "minic/CFG.hpp"
+#include <algorithm>
+
+namespace minic
+{
+
+ControlFlowGraph::ControlFlowGraph(const IRFunction& func)
+    : succs_(func.blocks.size())
+    , preds_(func.blocks.size())
+{
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        for (const auto& target : func.terminator(id).targets())
+        {
+            std::vector<BlockId>& succs = succs_[id];
+            if (std::find(succs.begin(), succs.end(), target.value) == succs.end())
+                succs.push_back(target.value);
+        }
+    }
+    for (BlockId id = 0; id < static_cast<BlockId>(succs_.size()); ++id)
+    {
+        for (BlockId succ : succs_[id])
+            preds_[succ].push_back(id);
+    }
+}
+
+const std::vector<BlockId>& ControlFlowGraph::reverse_postorder() const
+{
+    compute_rpo();
+    return rpo_;
+}
+
+int ControlFlowGraph::rpo_index(BlockId id) const
+{
+    compute_rpo();
+    return rpo_index_[id];
+}
+
+BlockId ControlFlowGraph::idom(BlockId id) const
+{
+    compute_dominators();
+    return idom_[id];
+}
+
+const std::vector<BlockId>& ControlFlowGraph::dom_children(BlockId id) const
+{
+    compute_dominators();
+    return dom_children_[id];
+}
+
+bool ControlFlowGraph::dominates(BlockId a, BlockId b) const
+{
+    compute_dominators();
+    if (idom_[a] < 0 || idom_[b] < 0)
+        return false;
+    return dom_pre_[a] <= dom_pre_[b] && dom_post_[b] <= dom_post_[a];
+}
+
+const std::vector<BlockId>& ControlFlowGraph::dominance_frontier(BlockId id) const
+{
+    compute_frontiers();
+    return df_[id];
+}
+
+void ControlFlowGraph::compute_rpo() const
+{
+    if (rpo_valid_)
+        return;
+    rpo_valid_ = true;
+    rpo_.clear();
+    rpo_index_.assign(size(), -1);
+    if (size() == 0)
+        return;
+
+    // Iterative DFS from the entry; a block is emitted once all its successors are done.
+    std::vector<BlockId> postorder;
+    std::vector<bool> visited(size(), false);
+    std::vector<std::pair<BlockId, size_t>> stack;
+    stack.emplace_back(0, 0);
+    visited[0] = true;
+    while (!stack.empty())
+    {
+        auto& [block, next] = stack.back();
+        if (next < succs_[block].size())
+        {
+            BlockId succ = succs_[block][next++];
+            if (!visited[succ])
+            {
+                visited[succ] = true;
+                stack.emplace_back(succ, 0);
+            }
+        }
+        else
+        {
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+    }
+
+    rpo_.assign(postorder.rbegin(), postorder.rend());
+    for (size_t i = 0; i < rpo_.size(); ++i)
+        rpo_index_[rpo_[i]] = static_cast<int>(i);
+}
+
+void ControlFlowGraph::compute_dominators() const
+{
+    if (dom_valid_)
+        return;
+    dom_valid_ = true;
+    compute_rpo();
+    idom_.assign(size(), -1);
+    dom_children_.assign(size(), {});
+    dom_pre_.assign(size(), -1);
+    dom_post_.assign(size(), -1);
+    if (rpo_.empty())
+        return;
+
+    // Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm".
+    auto intersect = [&](BlockId a, BlockId b) {
+        while (a != b)
+        {
+            while (rpo_index_[a] > rpo_index_[b])
+                a = idom_[a];
+            while (rpo_index_[b] > rpo_index_[a])
+                b = idom_[b];
+        }
+        return a;
+    };
+
+    idom_[0] = 0;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 1; i < rpo_.size(); ++i)
+        {
+            BlockId block = rpo_[i];
+            BlockId new_idom = -1;
+            for (BlockId pred : preds_[block])
+            {
+                if (idom_[pred] < 0)
+                    continue;
+                new_idom = new_idom < 0 ? pred : intersect(pred, new_idom);
+            }
+            if (idom_[block] != new_idom)
+            {
+                idom_[block] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    for (size_t i = 1; i < rpo_.size(); ++i)
+        dom_children_[idom_[rpo_[i]]].push_back(rpo_[i]);
+
+    // Number the tree so dominates() is an interval check.
+    int counter = 0;
+    std::vector<std::pair<BlockId, size_t>> stack;
+    stack.emplace_back(0, 0);
+    dom_pre_[0] = counter++;
+    while (!stack.empty())
+    {
+        auto& [block, next] = stack.back();
+        if (next < dom_children_[block].size())
+        {
+            BlockId child = dom_children_[block][next++];
+            dom_pre_[child] = counter++;
+            stack.emplace_back(child, 0);
+        }
+        else
+        {
+            dom_post_[block] = counter++;
+            stack.pop_back();
+        }
+    }
+}
+
+void ControlFlowGraph::compute_frontiers() const
+{
+    if (df_valid_)
+        return;
+    df_valid_ = true;
+    compute_dominators();
+    df_.assign(size(), {});
+
+    // Cooper, Harvey and Kennedy: walk up from each predecessor of a join
+    // point until reaching the join point's immediate dominator. The entry is
+    // its own idom, so a back edge into it walks all the way up, entry included.
+    for (BlockId block : rpo_)
+    {
+        if (preds_[block].size() < 2 && block != 0)
+            continue;
+        for (BlockId pred : preds_[block])
+        {
+            if (idom_[pred] < 0)
+                continue;
+            for (BlockId runner = pred;; runner = idom_[runner])
+            {
+                if (runner == idom_[block] && block != 0)
+                    break;
+                std::vector<BlockId>& df = df_[runner];
+                if (std::find(df.begin(), df.end(), block) == df.end())
+                    df.push_back(block);
+                if (runner == 0)
+                    break;
+            }
+        }
+    }
+}
+
+} // namespace minic
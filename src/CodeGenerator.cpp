@@ -9,13 +9,37 @@
 namespace minic
 {
 
+namespace
+{
+
+// The jcc/setcc suffix that holds when the comparison is true.
+const char* condition_code(IROpcode comparison)
+{
+    switch (comparison)
+    {
+    case IROpcode::EQ:
+        return "e";
+    case IROpcode::NEQ:
+        return "ne";
+    case IROpcode::LT:
+        return "l";
+    case IROpcode::GT:
+        return "g";
+    case IROpcode::LE:
+        return "le";
+    default:
+        return "ge";
+    }
+}
+
+} // namespace
+
 CodeGenerator::CodeGenerator(std::ostream& out)
     : out_(&out)
     , type_map_({ { TokenType::KEYWORD_INT, "dq" },
           { TokenType::KEYWORD_VOID, "" },
           { TokenType::KEYWORD_STR, "db" } })
     , stack_offset_(0)
-    , last_written_loc_("")
 {
 }
 
@@ -49,7 +73,14 @@ void CodeGenerator::generate(const IRProgram& ir_program, const std::string& out
     (*out_) << "    syscall\n\n";
 
     std::cout << "[CodeGen] Emitting program\n";
+    string_data_.clear();
     emit_program(ir_program);
+    if (!string_data_.empty())
+    {
+        (*out_) << "section .data\n";
+        for (const auto& line : string_data_)
+            (*out_) << line << "\n";
+    }
     std::cout << "[CodeGen] Emission complete\n";
 
     out_->flush();
@@ -74,20 +105,29 @@ void CodeGenerator::emit_program(const IRProgram& program)
 void CodeGenerator::emit_function(const IRFunction& func)
 {
     std::cout << "[CodeGen] emit_function: " << func.name << " params=" << func.parameters.size() << " blocks=" << func.blocks.size() << "\n";
+    func.verify();
+    for (const auto& block : func.blocks)
+    {
+        if (!block.phis.empty())
+            throw std::runtime_error("Function " + func.name + " is still in SSA form (block " + block.label + " has phis)");
+    }
     current_function_ = func.name;
+    current_ir_function_ = &func;
     stack_offset_ = 0;
     var_offsets_.clear();
-    block_labels_.clear();
-    block_index_.clear();
-    labels_.clear();
-    last_written_loc_.clear();
-
-    for (size_t i = 0; i < func.blocks.size(); ++i)
+    temp_offsets_.clear();
+    temp_reads_.assign(func.temp_count, 0);
+    for (const auto& block : func.blocks)
     {
-        const std::string& lbl = func.blocks[i]->label;
-        block_labels_.push_back(lbl);
-        block_index_[lbl] = i;
-        labels_.insert(lbl);
+        for (const auto& instr : func.block_instructions(block))
+        {
+            // A SELECT also reads the value it may keep.
+            for (const IROperand& op : { instr.operand1, instr.operand2, instr.opcode == IROpcode::SELECT ? instr.result : IROperand {} })
+            {
+                if (op.is_temp())
+                    ++temp_reads_[op.value];
+            }
+        }
     }
 
     allocate_stack(func);
@@ -106,17 +146,18 @@ void CodeGenerator::emit_function(const IRFunction& func)
     size_t param_idx = 0;
     for (const auto& param : func.parameters)
     {
+        // Parameter i is registered as VAR i by IRFunction.
         if (param_idx < 6)
         {
-            (*out_) << "    mov [rbp - " << var_offsets_[param.name] << "], " << param_regs[param_idx] << "\n";
-            std::cout << "[CodeGen] Param move: " << param.name << " <- " << param_regs[param_idx] << " offset=" << var_offsets_[param.name] << "\n";
+            (*out_) << "    mov [rbp - " << var_offsets_[param_idx] << "], " << param_regs[param_idx] << "\n";
+            std::cout << "[CodeGen] Param move: " << param.name << " <- " << param_regs[param_idx] << " offset=" << var_offsets_[param_idx] << "\n";
         }
         param_idx++;
     }
 
-    for (const auto& block : func.blocks)
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
     {
-        emit_block(*block);
+        emit_block(id);
     }
 
     (*out_) << current_function_ << "_epilogue:\n";
@@ -125,38 +166,82 @@ void CodeGenerator::emit_function(const IRFunction& func)
     std::cout << "[CodeGen] Finished function: " << func.name << "\n";
 }
 
-void CodeGenerator::emit_block(const BasicBlock& block)
+void CodeGenerator::emit_block(BlockId id)
 {
+    const BasicBlock& block = current_ir_function_->blocks[id];
+    auto instructions = current_ir_function_->block_instructions(id);
+    current_block_ = id;
     current_block_label_ = block.label;
-    std::cout << "[CodeGen] emit_block: " << block.label << " instructions=" << block.instructions.size() << "\n";
+    std::cout << "[CodeGen] emit_block: " << block.label << " instructions=" << instructions.size() << "\n";
     (*out_) << block.label << ":\n";
-    for (const auto& instr : block.instructions)
+    const IRInstruction* compare = fused_comparison(id);
+    for (const auto& instr : instructions)
     {
-        emit_instruction(instr);
+        if (&instr == compare)
+            continue;
+        if (compare && instr.is_terminator())
+            emit_compare_and_branch(*compare, instr);
+        else
+            emit_instruction(instr);
     }
+}
 
-    if (!block.instructions.empty())
+const IRInstruction* CodeGenerator::fused_comparison(BlockId id) const
+{
+    auto instructions = current_ir_function_->block_instructions(id);
+    const IRInstruction& branch = instructions.back();
+    if ((branch.opcode != IROpcode::JUMPIF && branch.opcode != IROpcode::JUMPIFNOT) || !branch.operand1.is_temp()
+        || temp_reads_[branch.operand1.value] != 1)
+        return nullptr;
+
+    size_t index = instructions.size() - 1;
+    while (index-- > 0 && instructions[index].result != branch.operand1)
+        ;
+    if (index >= instructions.size() || !is_comparison(instructions[index].opcode))
+        return nullptr;
+    // The comparison moves down to the branch, so nothing in between may write what it reads.
+    const IRInstruction& compare = instructions[index];
+    for (size_t i = index + 1; i + 1 < instructions.size(); ++i)
     {
-        const IRInstruction& last = block.instructions.back();
-        if (last.opcode != IROpcode::JUMP && last.opcode != IROpcode::JUMPIF && last.opcode != IROpcode::JUMPIFNOT && last.opcode != IROpcode::RETURN)
-        {
-            size_t idx = block_index_.at(current_block_label_);
-            if (idx + 1 < block_labels_.size())
-            {
-                (*out_) << "    jmp " << block_labels_[idx + 1] << "\n";
-                std::cout << "[CodeGen] Auto-jmp to " << block_labels_[idx + 1] << " from " << current_block_label_ << "\n";
-            }
-        }
+        if (instructions[i].result == compare.operand1 || instructions[i].result == compare.operand2)
+            return nullptr;
     }
-    else
+    return &compare;
+}
+
+void CodeGenerator::emit_compare_and_branch(const IRInstruction& compare, const IRInstruction& branch)
+{
+    // JUMPIFNOT takes its target when the comparison fails.
+    IROpcode taken = branch.opcode == IROpcode::JUMPIF ? compare.opcode : invert_comparison(compare.opcode);
+    std::string op1_loc = get_loc(compare.operand1);
+    std::string op2_loc = get_loc(compare.operand2);
+    (*out_) << "    mov rax, " << op1_loc << "\n";
+    (*out_) << "    cmp rax, " << op2_loc << "\n";
+    std::cout << "[CodeGen] Fused compare and branch: " << op1_loc << " against " << op2_loc << "\n";
+    emit_branch(condition_code(taken), condition_code(invert_comparison(taken)), branch);
+}
+
+void CodeGenerator::emit_branch(const std::string& condition, const std::string& inverse, const IRInstruction& branch)
+{
+    if (branch.operand2.value == current_block_ + 1 && branch.result.value != current_block_ + 1)
     {
-        size_t idx = block_index_.at(current_block_label_);
-        if (idx + 1 < block_labels_.size())
-        {
-            (*out_) << "    jmp " << block_labels_[idx + 1] << "\n";
-            std::cout << "[CodeGen] Empty block auto-jmp to " << block_labels_[idx + 1] << "\n";
-        }
+        // The taken target comes next, so branch to the other one on the opposite condition.
+        (*out_) << "    j" << inverse << " " << get_loc(branch.result) << "\n";
+        std::cout << "[CodeGen] Inverted branch, fall through to " << get_loc(branch.operand2) << "\n";
+        return;
     }
+    (*out_) << "    j" << condition << " " << get_loc(branch.operand2) << "\n";
+    emit_fallthrough(branch.result);
+}
+
+void CodeGenerator::emit_fallthrough(const IROperand& target)
+{
+    if (target.value == current_block_ + 1)
+    {
+        std::cout << "[CodeGen] Fall through to " << current_ir_function_->blocks[target.value].label << "\n";
+        return;
+    }
+    (*out_) << "    jmp " << current_ir_function_->blocks[target.value].label << "\n";
 }
 
 void CodeGenerator::emit_instruction(const IRInstruction& instr)
@@ -166,30 +251,29 @@ void CodeGenerator::emit_instruction(const IRInstruction& instr)
     std::string op2_loc = get_loc(instr.operand2);
 
     std::cout << "[CodeGen] emit_instruction: opcode=" << static_cast<int>(instr.opcode)
-              << " result='" << instr.result << "' operand1='" << instr.operand1 << "' operand2='" << instr.operand2 << "'\n";
+              << " result='" << current_ir_function_->operand_name(instr.result)
+              << "' operand1='" << current_ir_function_->operand_name(instr.operand1)
+              << "' operand2='" << current_ir_function_->operand_name(instr.operand2) << "'\n";
     std::cout << "[CodeGen] locations: res=" << res_loc << " op1=" << op1_loc << " op2=" << op2_loc << "\n";
 
-    // For control flow instructions, handle specially if no explicit condition
-    if ((instr.opcode == IROpcode::JUMPIF || instr.opcode == IROpcode::JUMPIFNOT) && (instr.operand1.empty() || op1_loc == "0"))
-    {
-        if (!last_written_loc_.empty())
-        {
-            op1_loc = last_written_loc_;
-            std::cout << "[CodeGen] Using last_written_loc for condition: " << last_written_loc_ << "\n";
-        }
-    }
-
     switch (instr.opcode)
     {
     case IROpcode::ASSIGN:
-        if (instr.operand1.find_first_not_of("0123456789") == std::string::npos)
+        if (instr.operand1.is_imm())
         {
             // Literal assignment
             if (res_loc.find("[rbp") != std::string::npos)
-                (*out_) << "    mov qword " << res_loc << ", " << instr.operand1 << "\n";
+                (*out_) << "    mov qword " << res_loc << ", " << op1_loc << "\n";
             else
-                (*out_) << "    mov " << res_loc << ", " << instr.operand1 << "\n";
-            std::cout << "[CodeGen] ASSIGN literal: " << instr.operand1 << " -> " << res_loc << "\n";
+                (*out_) << "    mov " << res_loc << ", " << op1_loc << "\n";
+            std::cout << "[CodeGen] ASSIGN literal: " << op1_loc << " -> " << res_loc << "\n";
+        }
+        else if (instr.operand1.is_str())
+        {
+            // String constant: load its address
+            (*out_) << "    lea rax, [rel " << op1_loc << "]\n";
+            (*out_) << "    mov " << res_loc << ", rax\n";
+            std::cout << "[CodeGen] ASSIGN string: " << op1_loc << " -> " << res_loc << "\n";
         }
         else
         {
@@ -210,6 +294,14 @@ void CodeGenerator::emit_instruction(const IRInstruction& instr)
         (*out_) << "    mov " << res_loc << ", rax\n";
         break;
     case IROpcode::MUL:
+        if (instr.operand2.is_imm() && (instr.operand2.value == 3 || instr.operand2.value == 5 || instr.operand2.value == 9))
+        {
+            // x * 3, 5 or 9 is x + x * 2, 4 or 8: one lea instead of imul.
+            (*out_) << "    mov rax, " << op1_loc << "\n";
+            (*out_) << "    lea rax, [rax+rax*" << instr.operand2.value - 1 << "]\n";
+            (*out_) << "    mov " << res_loc << ", rax\n";
+            break;
+        }
         (*out_) << "    mov rax, " << op1_loc << "\n";
         (*out_) << "    imul rax, " << op2_loc << "\n";
         (*out_) << "    mov " << res_loc << ", rax\n";
@@ -217,18 +309,35 @@ void CodeGenerator::emit_instruction(const IRInstruction& instr)
     case IROpcode::DIV:
         (*out_) << "    mov rax, " << op1_loc << "\n";
         (*out_) << "    cqo\n";
-        if (op2_loc.find_first_not_of("0123456789") == std::string::npos)
+        (*out_) << "    mov rbx, " << op2_loc << "\n";
+        (*out_) << "    idiv rbx\n";
+        (*out_) << "    mov " << res_loc << ", rax\n";
+        break;
+    case IROpcode::SHL:
+    case IROpcode::SHR:
+    case IROpcode::SAR:
+    {
+        const char* mnemonic = instr.opcode == IROpcode::SHL ? "shl" : instr.opcode == IROpcode::SHR ? "shr" : "sar";
+        (*out_) << "    mov rax, " << op1_loc << "\n";
+        if (instr.operand2.is_imm())
         {
-            (*out_) << "    mov rbx, " << op2_loc << "\n";
-            (*out_) << "    idiv rbx\n";
+            (*out_) << "    " << mnemonic << " rax, " << (instr.operand2.value & 63) << "\n";
         }
         else
         {
-            (*out_) << "    mov rbx, " << op2_loc << "\n";
-            (*out_) << "    idiv rbx\n";
+            (*out_) << "    mov rcx, " << op2_loc << "\n";
+            (*out_) << "    " << mnemonic << " rax, cl\n";
         }
         (*out_) << "    mov " << res_loc << ", rax\n";
         break;
+    }
+    case IROpcode::MULH:
+        // One-operand imul leaves the 128-bit product in rdx:rax.
+        (*out_) << "    mov rax, " << op1_loc << "\n";
+        (*out_) << "    mov rbx, " << op2_loc << "\n";
+        (*out_) << "    imul rbx\n";
+        (*out_) << "    mov " << res_loc << ", rdx\n";
+        break;
     case IROpcode::NEG:
         (*out_) << "    mov rax, " << op1_loc << "\n";
         (*out_) << "    neg rax\n";
@@ -283,186 +392,140 @@ void CodeGenerator::emit_instruction(const IRInstruction& instr)
         (*out_) << "    movzx rax, al\n";
         (*out_) << "    mov " << res_loc << ", rax\n";
         break;
+    case IROpcode::SELECT:
+        // cmov takes no immediate, so the new value goes through rcx.
+        (*out_) << "    mov rax, " << res_loc << "\n";
+        (*out_) << "    mov rcx, " << op2_loc << "\n";
+        (*out_) << "    mov rdx, " << op1_loc << "\n";
+        (*out_) << "    test rdx, rdx\n";
+        (*out_) << "    cmovne rax, rcx\n";
+        (*out_) << "    mov " << res_loc << ", rax\n";
+        break;
     case IROpcode::JUMP:
-    {
-        std::string target = instr.operand1;
-        if (target.empty())
-            target = infer_target_label_for_current_block();
-        if (target.empty())
-        {
-            (*out_) << "    ; missing jump target in " << current_function_ << " " << current_block_label_ << "\n";
-            std::cout << "[CodeGen] JUMP: missing target in " << current_function_ << " " << current_block_label_ << "\n";
-        }
-        else
-        {
-            (*out_) << "    jmp " << target << "\n";
-            std::cout << "[CodeGen] JUMP -> " << target << "\n";
-        }
+        std::cout << "[CodeGen] JUMP -> " << op1_loc << "\n";
+        emit_fallthrough(instr.operand1);
         break;
-    }
     case IROpcode::JUMPIF:
-    {
-        std::string target = instr.operand2;
-        if (target.empty())
-            target = infer_target_label_for_current_block();
-        if (target.empty())
-        {
-            (*out_) << "    mov rax, " << op1_loc << "\n";
-            (*out_) << "    cmp rax, 0\n";
-            (*out_) << "    ; missing jump target (JUMPIF) in " << current_function_ << " " << current_block_label_ << "\n";
-            std::cout << "[CodeGen] JUMPIF: missing target, condition=" << op1_loc << "\n";
-        }
-        else
-        {
-            (*out_) << "    mov rax, " << op1_loc << "\n";
-            (*out_) << "    cmp rax, 0\n";
-            (*out_) << "    jne " << target << "\n";
-            std::cout << "[CodeGen] JUMPIF -> " << target << " if " << op1_loc << " != 0\n";
-        }
+        (*out_) << "    mov rax, " << op1_loc << "\n";
+        (*out_) << "    cmp rax, 0\n";
+        std::cout << "[CodeGen] JUMPIF -> " << op2_loc << " if " << op1_loc << " != 0, else " << res_loc << "\n";
+        emit_branch("ne", "e", instr);
         break;
-    }
     case IROpcode::JUMPIFNOT:
-    {
-        std::string target = instr.operand2;
-        if (target.empty())
-            target = infer_target_label_for_current_block();
-        if (target.empty())
-        {
-            (*out_) << "    mov rax, " << op1_loc << "\n";
-            (*out_) << "    cmp rax, 0\n";
-            (*out_) << "    ; missing jump target (JUMPIFNOT) in " << current_function_ << " " << current_block_label_ << "\n";
-            std::cout << "[CodeGen] JUMPIFNOT: missing target, condition=" << op1_loc << "\n";
-        }
-        else
-        {
-            (*out_) << "    mov rax, " << op1_loc << "\n";
-            (*out_) << "    cmp rax, 0\n";
-            (*out_) << "    je " << target << "\n";
-            std::cout << "[CodeGen] JUMPIFNOT -> " << target << " if " << op1_loc << " == 0\n";
-        }
+        (*out_) << "    mov rax, " << op1_loc << "\n";
+        (*out_) << "    cmp rax, 0\n";
+        std::cout << "[CodeGen] JUMPIFNOT -> " << op2_loc << " if " << op1_loc << " == 0, else " << res_loc << "\n";
+        emit_branch("e", "ne", instr);
         break;
-    }
     case IROpcode::RETURN:
         if (!instr.operand1.empty())
         {
             (*out_) << "    mov rax, " << op1_loc << "\n";
             std::cout << "[CodeGen] RETURN value moved to rax: " << op1_loc << "\n";
         }
-        (*out_) << "    jmp " << current_function_ << "_epilogue\n";
+        // The epilogue follows the last block.
+        if (current_block_ + 1 < static_cast<BlockId>(current_ir_function_->blocks.size()))
+            (*out_) << "    jmp " << current_function_ << "_epilogue\n";
         std::cout << "[CodeGen] RETURN -> epilogue\n";
         break;
     default:
         throw std::runtime_error("Unsupported IR opcode in NASM codegen");
     }
-
-    if (!instr.result.empty() && instr.opcode != IROpcode::JUMP && instr.opcode != IROpcode::JUMPIF && instr.opcode != IROpcode::JUMPIFNOT && instr.opcode != IROpcode::RETURN)
-    {
-        last_written_loc_ = res_loc;
-        std::cout << "[CodeGen] last_written_loc updated to " << last_written_loc_ << "\n";
-    }
 }
 
-std::string CodeGenerator::get_loc(const std::string& name)
+std::string CodeGenerator::get_loc(const IROperand& op)
 {
-    if (name.empty())
+    switch (op.kind)
+    {
+    case IROperandKind::NONE:
         return "0";
-    if (name.find_first_not_of("0123456789") == std::string::npos)
-        return name;
-    if (labels_.count(name))
-        return name;
-    auto it = var_offsets_.find(name);
-    if (it != var_offsets_.end())
-        return "[rbp - " + std::to_string(it->second) + "]";
-    // if unknown, allocate a slot for it now (ensures consistency)
-    int newOff = stack_offset_ + 8;
-    stack_offset_ = newOff;
-    var_offsets_[name] = newOff;
-    std::cout << "[CodeGen] get_loc: allocated new var '" << name << "' offset=" << newOff << " new stack_offset=" << stack_offset_ << "\n";
-    return "[rbp - " + std::to_string(newOff) + "]";
-}
+    case IROperandKind::IMM:
+        return std::to_string(op.value);
+    case IROperandKind::BLOCK:
+        return current_ir_function_->blocks.at(op.value).label;
+    case IROperandKind::STR:
+        return string_label(op);
+    default:
+        break;
+    }
 
-std::string CodeGenerator::find_label_with_substr(const std::string& substr) const
-{
-    for (const auto& lbl : block_labels_)
+    std::vector<int>& offsets = op.is_var() ? var_offsets_ : temp_offsets_;
+    if (static_cast<size_t>(op.value) >= offsets.size())
+        offsets.resize(op.value + 1, 0);
+    if (offsets[op.value] == 0)
     {
-        if (lbl.find(substr) != std::string::npos)
-            return lbl;
+        // if unknown, allocate a slot for it now (ensures consistency)
+        int newOff = stack_offset_ + 8;
+        stack_offset_ = newOff;
+        offsets[op.value] = newOff;
+        std::cout << "[CodeGen] get_loc: allocated new var '" << current_ir_function_->operand_name(op) << "' offset=" << newOff << " new stack_offset=" << stack_offset_ << "\n";
     }
-    return "";
+    return "[rbp - " + std::to_string(offsets[op.value]) + "]";
 }
 
-std::string CodeGenerator::infer_target_label_for_current_block() const
+std::string CodeGenerator::string_label(const IROperand& op)
 {
-    if (current_block_label_.find("body") != std::string::npos)
-    {
-        std::string found = find_label_with_substr("cond");
-        if (!found.empty())
-        {
-            std::cout << "[CodeGen] infer_target: body -> cond -> " << found << "\n";
-            return found;
-        }
-    }
-    size_t idx = block_index_.at(current_block_label_);
-    if (idx + 1 < block_labels_.size())
-    {
-        std::cout << "[CodeGen] infer_target: next block -> " << block_labels_[idx + 1] << "\n";
-        return block_labels_[idx + 1];
-    }
-    std::cout << "[CodeGen] infer_target: none found for block " << current_block_label_ << "\n";
-    return "";
+    std::string label = current_function_ + "_str" + std::to_string(op.value);
+    std::string line = label + ": db ";
+    for (unsigned char c : current_ir_function_->strings.at(op.value))
+        line += std::to_string(c) + ", ";
+    line += "0";
+    if (std::find(string_data_.begin(), string_data_.end(), line) == string_data_.end())
+        string_data_.push_back(line);
+    return label;
 }
 
 void CodeGenerator::allocate_stack(const IRFunction& func)
 {
     std::cout << "[CodeGen] allocate_stack for " << func.name << "\n";
-    std::unordered_set<std::string> all_vars;
-    for (const auto& p : func.parameters)
-        all_vars.insert(p.name);
+    std::vector<bool> used_vars(func.variables.size(), false);
+    std::vector<bool> used_temps(func.temp_count, false);
+    for (size_t i = 0; i < func.parameters.size(); ++i)
+        used_vars[i] = true;
+    auto mark = [&](const IROperand& op) {
+        if (!op.is_var() && !op.is_temp())
+            return;
+        std::vector<bool>& used = op.is_var() ? used_vars : used_temps;
+        if (static_cast<size_t>(op.value) >= used.size())
+            used.resize(op.value + 1, false);
+        used[op.value] = true;
+    };
     for (const auto& block : func.blocks)
     {
-        for (const auto& instr : block->instructions)
+        for (const auto& instr : func.block_instructions(block))
         {
-            if (!instr.result.empty() && labels_.count(instr.result) == 0)
-                all_vars.insert(instr.result);
-            if (!instr.operand1.empty() && instr.operand1.find_first_not_of("0123456789") != std::string::npos && labels_.count(instr.operand1) == 0)
-                all_vars.insert(instr.operand1);
-            if (!instr.operand2.empty() && instr.operand2.find_first_not_of("0123456789") != std::string::npos && labels_.count(instr.operand2) == 0)
-                all_vars.insert(instr.operand2);
+            mark(instr.result);
+            mark(instr.operand1);
+            mark(instr.operand2);
         }
     }
 
-    std::vector<std::string> params;
-    for (const auto& p : func.parameters)
-        params.push_back(p.name);
-
-    std::vector<std::string> locals;
-    for (const auto& v : all_vars)
-    {
-        if (std::find(params.begin(), params.end(), v) == params.end())
-            locals.push_back(v);
-    }
-
-    std::sort(locals.begin(), locals.end());
-
+    // Parameters come first (they are VAR 0..n-1), then locals, then temporaries.
+    var_offsets_.assign(used_vars.size(), 0);
+    temp_offsets_.assign(used_temps.size(), 0);
     int offset = 0;
-    for (const auto& p : params)
+    for (size_t v = 0; v < used_vars.size(); ++v)
     {
-        std::cout << "Param: " << p << " Offset: " << (offset + 8) << "\n";
+        if (!used_vars[v])
+            continue;
         offset += 8;
-        var_offsets_[p] = offset;
+        var_offsets_[v] = offset;
+        std::cout << (v < func.parameters.size() ? "Param: " : "Local: ") << func.variables[v] << " Offset: " << offset << "\n";
     }
-    for (const auto& v : locals)
+    for (size_t t = 0; t < used_temps.size(); ++t)
     {
-        std::cout << "Local: " << v << " Offset: " << (offset + 8) << "\n";
+        if (!used_temps[t])
+            continue;
         offset += 8;
-        var_offsets_[v] = offset;
+        temp_offsets_[t] = offset;
+        std::cout << "Local: t" << t << " Offset: " << offset << "\n";
     }
 
     stack_offset_ = offset;
     if (stack_offset_ % 16 != 0)
         stack_offset_ = ((stack_offset_ + 15) / 16) * 16;
 
-    std::cout << "[CodeGen] allocate_stack done: final_stack_offset=" << stack_offset_ << " var_count=" << var_offsets_.size() << "\n";
+    std::cout << "[CodeGen] allocate_stack done: final_stack_offset=" << stack_offset_ << " var_count=" << (var_offsets_.size() + temp_offsets_.size()) << "\n";
 }
 
 } // namespace minic
\ No newline at end of file
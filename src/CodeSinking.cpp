@@ -0,0 +1,123 @@
+#include "minic/CodeSinking.hpp"
+#include "minic/Loops.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace minic
+{
+
+bool CodeSinking::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    ControlFlowGraph cfg(func);
+    LoopInfo loops(cfg);
+
+    // The blocks reading each temp, once per read; a phi reads at the end of the predecessor.
+    std::vector<std::vector<BlockId>> uses(func.temp_count);
+    auto note = [&](const IROperand& op, BlockId id) {
+        if (op.is_temp())
+            uses[op.value].push_back(id);
+    };
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        for (const auto& phi : func.blocks[id].phis)
+        {
+            for (const auto& in : phi.incoming)
+                note(in.value, in.block);
+        }
+        for (const auto& instr : func.block_instructions(id))
+        {
+            note(instr.operand1, id);
+            note(instr.operand2, id);
+        }
+    }
+
+    // Whether every loop around a block also contains from.
+    auto outside_new_loops = [&](BlockId id, BlockId from) {
+        for (int loop = loops.loop_of(id); loop >= 0; loop = loops.loops()[loop].parent)
+        {
+            if (!loops.loops()[loop].contains(from))
+                return false;
+        }
+        return true;
+    };
+
+    bool changed = false;
+    std::vector<std::vector<IRInstruction>> sunk(func.blocks.size());
+    const auto& rpo = cfg.reverse_postorder();
+    for (auto it = rpo.rbegin(); it != rpo.rend(); ++it)
+    {
+        const BlockId id = *it;
+        auto instrs = func.block_instructions(id);
+        std::vector<IRInstruction> kept;
+        for (size_t i = instrs.size(); i-- > 0;)
+        {
+            const IRInstruction& instr = instrs[i];
+            if (instr.is_terminator() || !instr.result.is_temp() || !is_speculatable(instr))
+            {
+                kept.push_back(instr);
+                continue;
+            }
+            const auto& readers = uses[instr.result.value];
+            if (readers.empty() || std::ranges::find(readers, id) != readers.end())
+            {
+                kept.push_back(instr);
+                continue;
+            }
+
+            // Readers in unreachable blocks never run and have no dominators.
+            BlockId target = -1;
+            for (BlockId reader : readers)
+            {
+                if (!cfg.reachable(reader))
+                    continue;
+                if (target < 0)
+                    target = reader;
+                while (!cfg.dominates(target, reader))
+                    target = cfg.idom(target);
+            }
+            if (target < 0)
+            {
+                kept.push_back(instr);
+                continue;
+            }
+            while (target != id && !outside_new_loops(target, id))
+                target = cfg.idom(target);
+            if (target == id)
+            {
+                kept.push_back(instr);
+                continue;
+            }
+
+            // The operands are now read where the instruction went.
+            for (const IROperand& op : { instr.operand1, instr.operand2 })
+            {
+                if (op.is_temp())
+                    *std::ranges::find(uses[op.value], id) = target;
+            }
+            sunk[target].insert(sunk[target].begin(), instr);
+            changed = true;
+        }
+        if (kept.size() != instrs.size())
+        {
+            std::reverse(kept.begin(), kept.end());
+            func.set_block_instructions(id, kept);
+        }
+    }
+    if (!changed)
+        return false;
+
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (sunk[id].empty())
+            continue;
+        auto instrs = func.block_instructions(id);
+        sunk[id].insert(sunk[id].end(), instrs.begin(), instrs.end());
+        func.set_block_instructions(id, sunk[id]);
+    }
+    return true;
+}
+
+} // namespace minic
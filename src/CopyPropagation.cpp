@@ -0,0 +1,180 @@
+#include "minic/CopyPropagation.hpp"
+#include <utility>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief Propagate copies into single-definition temps across the whole function.
+ */
+bool propagate_global(IRFunction& func)
+{
+    std::vector<int> temp_defs(func.temp_count, 0);
+    std::vector<bool> var_written(func.variables.size(), false);
+    for (const auto& block : func.blocks)
+    {
+        for (const auto& phi : block.phis)
+            ++temp_defs.at(phi.result.value);
+        for (const auto& instr : func.block_instructions(block))
+        {
+            if (instr.is_terminator())
+                continue;
+            if (instr.result.is_temp())
+                ++temp_defs.at(instr.result.value);
+            else if (instr.result.is_var())
+                var_written.at(instr.result.value) = true;
+        }
+    }
+    // Values that are the same wherever they can be read.
+    auto stable = [&](const IROperand& op) {
+        if (op.is_temp())
+            return temp_defs[op.value] == 1;
+        if (op.is_var())
+            return !var_written[op.value];
+        return op.is_imm();
+    };
+
+    // source[t] is the value copy t stands for; the chains are acyclic because a
+    // copy is only recorded when its source does not already resolve to it.
+    std::vector<IROperand> source(func.temp_count);
+    auto resolve = [&](IROperand op) {
+        while (op.is_temp() && !source[op.value].empty())
+            op = source[op.value];
+        return op;
+    };
+
+    for (const auto& block : func.blocks)
+    {
+        for (const auto& instr : func.block_instructions(block))
+        {
+            if (instr.opcode == IROpcode::ASSIGN && instr.result.is_temp() && stable(instr.result) && stable(instr.operand1) && resolve(instr.operand1) != instr.result)
+                source[instr.result.value] = instr.operand1;
+        }
+    }
+    for (bool found = true; found;)
+    {
+        found = false;
+        for (const auto& block : func.blocks)
+        {
+            for (const auto& phi : block.phis)
+            {
+                if (!source[phi.result.value].empty() || !stable(phi.result))
+                    continue;
+                IROperand only;
+                bool trivial = true;
+                for (const auto& in : phi.incoming)
+                {
+                    IROperand value = resolve(in.value);
+                    if (value == phi.result || value == only)
+                        continue;
+                    trivial = only.empty();
+                    if (!trivial)
+                        break;
+                    only = value;
+                }
+                if (trivial && !only.empty() && stable(only))
+                {
+                    source[phi.result.value] = only;
+                    found = true;
+                }
+            }
+        }
+    }
+
+    bool changed = false;
+    auto rewrite = [&](IROperand& op) {
+        IROperand value = resolve(op);
+        if (value != op)
+        {
+            op = value;
+            changed = true;
+        }
+    };
+    auto is_copy = [&](const IROperand& result) { return result.is_temp() && !source[result.value].empty(); };
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        BasicBlock& block = func.blocks[id];
+        changed |= std::erase_if(block.phis, [&](const PhiNode& phi) { return is_copy(phi.result); }) > 0;
+        for (auto& phi : block.phis)
+        {
+            for (auto& in : phi.incoming)
+                rewrite(in.value);
+        }
+
+        std::vector<IRInstruction> kept;
+        auto instrs = func.block_instructions(id);
+        for (auto& instr : instrs)
+        {
+            if (!instr.is_terminator() && is_copy(instr.result))
+                continue;
+            if (instr.opcode != IROpcode::JUMP)
+            {
+                rewrite(instr.operand1);
+                rewrite(instr.operand2);
+            }
+            kept.push_back(instr);
+        }
+        if (kept.size() != instrs.size())
+        {
+            func.set_block_instructions(id, kept);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Forward the remaining copies to later reads in the same block.
+ */
+bool propagate_local(IRFunction& func)
+{
+    bool changed = false;
+    std::vector<std::pair<IROperand, IROperand>> copies; // (destination, source) pairs still valid
+    auto forward = [&](IROperand& op) {
+        for (const auto& [dest, src] : copies)
+        {
+            if (op == dest)
+            {
+                op = src;
+                changed = true;
+                return;
+            }
+        }
+    };
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        copies.clear();
+        for (auto& instr : func.block_instructions(id))
+        {
+            if (instr.opcode != IROpcode::JUMP)
+            {
+                forward(instr.operand1);
+                forward(instr.operand2);
+            }
+            if (instr.is_terminator())
+                continue;
+            const IROperand written = instr.result;
+            std::erase_if(copies, [&](const auto& copy) { return copy.first == written || copy.second == written; });
+            const IROperand& src = instr.operand1;
+            bool copyable = src.is_temp() || src.is_var() || src.is_imm();
+            if (instr.opcode == IROpcode::ASSIGN && (written.is_temp() || written.is_var()) && copyable && src != written)
+                copies.push_back({ written, src });
+        }
+    }
+    return changed;
+}
+
+} // namespace
+
+bool CopyPropagation::run(IRFunction& func)
+{
+    bool changed = propagate_global(func);
+    changed |= propagate_local(func);
+    return changed;
+}
+
+} // namespace minic
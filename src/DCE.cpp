@@ -0,0 +1,235 @@
+#include "minic/DCE.hpp"
+#include "minic/CFG.hpp"
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief Maps temps and variables to one index space: temps first, then variables.
+ */
+class Names
+{
+public:
+    explicit Names(const IRFunction& func)
+        : temps_(func.temp_count)
+        , size_(static_cast<size_t>(func.temp_count) + func.variables.size())
+    {
+    }
+
+    /**
+     * @brief Index of a temp or variable operand, -1 for anything else.
+     */
+    std::int64_t index(const IROperand& op) const
+    {
+        if (op.is_temp())
+            return op.value;
+        if (op.is_var())
+            return static_cast<std::int64_t>(temps_) + op.value;
+        return -1;
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    std::int32_t temps_;
+    size_t size_;
+};
+
+/**
+ * @brief Whether deleting the instruction leaves what the program does unchanged,
+ * assuming its result is unused.
+ */
+bool removable(const IRInstruction& instr)
+{
+    return (instr.result.is_temp() || instr.result.is_var()) && is_speculatable(instr);
+}
+
+/**
+ * @brief Keep only the instructions of a block for which keep(instr) is true.
+ */
+template <typename Keep>
+bool filter_block(IRFunction& func, BlockId id, Keep keep)
+{
+    std::vector<IRInstruction> kept;
+    auto instrs = func.block_instructions(id);
+    kept.reserve(instrs.size());
+    for (const auto& instr : instrs)
+    {
+        if (keep(instr))
+            kept.push_back(instr);
+    }
+    if (kept.size() == instrs.size())
+        return false;
+    func.set_block_instructions(id, kept);
+    return true;
+}
+
+/**
+ * @brief Mark everything reachable from effects through uses; delete the rest.
+ */
+bool sweep_unused(IRFunction& func, const Names& names)
+{
+    std::vector<bool> useful(names.size(), false);
+    std::vector<std::int64_t> work;
+    auto use = [&](const IROperand& op) {
+        std::int64_t name = names.index(op);
+        if (name >= 0 && !useful[name])
+        {
+            useful[name] = true;
+            work.push_back(name);
+        }
+    };
+
+    // Definitions of each name, so marking a name can mark what its definitions read.
+    std::vector<std::vector<const IRInstruction*>> defs(names.size());
+    std::vector<std::vector<const PhiNode*>> phi_defs(names.size());
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        for (const auto& phi : func.blocks[id].phis)
+            phi_defs[names.index(phi.result)].push_back(&phi);
+        for (const auto& instr : func.block_instructions(id))
+        {
+            if (removable(instr))
+            {
+                defs[names.index(instr.result)].push_back(&instr);
+                continue;
+            }
+            // A SELECT also reads the value it may keep.
+            if (instr.opcode == IROpcode::SELECT)
+                use(instr.result);
+            if (instr.opcode != IROpcode::JUMP)
+            {
+                use(instr.operand1);
+                use(instr.operand2);
+            }
+        }
+    }
+    while (!work.empty())
+    {
+        std::int64_t name = work.back();
+        work.pop_back();
+        for (const IRInstruction* def : defs[name])
+        {
+            use(def->operand1);
+            use(def->operand2);
+        }
+        for (const PhiNode* phi : phi_defs[name])
+        {
+            for (const auto& in : phi->incoming)
+                use(in.value);
+        }
+    }
+
+    bool changed = false;
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        changed |= std::erase_if(func.blocks[id].phis, [&](const PhiNode& phi) { return !useful[names.index(phi.result)]; }) > 0;
+        changed |= filter_block(func, id, [&](const IRInstruction& instr) { return !removable(instr) || useful[names.index(instr.result)]; });
+    }
+    return changed;
+}
+
+/**
+ * @brief Delete instructions whose result is dead right after them, using
+ * backward liveness of temps and variables.
+ */
+bool sweep_dead_stores(IRFunction& func, const Names& names)
+{
+    ControlFlowGraph cfg(func);
+    const size_t block_count = func.blocks.size();
+    std::vector<std::vector<bool>> live_in(block_count, std::vector<bool>(names.size(), false));
+
+    auto set = [&](std::vector<bool>& live, const IROperand& op, bool value) {
+        std::int64_t name = names.index(op);
+        if (name >= 0)
+            live[name] = value;
+    };
+    auto live_out = [&](BlockId id) {
+        std::vector<bool> live(names.size(), false);
+        for (BlockId succ : cfg.successors(id))
+        {
+            for (size_t i = 0; i < live.size(); ++i)
+                live[i] = live[i] || live_in[succ][i];
+            for (const auto& phi : func.blocks[succ].phis)
+                set(live, phi.value_from(id), true);
+        }
+        return live;
+    };
+    auto step = [&](std::vector<bool>& live, const IRInstruction& instr) {
+        // A SELECT also reads the value it may keep, so its result stays live.
+        if (!instr.is_terminator())
+            set(live, instr.result, instr.opcode == IROpcode::SELECT);
+        if (instr.opcode != IROpcode::JUMP)
+        {
+            set(live, instr.operand1, true);
+            set(live, instr.operand2, true);
+        }
+    };
+
+    // Postorder visits successors first, so this usually converges in two rounds.
+    std::vector<BlockId> order(cfg.reverse_postorder().rbegin(), cfg.reverse_postorder().rend());
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (BlockId id : order)
+        {
+            std::vector<bool> live = live_out(id);
+            auto instrs = func.block_instructions(id);
+            for (auto it = instrs.rbegin(); it != instrs.rend(); ++it)
+                step(live, *it);
+            for (const auto& phi : func.blocks[id].phis)
+                set(live, phi.result, false);
+            if (live != live_in[id])
+            {
+                live_in[id] = std::move(live);
+                changed = true;
+            }
+        }
+    }
+
+    bool changed = false;
+    for (BlockId id : order)
+    {
+        std::vector<bool> live = live_out(id);
+        auto instrs = func.block_instructions(id);
+        std::vector<bool> dead(instrs.size(), false);
+        for (size_t i = instrs.size(); i-- > 0;)
+        {
+            const IRInstruction& instr = instrs[i];
+            std::int64_t name = names.index(instr.result);
+            if (!instr.is_terminator() && removable(instr) && !live[name])
+            {
+                // A dead instruction reads nothing.
+                dead[i] = true;
+                continue;
+            }
+            step(live, instr);
+        }
+        size_t i = 0;
+        changed |= filter_block(func, id, [&](const IRInstruction&) { return !dead[i++]; });
+    }
+    return changed;
+}
+
+} // namespace
+
+bool DeadCodeElimination::run(IRFunction& func)
+{
+    Names names(func);
+    bool changed = false;
+    while (true)
+    {
+        bool swept = sweep_unused(func, names);
+        swept |= sweep_dead_stores(func, names);
+        if (!swept)
+            break;
+        changed = true;
+    }
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,234 @@
+#include "minic/GVN.hpp"
+#include "minic/CFG.hpp"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief A hash-consed expression: an opcode over value-numbered operands.
+ */
+struct ExprKey
+{
+    IROpcode opcode;
+    IROperand a;
+    IROperand b;
+
+    bool operator==(const ExprKey&) const = default;
+};
+
+struct ExprKeyHash
+{
+    size_t operator()(const ExprKey& key) const
+    {
+        auto pack = [](const IROperand& op) {
+            return (static_cast<std::uint64_t>(op.kind) << 32) | static_cast<std::uint32_t>(op.value);
+        };
+        std::uint64_t h = static_cast<std::uint64_t>(key.opcode);
+        h = h * 0x9E3779B97F4A7C15ULL ^ pack(key.a);
+        h = h * 0x9E3779B97F4A7C15ULL ^ pack(key.b);
+        return std::hash<std::uint64_t>()(h);
+    }
+};
+
+bool operand_less(const IROperand& x, const IROperand& y)
+{
+    return x.kind != y.kind ? x.kind < y.kind : x.value < y.value;
+}
+
+/**
+ * @brief Put an expression in a canonical form, so a+b and b+a (or a<b and b>a) get one key.
+ */
+ExprKey canonical(IROpcode opcode, IROperand a, IROperand b)
+{
+    bool commutative = opcode == IROpcode::ADD || opcode == IROpcode::MUL || opcode == IROpcode::MULH || opcode == IROpcode::EQ || opcode == IROpcode::NEQ;
+    if ((commutative || is_comparison(opcode)) && operand_less(b, a))
+    {
+        std::swap(a, b);
+        opcode = swap_comparison(opcode);
+    }
+    return { opcode, a, b };
+}
+
+bool numbered(IROpcode opcode)
+{
+    switch (opcode)
+    {
+    case IROpcode::ADD:
+    case IROpcode::SUB:
+    case IROpcode::MUL:
+    case IROpcode::DIV:
+    case IROpcode::SHL:
+    case IROpcode::SHR:
+    case IROpcode::SAR:
+    case IROpcode::MULH:
+    case IROpcode::NEG:
+    case IROpcode::NOT:
+    case IROpcode::EQ:
+    case IROpcode::NEQ:
+    case IROpcode::LT:
+    case IROpcode::GT:
+    case IROpcode::LE:
+    case IROpcode::GE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+bool GVN::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+    ControlFlowGraph cfg(func);
+
+    std::vector<int> temp_defs(func.temp_count, 0);
+    std::vector<bool> var_written(func.variables.size(), false);
+    for (const auto& block : func.blocks)
+    {
+        for (const auto& phi : block.phis)
+            ++temp_defs.at(phi.result.value);
+        for (const auto& instr : func.block_instructions(block))
+        {
+            if (instr.is_terminator())
+                continue;
+            if (instr.result.is_temp())
+                ++temp_defs.at(instr.result.value);
+            else if (instr.result.is_var())
+                var_written.at(instr.result.value) = true;
+        }
+    }
+    auto stable = [&](const IROperand& op) {
+        if (op.is_temp())
+            return temp_defs[op.value] == 1;
+        if (op.is_var())
+            return !var_written[op.value];
+        return op.is_imm() || op.empty();
+    };
+
+    // leader[t] is the earlier value a redundant temp t is replaced by.
+    std::vector<IROperand> leader(func.temp_count);
+    auto number = [&](const IROperand& op) {
+        return op.is_temp() && !leader[op.value].empty() ? leader[op.value] : op;
+    };
+
+    std::unordered_map<ExprKey, IROperand, ExprKeyHash> available;
+    struct Frame
+    {
+        BlockId block;
+        size_t next_child;
+        std::vector<ExprKey> inserted;
+    };
+    std::vector<Frame> walk;
+    auto enter = [&](BlockId id) {
+        Frame frame { id, 0, {} };
+        const auto& phis = func.blocks[id].phis;
+        for (size_t i = 0; i < phis.size(); ++i)
+        {
+            if (!stable(phis[i].result))
+                continue;
+            for (size_t j = 0; j < i; ++j)
+            {
+                if (!stable(phis[j].result) || !leader[phis[j].result.value].empty() || phis[j].incoming.size() != phis[i].incoming.size())
+                    continue;
+                bool same = true;
+                for (const auto& in : phis[i].incoming)
+                    same = same && number(phis[j].value_from(in.block)) == number(in.value);
+                if (same)
+                {
+                    leader[phis[i].result.value] = phis[j].result;
+                    break;
+                }
+            }
+        }
+
+        for (const auto& instr : func.block_instructions(id))
+        {
+            if (instr.is_terminator() || !instr.result.is_temp() || !stable(instr.result))
+                continue;
+            if (!stable(instr.operand1) || !stable(instr.operand2))
+                continue;
+            if (instr.opcode == IROpcode::ASSIGN)
+            {
+                if (!instr.operand1.is_str() && number(instr.operand1) != instr.result)
+                    leader[instr.result.value] = number(instr.operand1);
+                continue;
+            }
+            if (!numbered(instr.opcode))
+                continue;
+            ExprKey key = canonical(instr.opcode, number(instr.operand1), number(instr.operand2));
+            auto [it, inserted] = available.try_emplace(key, instr.result);
+            if (inserted)
+                frame.inserted.push_back(key);
+            else
+                leader[instr.result.value] = it->second;
+        }
+        walk.push_back(std::move(frame));
+    };
+
+    enter(0);
+    while (!walk.empty())
+    {
+        Frame& frame = walk.back();
+        const auto& children = cfg.dom_children(frame.block);
+        if (frame.next_child < children.size())
+        {
+            enter(children[frame.next_child++]);
+            continue;
+        }
+        for (const ExprKey& key : frame.inserted)
+            available.erase(key);
+        walk.pop_back();
+    }
+
+    // Every redundant definition is dominated by its leader, and so are its uses.
+    bool changed = false;
+    auto redundant = [&](const IROperand& result) { return result.is_temp() && !leader[result.value].empty(); };
+    auto rewrite = [&](IROperand& op) {
+        IROperand value = number(op);
+        if (value != op)
+        {
+            op = value;
+            changed = true;
+        }
+    };
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        BasicBlock& block = func.blocks[id];
+        changed |= std::erase_if(block.phis, [&](const PhiNode& phi) { return redundant(phi.result); }) > 0;
+        for (auto& phi : block.phis)
+        {
+            for (auto& in : phi.incoming)
+                rewrite(in.value);
+        }
+
+        std::vector<IRInstruction> kept;
+        auto instrs = func.block_instructions(id);
+        for (auto& instr : instrs)
+        {
+            if (!instr.is_terminator() && redundant(instr.result))
+                continue;
+            if (instr.opcode != IROpcode::JUMP)
+            {
+                rewrite(instr.operand1);
+                rewrite(instr.operand2);
+            }
+            kept.push_back(instr);
+        }
+        if (kept.size() != instrs.size())
+        {
+            func.set_block_instructions(id, kept);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+} // namespace minic
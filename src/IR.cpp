@@ -0,0 +1,371 @@
+#include "minic/IR.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief High 64 bits of the signed 128-bit product, from 32-bit partial products.
+ */
+std::int64_t multiply_high(std::int64_t a, std::int64_t b)
+{
+    auto ua = static_cast<std::uint64_t>(a);
+    auto ub = static_cast<std::uint64_t>(b);
+    const std::uint64_t low = 0xFFFFFFFFULL;
+    std::uint64_t cross1 = (ua & low) * (ub >> 32);
+    std::uint64_t cross2 = (ua >> 32) * (ub & low);
+    std::uint64_t middle = (((ua & low) * (ub & low)) >> 32) + (cross1 & low) + (cross2 & low);
+    std::uint64_t high = (ua >> 32) * (ub >> 32) + (cross1 >> 32) + (cross2 >> 32) + (middle >> 32);
+    // The unsigned product counts a negative factor as 2^64 more than it is.
+    if (a < 0)
+        high -= ub;
+    if (b < 0)
+        high -= ua;
+    return static_cast<std::int64_t>(high);
+}
+
+} // namespace
+
+bool is_comparison(IROpcode op)
+{
+    return op == IROpcode::EQ || op == IROpcode::NEQ || op == IROpcode::LT || op == IROpcode::GT || op == IROpcode::LE || op == IROpcode::GE;
+}
+
+IROpcode swap_comparison(IROpcode op)
+{
+    switch (op)
+    {
+    case IROpcode::LT:
+        return IROpcode::GT;
+    case IROpcode::GT:
+        return IROpcode::LT;
+    case IROpcode::LE:
+        return IROpcode::GE;
+    case IROpcode::GE:
+        return IROpcode::LE;
+    default:
+        return op;
+    }
+}
+
+IROpcode invert_comparison(IROpcode op)
+{
+    switch (op)
+    {
+    case IROpcode::EQ:
+        return IROpcode::NEQ;
+    case IROpcode::NEQ:
+        return IROpcode::EQ;
+    case IROpcode::LT:
+        return IROpcode::GE;
+    case IROpcode::GE:
+        return IROpcode::LT;
+    case IROpcode::GT:
+        return IROpcode::LE;
+    case IROpcode::LE:
+        return IROpcode::GT;
+    default:
+        return op;
+    }
+}
+
+bool is_speculatable(const IRInstruction& instr)
+{
+    switch (instr.opcode)
+    {
+    case IROpcode::ASSIGN:
+    case IROpcode::NEG:
+    case IROpcode::NOT:
+    case IROpcode::ADD:
+    case IROpcode::SUB:
+    case IROpcode::MUL:
+    case IROpcode::SHL:
+    case IROpcode::SHR:
+    case IROpcode::SAR:
+    case IROpcode::MULH:
+        return true;
+    case IROpcode::DIV:
+        // Division traps on a zero divisor and on INT64_MIN / -1.
+        return instr.operand2.is_imm() && instr.operand2.value != 0 && instr.operand2.value != -1;
+    default:
+        return is_comparison(instr.opcode);
+    }
+}
+
+std::uint64_t estimated_cycles(const IRInstruction& instr)
+{
+    switch (instr.opcode)
+    {
+    case IROpcode::DIV:
+        return 40;
+    case IROpcode::MUL:
+        if (instr.operand2.is_imm() && (instr.operand2.value == 3 || instr.operand2.value == 5 || instr.operand2.value == 9))
+            return 1;
+        return 3;
+    case IROpcode::MULH:
+        return 3;
+    default:
+        return 1;
+    }
+}
+
+std::optional<std::int64_t> evaluate(IROpcode op, std::int64_t a, std::int64_t b)
+{
+    auto ua = static_cast<std::uint64_t>(a);
+    auto ub = static_cast<std::uint64_t>(b);
+    switch (op)
+    {
+    case IROpcode::ADD:
+        return static_cast<std::int64_t>(ua + ub);
+    case IROpcode::SUB:
+        return static_cast<std::int64_t>(ua - ub);
+    case IROpcode::MUL:
+        return static_cast<std::int64_t>(ua * ub);
+    case IROpcode::DIV:
+        if (b == 0 || (a == std::numeric_limits<std::int64_t>::min() && b == -1))
+            return std::nullopt;
+        return a / b;
+    case IROpcode::SHL:
+        return static_cast<std::int64_t>(ua << (ub & 63));
+    case IROpcode::SHR:
+        return static_cast<std::int64_t>(ua >> (ub & 63));
+    case IROpcode::SAR:
+        return a >> (ub & 63);
+    case IROpcode::MULH:
+        return multiply_high(a, b);
+    case IROpcode::NEG:
+        return static_cast<std::int64_t>(0 - ua);
+    case IROpcode::NOT:
+        return a == 0;
+    case IROpcode::EQ:
+        return a == b;
+    case IROpcode::NEQ:
+        return a != b;
+    case IROpcode::LT:
+        return a < b;
+    case IROpcode::GT:
+        return a > b;
+    case IROpcode::LE:
+        return a <= b;
+    case IROpcode::GE:
+        return a >= b;
+    case IROpcode::ASSIGN:
+        return a;
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<IROperand> fold_constant(IROpcode op, const IROperand& a, const IROperand& b)
+{
+    bool unary = op == IROpcode::NEG || op == IROpcode::NOT || op == IROpcode::ASSIGN;
+    if (!a.is_imm() || (!unary && !b.is_imm()))
+        return std::nullopt;
+    auto value = evaluate(op, a.value, unary ? 0 : b.value);
+    if (!value || *value < std::numeric_limits<std::int32_t>::min() || *value > std::numeric_limits<std::int32_t>::max())
+        return std::nullopt;
+    return IROperand::imm(static_cast<std::int32_t>(*value));
+}
+
+BlockId IRFunction::add_block(const std::string& label)
+{
+    blocks.emplace_back(label);
+    blocks.back().begin = static_cast<std::uint32_t>(instructions.size());
+    return static_cast<BlockId>(blocks.size() - 1);
+}
+
+std::string IRFunction::new_label(const std::string& prefix) const
+{
+    for (size_t n = blocks.size();; ++n)
+    {
+        std::string label = prefix + "_" + std::to_string(n);
+        bool taken = std::any_of(blocks.begin(), blocks.end(), [&](const BasicBlock& b) { return b.label == label; });
+        if (!taken)
+            return label;
+    }
+}
+
+void IRFunction::remove_blocks(const std::vector<bool>& dead)
+{
+    if (dead.empty() || dead[0])
+        throw std::runtime_error("Cannot remove the entry block of " + name);
+
+    std::vector<BlockId> new_id(blocks.size(), -1);
+    std::vector<BasicBlock> kept;
+    for (size_t id = 0; id < blocks.size(); ++id)
+    {
+        if (id < dead.size() && dead[id])
+            continue;
+        new_id[id] = static_cast<BlockId>(kept.size());
+        kept.push_back(std::move(blocks[id]));
+    }
+    blocks = std::move(kept);
+
+    auto remap = [&](IROperand& op) {
+        if (op.is_block())
+            op.value = new_id.at(op.value);
+    };
+    for (BlockId id = 0; id < static_cast<BlockId>(blocks.size()); ++id)
+    {
+        if (blocks[id].size > 0)
+        {
+            IRInstruction& term = terminator(id);
+            if (term.is_terminator())
+            {
+                remap(term.operand1);
+                remap(term.operand2);
+                remap(term.result);
+            }
+        }
+        for (auto& phi : blocks[id].phis)
+        {
+            std::erase_if(phi.incoming, [&](const PhiIncoming& in) { return new_id.at(in.block) < 0; });
+            for (auto& in : phi.incoming)
+                in.block = new_id[in.block];
+        }
+    }
+    compact();
+}
+
+void IRFunction::reorder_blocks(const std::vector<BlockId>& order)
+{
+    if (order.size() != blocks.size() || order.empty() || order[0] != 0)
+        throw std::runtime_error("Block order of " + name + " must list every block once, entry first");
+
+    std::vector<BlockId> new_id(blocks.size(), -1);
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        if (new_id.at(order[i]) >= 0)
+            throw std::runtime_error("Block order of " + name + " lists " + blocks[order[i]].label + " twice");
+        new_id[order[i]] = static_cast<BlockId>(i);
+    }
+    std::vector<BasicBlock> placed;
+    placed.reserve(blocks.size());
+    for (BlockId id : order)
+        placed.push_back(std::move(blocks[id]));
+    blocks = std::move(placed);
+
+    auto remap = [&](IROperand& op) {
+        if (op.is_block())
+            op.value = new_id[op.value];
+    };
+    for (BlockId id = 0; id < static_cast<BlockId>(blocks.size()); ++id)
+    {
+        if (blocks[id].size > 0)
+        {
+            IRInstruction& term = terminator(id);
+            if (term.is_terminator())
+            {
+                remap(term.operand1);
+                remap(term.operand2);
+                remap(term.result);
+            }
+        }
+        for (auto& phi : blocks[id].phis)
+        {
+            for (auto& in : phi.incoming)
+                in.block = new_id[in.block];
+        }
+    }
+    compact();
+}
+
+std::span<IRInstruction> IRFunction::block_instructions(BlockId id)
+{
+    const BasicBlock& block = blocks.at(id);
+    return { instructions.data() + block.begin, block.size };
+}
+
+std::span<const IRInstruction> IRFunction::block_instructions(BlockId id) const
+{
+    return block_instructions(blocks.at(id));
+}
+
+std::span<const IRInstruction> IRFunction::block_instructions(const BasicBlock& block) const
+{
+    return { instructions.data() + block.begin, block.size };
+}
+
+void IRFunction::append(BlockId id, const IRInstruction& instr)
+{
+    BasicBlock& block = blocks.at(id);
+    if (block.begin + block.size != instructions.size())
+    {
+        // Not at the end of the arena: move the block there first.
+        std::uint32_t new_begin = static_cast<std::uint32_t>(instructions.size());
+        for (std::uint32_t i = 0; i < block.size; ++i)
+            instructions.push_back(instructions[block.begin + i]);
+        block.begin = new_begin;
+    }
+    instructions.push_back(instr);
+    ++block.size;
+}
+
+void IRFunction::set_block_instructions(BlockId id, const std::vector<IRInstruction>& instrs)
+{
+    BasicBlock& block = blocks.at(id);
+    if (instrs.size() > block.size)
+    {
+        // Grow in place only when the block is last in the arena.
+        if (block.begin + block.size != instructions.size())
+            block.begin = static_cast<std::uint32_t>(instructions.size());
+        instructions.resize(block.begin + instrs.size(), IRInstruction(IROpcode::LABEL));
+    }
+    std::copy(instrs.begin(), instrs.end(), instructions.begin() + block.begin);
+    block.size = static_cast<std::uint32_t>(instrs.size());
+}
+
+void IRFunction::compact()
+{
+    std::vector<IRInstruction> laid_out;
+    laid_out.reserve(instructions.size());
+    for (auto& block : blocks)
+    {
+        std::uint32_t new_begin = static_cast<std::uint32_t>(laid_out.size());
+        laid_out.insert(laid_out.end(), instructions.begin() + block.begin, instructions.begin() + block.begin + block.size);
+        block.begin = new_begin;
+    }
+    instructions = std::move(laid_out);
+}
+
+void IRFunction::verify() const
+{
+    auto fail = [&](BlockId id, const std::string& what) {
+        throw std::runtime_error("Malformed IR in " + name + " block " + blocks[id].label + ": " + what);
+    };
+    auto check_block = [&](BlockId id, const IROperand& op) {
+        if (!op.is_block() || op.value < 0 || static_cast<size_t>(op.value) >= blocks.size())
+            fail(id, "jump target is not a block");
+    };
+
+    if (blocks.empty())
+        throw std::runtime_error("Malformed IR in " + name + ": function has no blocks");
+    for (BlockId id = 0; id < static_cast<BlockId>(blocks.size()); ++id)
+    {
+        auto instrs = block_instructions(id);
+        if (instrs.empty() || !instrs.back().is_terminator())
+            fail(id, "block does not end in a terminator");
+        for (size_t i = 0; i + 1 < instrs.size(); ++i)
+        {
+            if (instrs[i].is_terminator())
+                fail(id, "terminator in the middle of the block");
+        }
+        const IRInstruction& term = instrs.back();
+        if ((term.opcode == IROpcode::JUMPIF || term.opcode == IROpcode::JUMPIFNOT) && term.operand1.empty())
+            fail(id, "conditional jump without a condition");
+        for (const auto& target : term.targets())
+            check_block(id, target);
+        for (const auto& phi : blocks[id].phis)
+        {
+            for (const auto& in : phi.incoming)
+                check_block(id, IROperand::block(in.block));
+        }
+    }
+}
+
+} // namespace minic
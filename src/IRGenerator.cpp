@@ -27,14 +27,12 @@ void IRGenerator::visit(const Function& function)
     label_counter_ = 0;
     var_map_.clear();
 
-    auto entry_block = std::make_unique<BasicBlock>(new_label("entry"));
-    current_block_ = entry_block.get();
-    ir_func->blocks.push_back(std::move(entry_block));
+    start_block(new_label("entry"));
 
     // Params (treat as vars)
     for (const auto& param : function.parameters)
     {
-        var_map_[param.name] = param.name; // Use name directly
+        var_map_[param.name] = ir_func->variable(param.name);
     }
 
     // Body
@@ -42,6 +40,8 @@ void IRGenerator::visit(const Function& function)
     {
         visit(*stmt);
     }
+    emit(IROpcode::RETURN); // Falling off the end returns; dropped if the block already ended
+    ir_func->temp_count = temp_counter_;
 
     ir_program_->functions.push_back(std::move(ir_func));
 }
@@ -50,25 +50,25 @@ void IRGenerator::visit(const Stmt& stmt)
 {
     if (auto* decl = dynamic_cast<const VarDeclStmt*>(&stmt))
     {
-        std::string var = decl->name;
-        var_map_[var] = var;
+        IROperand var = current_function_->variable(decl->name);
+        var_map_[decl->name] = var;
         if (decl->initializer)
         {
-            std::string init_temp = generate_expr(*decl->initializer);
+            IROperand init_temp = generate_expr(*decl->initializer);
             emit(IROpcode::ASSIGN, var, init_temp);
         }
     }
     else if (auto* assign = dynamic_cast<const AssignStmt*>(&stmt))
     {
-        std::string value_temp = generate_expr(*assign->value);
-        emit(IROpcode::ASSIGN, assign->name, value_temp);
+        IROperand value_temp = generate_expr(*assign->value);
+        emit(IROpcode::ASSIGN, current_function_->variable(assign->name), value_temp);
     }
     else if (auto* ret = dynamic_cast<const ReturnStmt*>(&stmt))
     {
         if (ret->value)
         {
-            std::string ret_temp = generate_expr(*ret->value);
-            emit(IROpcode::RETURN, "", ret_temp);
+            IROperand ret_temp = generate_expr(*ret->value);
+            emit(IROpcode::RETURN, {}, ret_temp);
         }
         else
         {
@@ -77,33 +77,36 @@ void IRGenerator::visit(const Stmt& stmt)
     }
     else if (auto* if_stmt = dynamic_cast<const IfStmt*>(&stmt))
     {
-        std::string cond_temp = generate_expr(*if_stmt->condition);
+        IROperand cond_temp = generate_expr(*if_stmt->condition);
         std::string then_label = new_label("if_then");
         std::string else_label = new_label("if_else");
         std::string end_label = new_label("if_end");
 
-        emit(IROpcode::JUMPIFNOT, "", cond_temp, else_label);
+        // Else and end blocks are created after the branches, so the jumps
+        // targeting them are patched once the blocks exist.
+        IROperand then_block = IROperand::block(static_cast<BlockId>(current_function_->blocks.size()));
+        emit(IROpcode::JUMPIFNOT, then_block, cond_temp);
+        BlockId cond_exit = current_block_;
 
         // Then branch
-        auto then_block = std::make_unique<BasicBlock>(then_label);
-        current_block_ = then_block.get();
-        current_function_->blocks.push_back(std::move(then_block));
+        start_block(then_label);
         for (const auto& s : if_stmt->then_branch)
             visit(*s);
-        emit(IROpcode::JUMP, "", end_label);
+        emit(IROpcode::JUMP);
+        BlockId then_exit = current_block_;
 
         // Else branch
-        auto else_block = std::make_unique<BasicBlock>(else_label);
-        current_block_ = else_block.get();
-        current_function_->blocks.push_back(std::move(else_block));
+        IROperand else_block = start_block(else_label);
+        patch_jump(cond_exit, else_block);
         for (const auto& s : if_stmt->else_branch)
             visit(*s);
-        emit(IROpcode::JUMP, "", end_label);
+        emit(IROpcode::JUMP);
+        BlockId else_exit = current_block_;
 
         // End
-        auto end_block = std::make_unique<BasicBlock>(end_label);
-        current_block_ = end_block.get();
-        current_function_->blocks.push_back(std::move(end_block));
+        IROperand end_block = start_block(end_label);
+        patch_jump(then_exit, end_block);
+        patch_jump(else_exit, end_block);
     }
     else if (auto* while_stmt = dynamic_cast<const WhileStmt*>(&stmt))
     {
@@ -111,27 +114,26 @@ void IRGenerator::visit(const Stmt& stmt)
         std::string body_label = new_label("while_body");
         std::string end_label = new_label("while_end");
 
-        emit(IROpcode::JUMP, cond_label);
+        emit(IROpcode::JUMP);
+        BlockId preheader = current_block_;
 
         // Cond block
-        auto cond_block = std::make_unique<BasicBlock>(cond_label);
-        current_block_ = cond_block.get();
-        current_function_->blocks.push_back(std::move(cond_block));
-        std::string cond_temp = generate_expr(*while_stmt->condition);
-        emit(IROpcode::JUMPIFNOT, "", cond_temp, end_label); // Jump if false
+        IROperand cond_block = start_block(cond_label);
+        patch_jump(preheader, cond_block);
+        IROperand cond_temp = generate_expr(*while_stmt->condition);
+        IROperand body_block = IROperand::block(static_cast<BlockId>(current_function_->blocks.size()));
+        emit(IROpcode::JUMPIFNOT, body_block, cond_temp); // Jump to end if false, patched below
+        BlockId cond_exit = current_block_;
 
         // Body block
-        auto body_block = std::make_unique<BasicBlock>(body_label);
-        current_block_ = body_block.get();
-        current_function_->blocks.push_back(std::move(body_block));
+        start_block(body_label);
         for (const auto& s : while_stmt->body)
             visit(*s);
-        emit(IROpcode::JUMP, cond_label);
+        emit(IROpcode::JUMP, {}, cond_block);
 
         // End block
-        auto end_block = std::make_unique<BasicBlock>(end_label);
-        current_block_ = end_block.get();
-        current_function_->blocks.push_back(std::move(end_block));
+        IROperand end_block = start_block(end_label);
+        patch_jump(cond_exit, end_block);
     }
     else
     {
@@ -144,18 +146,17 @@ void IRGenerator::visit(const Expr& expr)
     generate_expr(expr); // Discard result if not used
 }
 
-std::string IRGenerator::generate_expr(const Expr& expr)
+IROperand IRGenerator::generate_expr(const Expr& expr)
 {
     if (auto* lit = dynamic_cast<const IntLiteral*>(&expr))
     {
-        std::string temp = new_temp();
-        emit(IROpcode::ASSIGN, temp, std::to_string(lit->value));
-        return temp;
+        // Literals are used in place; the backend materializes them as needed.
+        return IROperand::imm(lit->value);
     }
     else if (auto* str_lit = dynamic_cast<const StringLiteral*>(&expr))
     {
-        std::string temp = new_temp();
-        emit(IROpcode::ASSIGN, temp, str_lit->value); // Assume string literals as constants
+        IROperand temp = new_temp();
+        emit(IROpcode::ASSIGN, temp, current_function_->add_string(str_lit->value));
         return temp;
     }
     else if (auto* id = dynamic_cast<const Identifier*>(&expr))
@@ -167,17 +168,18 @@ std::string IRGenerator::generate_expr(const Expr& expr)
     }
     else if (auto* unary = dynamic_cast<const UnaryExpr*>(&expr))
     {
-        std::string oper_temp = generate_expr(*unary->operand);
-        std::string result_temp = new_temp();
+        IROperand oper_temp = generate_expr(*unary->operand);
         IROpcode op = (unary->op == TokenType::OP_MINUS) ? IROpcode::NEG : IROpcode::NOT;
+        if (auto folded = fold_constant(op, oper_temp, {}))
+            return *folded;
+        IROperand result_temp = new_temp();
         emit(op, result_temp, oper_temp);
         return result_temp;
     }
     else if (auto* bin = dynamic_cast<const BinaryExpr*>(&expr))
     {
-        std::string left_temp = generate_expr(*bin->left);
-        std::string right_temp = generate_expr(*bin->right);
-        std::string result_temp = new_temp();
+        IROperand left_temp = generate_expr(*bin->left);
+        IROperand right_temp = generate_expr(*bin->right);
         IROpcode op;
         switch (bin->op)
         {
@@ -214,6 +216,10 @@ std::string IRGenerator::generate_expr(const Expr& expr)
         default:
             throw std::runtime_error("Unsupported binary operator in IR");
         }
+        // Constant subexpressions fold right away (a trapping division is kept).
+        if (auto folded = fold_constant(op, left_temp, right_temp))
+            return *folded;
+        IROperand result_temp = new_temp();
         emit(op, result_temp, left_temp, right_temp);
         return result_temp;
     }
@@ -223,9 +229,9 @@ std::string IRGenerator::generate_expr(const Expr& expr)
     }
 }
 
-std::string IRGenerator::new_temp()
+IROperand IRGenerator::new_temp()
 {
-    return "t" + std::to_string(temp_counter_++);
+    return IROperand::temp(temp_counter_++);
 }
 
 std::string IRGenerator::new_label(const std::string& prefix)
@@ -233,9 +239,28 @@ std::string IRGenerator::new_label(const std::string& prefix)
     return prefix + "_" + std::to_string(label_counter_++);
 }
 
-void IRGenerator::emit(IROpcode op, const std::string& res, const std::string& op1, const std::string& op2)
+IROperand IRGenerator::start_block(const std::string& label)
+{
+    current_block_ = current_function_->add_block(label);
+    return IROperand::block(current_block_);
+}
+
+void IRGenerator::emit(IROpcode op, IROperand res, IROperand op1, IROperand op2)
+{
+    // Code after a return in the same block is unreachable; a block keeps its first terminator.
+    auto instrs = current_function_->block_instructions(current_block_);
+    if (!instrs.empty() && instrs.back().is_terminator())
+        return;
+    current_function_->append(current_block_, IRInstruction(op, res, op1, op2));
+}
+
+void IRGenerator::patch_jump(BlockId from, IROperand target)
 {
-    current_block_->instructions.emplace_back(op, res, op1, op2);
+    IRInstruction& term = current_function_->terminator(from);
+    if (term.opcode == IROpcode::JUMP && term.operand1.empty())
+        term.operand1 = target;
+    else if (term.opcode == IROpcode::JUMPIFNOT && term.operand2.empty())
+        term.operand2 = target;
 }
 
 } // namespace minic
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "minic/IRInterpreter.hpp"
+#include <stdexcept>
+
+namespace minic
+{
+
+IRInterpreter::Result IRInterpreter::run(const IRFunction& func, const std::vector<std::int64_t>& args) const
+{
+    if (args.size() != func.parameters.size())
+        throw std::runtime_error("Function " + func.name + " expects " + std::to_string(func.parameters.size()) + " arguments");
+
+    std::vector<std::int64_t> vars(func.variables.size(), 0);
+    std::vector<std::int64_t> temps(func.temp_count, 0);
+    for (size_t i = 0; i < args.size(); ++i)
+        vars[i] = args[i];
+
+    auto read = [&](const IROperand& op) -> std::int64_t {
+        switch (op.kind)
+        {
+        case IROperandKind::TEMP:
+            return temps.at(op.value);
+        case IROperandKind::VAR:
+            return vars.at(op.value);
+        case IROperandKind::IMM:
+            return op.value;
+        case IROperandKind::STR:
+            // Stand-in address: distinct and non-zero per string.
+            return 0x10000 + op.value;
+        default:
+            return 0;
+        }
+    };
+    auto write = [&](const IROperand& op, std::int64_t value) {
+        if (op.is_temp())
+            temps.at(op.value) = value;
+        else if (op.is_var())
+            vars.at(op.value) = value;
+        else
+            throw std::runtime_error("Write to a non-location operand in " + func.name);
+    };
+
+    Result result;
+    BlockId block = 0;
+    BlockId from = -1;
+    while (true)
+    {
+        // Phis read every incoming value before any of them is written.
+        const auto& phis = func.blocks.at(block).phis;
+        if (!phis.empty())
+        {
+            std::vector<std::int64_t> values;
+            for (const auto& phi : phis)
+            {
+                IROperand in = phi.value_from(from);
+                if (in.empty())
+                    throw std::runtime_error("Phi without a value for the incoming edge in " + func.name);
+                values.push_back(read(in));
+            }
+            for (size_t i = 0; i < phis.size(); ++i)
+                write(phis[i].result, values[i]);
+        }
+
+        BlockId next = -1;
+        for (const auto& instr : func.block_instructions(block))
+        {
+            if (++result.steps > step_limit_)
+                throw std::runtime_error("Step limit exceeded in " + func.name);
+            result.cycles += estimated_cycles(instr);
+            std::int64_t a = read(instr.operand1);
+            std::int64_t b = read(instr.operand2);
+            switch (instr.opcode)
+            {
+            case IROpcode::ADD:
+            case IROpcode::SUB:
+            case IROpcode::MUL:
+            case IROpcode::DIV:
+            case IROpcode::SHL:
+            case IROpcode::SHR:
+            case IROpcode::SAR:
+            case IROpcode::MULH:
+            case IROpcode::NEG:
+            case IROpcode::NOT:
+            case IROpcode::EQ:
+            case IROpcode::NEQ:
+            case IROpcode::LT:
+            case IROpcode::GT:
+            case IROpcode::LE:
+            case IROpcode::GE:
+            case IROpcode::ASSIGN:
+            {
+                auto value = evaluate(instr.opcode, a, b);
+                if (!value)
+                    throw std::runtime_error("Division trap in " + func.name);
+                write(instr.result, *value);
+                break;
+            }
+            case IROpcode::SELECT:
+                if (a != 0)
+                    write(instr.result, b);
+                break;
+            case IROpcode::JUMP:
+                next = instr.operand1.value;
+                break;
+            case IROpcode::JUMPIF:
+                ++result.branches;
+                next = a != 0 ? instr.operand2.value : instr.result.value;
+                break;
+            case IROpcode::JUMPIFNOT:
+                ++result.branches;
+                next = a == 0 ? instr.operand2.value : instr.result.value;
+                break;
+            case IROpcode::RETURN:
+                result.value = a;
+                return result;
+            default:
+                throw std::runtime_error("Unsupported IR opcode in interpreter");
+            }
+        }
+        if (next < 0)
+            throw std::runtime_error("Block without a terminator in " + func.name);
+        from = block;
+        block = next;
+    }
+}
+
+} // namespace minic
@@ -0,0 +1,289 @@
+#include "minic/IfConversion.hpp"
+#include "minic/CFG.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief A value an arm writes that is read outside it, with the operand
+ * holding what each arm leaves in it (index 0 for the arm taken when the
+ * condition is zero, 1 for the other).
+ */
+struct Output
+{
+    IROperand slot;
+    IROperand value[2];
+    bool written[2] = { false, false };
+};
+
+class Converter
+{
+public:
+    Converter(IRFunction& func, unsigned mispredict_penalty)
+        : func_(func)
+        , cfg_(func)
+        , penalty_(mispredict_penalty)
+        , home_(func.temp_count, -1)
+    {
+        // The block every temp occurs in, or -2 when it occurs in several.
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            for (const auto& instr : func.block_instructions(id))
+            {
+                for (const IROperand& op : { instr.result, instr.operand1, instr.operand2 })
+                {
+                    if (op.is_temp())
+                        home_[op.value] = home_[op.value] == -1 || home_[op.value] == id ? id : -2;
+                }
+            }
+        }
+    }
+
+    // Convert the first profitable diamond, innermost first.
+    bool convert_one()
+    {
+        const auto& rpo = cfg_.reverse_postorder();
+        for (auto it = rpo.rbegin(); it != rpo.rend(); ++it)
+        {
+            if (convert(*it))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    IRFunction& func_;
+    ControlFlowGraph cfg_;
+    unsigned penalty_;
+    std::vector<BlockId> home_;
+
+    // The block an arm jumps to, or -1 if the block cannot be executed speculatively from head.
+    BlockId join_of(BlockId arm, BlockId head) const
+    {
+        if (arm == 0 || arm == head || cfg_.predecessors(arm) != std::vector<BlockId> { head })
+            return -1;
+        auto instrs = func_.block_instructions(arm);
+        if (instrs.back().opcode != IROpcode::JUMP)
+            return -1;
+        for (size_t i = 0; i + 1 < instrs.size(); ++i)
+        {
+            const IRInstruction& instr = instrs[i];
+            // A select from a diamond converted earlier cannot trap either.
+            if (!(is_speculatable(instr) || instr.opcode == IROpcode::SELECT) || !(instr.result.is_temp() || instr.result.is_var()))
+                return -1;
+        }
+        return instrs.back().operand1.value;
+    }
+
+    bool convert(BlockId head)
+    {
+        const IRInstruction& term = func_.terminator(head);
+        if (term.opcode != IROpcode::JUMPIF && term.opcode != IROpcode::JUMPIFNOT)
+            return false;
+        const IROperand cond = term.operand1;
+        const BlockId set = term.opcode == IROpcode::JUMPIF ? term.operand2.value : term.result.value;
+        const BlockId clear = term.opcode == IROpcode::JUMPIF ? term.result.value : term.operand2.value;
+        if (set == clear)
+            return false;
+
+        // arms[0] runs when the condition is zero, arms[1] otherwise; -1 when that side goes straight to the join.
+        BlockId arms[2] = { -1, -1 };
+        BlockId join = -1;
+        const BlockId set_join = join_of(set, head);
+        const BlockId clear_join = join_of(clear, head);
+        if (set_join >= 0 && set_join == clear_join)
+        {
+            arms[0] = clear;
+            arms[1] = set;
+            join = set_join;
+        }
+        else if (set_join >= 0 && set_join == clear)
+        {
+            arms[1] = set;
+            join = clear;
+        }
+        else if (clear_join >= 0 && clear_join == set)
+        {
+            arms[0] = clear;
+            join = set;
+        }
+        else
+        {
+            return false;
+        }
+        if (join == head || join == arms[0] || join == arms[1])
+            return false;
+
+        std::vector<IROperand> written;
+        for (BlockId arm : arms)
+        {
+            if (arm < 0)
+                continue;
+            for (const auto& instr : func_.block_instructions(arm))
+            {
+                if (!instr.is_terminator())
+                    written.push_back(instr.result);
+            }
+        }
+        auto is_written = [&](const IROperand& op) { return std::ranges::find(written, op) != written.end(); };
+        // The selects read the condition after both arms ran.
+        if (is_written(cond))
+            return false;
+
+        const std::int32_t temp_count = func_.temp_count;
+        auto head_instrs = func_.block_instructions(head);
+        std::vector<IRInstruction> code(head_instrs.begin(), head_instrs.end() - 1);
+        const size_t speculated = code.size();
+        std::vector<Output> outputs;
+        // Twice the expected cost with the branch: its jump, one arm on average and a
+        // mispredict half the time.
+        std::uint64_t branchy = 2 + penalty_;
+        for (int side : { 1, 0 })
+        {
+            const BlockId arm = arms[side];
+            if (arm < 0)
+                continue;
+            std::vector<std::pair<IROperand, IROperand>> renamed;
+            std::vector<IROperand> defined;
+            std::vector<IROperand> exposed;
+            auto rename = [&](IROperand& op) {
+                if (op.is_temp() && home_[op.value] == arm && std::ranges::find(defined, op) == defined.end())
+                    exposed.push_back(op);
+                for (const auto& [from, to] : renamed)
+                {
+                    if (op == from)
+                        op = to;
+                }
+            };
+            for (const auto& instr : func_.block_instructions(arm))
+            {
+                branchy += estimated_cycles(instr);
+                if (instr.is_terminator())
+                    continue;
+                IRInstruction copy = instr;
+                rename(copy.operand1);
+                rename(copy.operand2);
+                // A select also reads the value it may keep.
+                IROperand kept = instr.result;
+                if (instr.opcode == IROpcode::SELECT)
+                    rename(kept);
+                defined.push_back(instr.result);
+
+                // A temp only this arm touches, and writes before reading, needs no select.
+                if (instr.result.is_temp() && home_[instr.result.value] == arm && std::ranges::find(exposed, instr.result) == exposed.end())
+                {
+                    code.push_back(copy);
+                    continue;
+                }
+
+                IROperand value;
+                const IROperand& src = copy.operand1;
+                if (copy.opcode == IROpcode::ASSIGN && (src.is_imm() || ((src.is_temp() || src.is_var()) && !is_written(src))))
+                {
+                    value = src;
+                }
+                else
+                {
+                    value = func_.new_temp();
+                    if (copy.opcode == IROpcode::SELECT)
+                        code.emplace_back(IROpcode::ASSIGN, value, kept);
+                    copy.result = value;
+                    code.push_back(copy);
+                }
+                std::erase_if(renamed, [&](const auto& entry) { return entry.first == instr.result; });
+                renamed.emplace_back(instr.result, value);
+
+                auto out = std::ranges::find(outputs, instr.result, &Output::slot);
+                if (out == outputs.end())
+                {
+                    outputs.push_back({ instr.result, {}, {} });
+                    out = outputs.end() - 1;
+                }
+                out->value[side] = value;
+                out->written[side] = true;
+            }
+        }
+
+        for (const Output& out : outputs)
+        {
+            if (out.written[0] && out.written[1])
+            {
+                code.emplace_back(IROpcode::ASSIGN, out.slot, out.value[0]);
+                code.emplace_back(IROpcode::SELECT, out.slot, cond, out.value[1]);
+            }
+            else if (out.written[1])
+            {
+                code.emplace_back(IROpcode::SELECT, out.slot, cond, out.value[1]);
+            }
+            else
+            {
+                // Only the zero side writes it: keep the old value for the other.
+                IROperand old = func_.new_temp();
+                code.emplace_back(IROpcode::ASSIGN, old, out.slot);
+                code.emplace_back(IROpcode::ASSIGN, out.slot, out.value[0]);
+                code.emplace_back(IROpcode::SELECT, out.slot, cond, old);
+            }
+        }
+        code.emplace_back(IROpcode::JUMP, IROperand {}, IROperand::block(join));
+
+        // Both arms always run now, against one on average with a branch that
+        // the target mispredicts about half the time.
+        std::uint64_t straight = 0;
+        for (size_t i = speculated; i < code.size(); ++i)
+            straight += estimated_cycles(code[i]);
+        if (2 * straight >= branchy)
+        {
+            func_.temp_count = temp_count;
+            return false;
+        }
+
+        std::vector<bool> dead(func_.blocks.size(), false);
+        for (BlockId arm : arms)
+        {
+            if (arm >= 0)
+                dead[arm] = true;
+        }
+        // A join only the diamond reached becomes part of the head, so an enclosing diamond can convert next.
+        const auto& preds = cfg_.predecessors(join);
+        if (join != 0 && std::ranges::all_of(preds, [&](BlockId pred) { return pred == head || dead[pred]; }))
+        {
+            code.pop_back();
+            auto join_instrs = func_.block_instructions(join);
+            code.insert(code.end(), join_instrs.begin(), join_instrs.end());
+            dead[join] = true;
+        }
+        func_.set_block_instructions(head, code);
+        func_.remove_blocks(dead);
+        return true;
+    }
+};
+
+} // namespace
+
+IfConversion::IfConversion(unsigned mispredict_penalty)
+    : mispredict_penalty_(mispredict_penalty)
+{
+}
+
+bool IfConversion::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+    for (const auto& block : func.blocks)
+    {
+        if (!block.phis.empty())
+            return false;
+    }
+
+    bool changed = false;
+    while (Converter(func, mispredict_penalty_).convert_one())
+        changed = true;
+    return changed;
+}
+
+} // namespace minic
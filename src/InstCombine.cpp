@@ -0,0 +1,290 @@
+#include "minic/InstCombine.hpp"
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+bool is_binary(IROpcode op)
+{
+    switch (op)
+    {
+    case IROpcode::ADD:
+    case IROpcode::SUB:
+    case IROpcode::MUL:
+    case IROpcode::DIV:
+    case IROpcode::EQ:
+    case IROpcode::NEQ:
+    case IROpcode::LT:
+    case IROpcode::GT:
+    case IROpcode::LE:
+    case IROpcode::GE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief One rewrite sweep over a function, with def information computed up front.
+ */
+class Combiner
+{
+public:
+    explicit Combiner(IRFunction& func)
+        : func_(func)
+        , temp_defs_(func.temp_count, 0)
+        , temp_def_index_(func.temp_count, -1)
+        , var_written_(func.variables.size(), false)
+    {
+        for (const auto& block : func_.blocks)
+        {
+            for (const auto& phi : block.phis)
+                note_def(phi.result, -1);
+            for (std::uint32_t i = block.begin; i < block.begin + block.size; ++i)
+            {
+                const IRInstruction& instr = func_.instructions[i];
+                if (!instr.is_terminator())
+                    note_def(instr.result, static_cast<std::int64_t>(i));
+            }
+        }
+    }
+
+    bool sweep()
+    {
+        bool changed = false;
+        for (BlockId id = 0; id < static_cast<BlockId>(func_.blocks.size()); ++id)
+        {
+            const BasicBlock& block = func_.blocks[id];
+            for (std::uint32_t i = block.begin; i < block.begin + block.size; ++i)
+            {
+                IRInstruction& instr = func_.instructions[i];
+                bool uses_operand2 = !instr.is_terminator();
+                bool uses_operand1 = uses_operand2 || instr.opcode != IROpcode::JUMP;
+                if (uses_operand1)
+                    changed |= substitute(instr.operand1);
+                if (uses_operand2)
+                    changed |= substitute(instr.operand2);
+                changed |= simplify(id, instr);
+            }
+        }
+        for (auto& block : func_.blocks)
+        {
+            for (auto& phi : block.phis)
+            {
+                for (auto& in : phi.incoming)
+                    changed |= substitute(in.value);
+            }
+        }
+        return changed;
+    }
+
+private:
+    void note_def(const IROperand& op, std::int64_t index)
+    {
+        if (op.is_var())
+        {
+            var_written_.at(op.value) = true;
+        }
+        else if (op.is_temp())
+        {
+            ++temp_defs_.at(op.value);
+            temp_def_index_[op.value] = index;
+        }
+    }
+
+    /**
+     * @brief Whether an operand names the same value everywhere it is dominated by its definition.
+     */
+    bool stable(const IROperand& op) const
+    {
+        if (op.is_temp())
+            return temp_defs_[op.value] == 1;
+        if (op.is_var())
+            return !var_written_[op.value];
+        return op.is_imm() || op.is_str();
+    }
+
+    /**
+     * @brief The single instruction defining a temp, or nullptr.
+     */
+    const IRInstruction* def_of(const IROperand& op) const
+    {
+        if (!op.is_temp() || temp_defs_[op.value] != 1 || temp_def_index_[op.value] < 0)
+            return nullptr;
+        return &func_.instructions[temp_def_index_[op.value]];
+    }
+
+    bool substitute(IROperand& op) const
+    {
+        const IRInstruction* def = def_of(op);
+        if (!def || def->opcode != IROpcode::ASSIGN || !def->operand1.is_imm())
+            return false;
+        op = def->operand1;
+        return true;
+    }
+
+    bool simplify(BlockId block, IRInstruction& instr)
+    {
+        if (instr.opcode == IROpcode::JUMPIF || instr.opcode == IROpcode::JUMPIFNOT)
+            return simplify_branch(block, instr);
+        if (instr.opcode == IROpcode::NEG || instr.opcode == IROpcode::NOT)
+            return simplify_unary(instr);
+        if (is_binary(instr.opcode))
+            return simplify_binary(instr);
+        return false;
+    }
+
+    static bool set(IRInstruction& instr, IROpcode op, IROperand a, IROperand b = {})
+    {
+        instr.opcode = op;
+        instr.operand1 = a;
+        instr.operand2 = b;
+        return true;
+    }
+
+    bool simplify_unary(IRInstruction& instr)
+    {
+        if (auto folded = fold_constant(instr.opcode, instr.operand1, {}))
+            return set(instr, IROpcode::ASSIGN, *folded);
+        const IRInstruction* def = def_of(instr.operand1);
+        if (!def)
+            return false;
+        if (instr.opcode == IROpcode::NEG && def->opcode == IROpcode::NEG && stable(def->operand1))
+            return set(instr, IROpcode::ASSIGN, def->operand1);
+        if (instr.opcode == IROpcode::NOT && is_comparison(def->opcode) && stable(def->operand1) && stable(def->operand2))
+            return set(instr, invert_comparison(def->opcode), def->operand1, def->operand2);
+        if (instr.opcode == IROpcode::NOT && def->opcode == IROpcode::NOT && stable(def->operand1))
+            return set(instr, IROpcode::NEQ, def->operand1, IROperand::imm(0));
+        return false;
+    }
+
+    bool simplify_binary(IRInstruction& instr)
+    {
+        if (auto folded = fold_constant(instr.opcode, instr.operand1, instr.operand2))
+            return set(instr, IROpcode::ASSIGN, *folded);
+
+        bool changed = false;
+        IROperand& a = instr.operand1;
+        IROperand& b = instr.operand2;
+        if (a.is_imm() && !b.is_imm())
+        {
+            if (instr.opcode == IROpcode::SUB && a.value == 0)
+                return set(instr, IROpcode::NEG, b);
+            if (instr.opcode == IROpcode::ADD || instr.opcode == IROpcode::MUL || is_comparison(instr.opcode))
+            {
+                // Keep immediates in operand2.
+                std::swap(a, b);
+                instr.opcode = swap_comparison(instr.opcode);
+                changed = true;
+            }
+        }
+
+        if (a == b && instr.opcode != IROpcode::DIV && instr.opcode != IROpcode::ADD && instr.opcode != IROpcode::MUL)
+        {
+            bool reflexive = instr.opcode == IROpcode::EQ || instr.opcode == IROpcode::LE || instr.opcode == IROpcode::GE;
+            return set(instr, IROpcode::ASSIGN, IROperand::imm(reflexive ? 1 : 0));
+        }
+
+        if (!b.is_imm())
+            return changed;
+        const std::int32_t c = b.value;
+        switch (instr.opcode)
+        {
+        case IROpcode::ADD:
+        case IROpcode::SUB:
+            if (c == 0)
+                return set(instr, IROpcode::ASSIGN, a);
+            if (instr.opcode == IROpcode::SUB && c != std::numeric_limits<std::int32_t>::min())
+                return set(instr, IROpcode::ADD, a, IROperand::imm(-c));
+            break;
+        case IROpcode::MUL:
+            if (c == 0)
+                return set(instr, IROpcode::ASSIGN, IROperand::imm(0));
+            if (c == 1)
+                return set(instr, IROpcode::ASSIGN, a);
+            break;
+        case IROpcode::DIV:
+            if (c == 1)
+                return set(instr, IROpcode::ASSIGN, a);
+            break;
+        default:
+            break;
+        }
+
+        // (x op c1) op c2 -> x op (c1 op c2) for the associative ADD and MUL.
+        if (instr.opcode == IROpcode::ADD || instr.opcode == IROpcode::MUL)
+        {
+            const IRInstruction* def = def_of(a);
+            if (def && def->opcode == instr.opcode && def->operand2.is_imm() && stable(def->operand1))
+            {
+                if (auto combined = fold_constant(instr.opcode, def->operand2, b))
+                    return set(instr, instr.opcode, def->operand1, *combined);
+            }
+        }
+        return changed;
+    }
+
+    bool simplify_branch(BlockId block, IRInstruction& instr)
+    {
+        const IROperand cond = instr.operand1;
+        if (cond.is_imm() || instr.operand2 == instr.result)
+        {
+            bool to_operand2 = instr.opcode == IROpcode::JUMPIF ? cond.value != 0 : cond.value == 0;
+            IROperand taken = to_operand2 ? instr.operand2 : instr.result;
+            IROperand dropped = to_operand2 ? instr.result : instr.operand2;
+            if (!(dropped == taken))
+            {
+                for (auto& phi : func_.blocks[dropped.value].phis)
+                    std::erase_if(phi.incoming, [&](const PhiIncoming& in) { return in.block == block; });
+            }
+            instr = IRInstruction(IROpcode::JUMP, {}, taken);
+            return true;
+        }
+
+        const IRInstruction* def = def_of(cond);
+        if (!def)
+            return false;
+        auto flip = [&] { instr.opcode = instr.opcode == IROpcode::JUMPIF ? IROpcode::JUMPIFNOT : IROpcode::JUMPIF; };
+        bool against_zero = def->operand2 == IROperand::imm(0) && stable(def->operand1);
+        if (def->opcode == IROpcode::NOT && stable(def->operand1))
+        {
+            flip();
+            instr.operand1 = def->operand1;
+            return true;
+        }
+        if (def->opcode == IROpcode::NEQ && against_zero)
+        {
+            instr.operand1 = def->operand1;
+            return true;
+        }
+        if (def->opcode == IROpcode::EQ && against_zero)
+        {
+            flip();
+            instr.operand1 = def->operand1;
+            return true;
+        }
+        return false;
+    }
+
+    IRFunction& func_;
+    std::vector<int> temp_defs_; ///< Number of definitions per temp (phis included)
+    std::vector<std::int64_t> temp_def_index_; ///< Arena index of a temp's defining instruction, -1 for phis
+    std::vector<bool> var_written_; ///< Whether any instruction writes the variable
+};
+
+} // namespace
+
+bool InstCombine::run(IRFunction& func)
+{
+    bool changed = false;
+    while (Combiner(func).sweep())
+        changed = true;
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,280 @@
+#include "minic/JumpThreading.hpp"
+#include "minic/CFG.hpp"
+#include "minic/SSA.hpp"
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/// Blocks with more instructions than this are never cloned.
+constexpr size_t kMaxBlockSize = 8;
+/// Blocks walked up from an edge to collect the branch outcomes on the way.
+constexpr int kMaxWalk = 8;
+/// Definitions followed when evaluating a condition.
+constexpr int kMaxDepth = 16;
+
+/**
+ * @brief The outcome of `a op b` once `a known_op b` is known to be `known`, if
+ * that settles it.
+ */
+std::optional<bool> implied(IROpcode known_op, bool known, IROpcode op)
+{
+    // a is below, equal to or above b; try each order known_op allows.
+    std::optional<bool> result;
+    for (std::int64_t a : { -1, 0, 1 })
+    {
+        if ((*evaluate(known_op, a, 0) != 0) != known)
+            continue;
+        bool outcome = *evaluate(op, a, 0) != 0;
+        if (result && *result != outcome)
+            return std::nullopt;
+        result = outcome;
+    }
+    return result;
+}
+
+/**
+ * @brief A branch condition known to be zero or non-zero on the way to an edge.
+ */
+struct Fact
+{
+    IROperand cond;
+    bool nonzero;
+};
+
+/**
+ * @brief What the values a block reads are known to be when control enters it
+ * from one predecessor.
+ */
+class EdgeEvaluator
+{
+public:
+    EdgeEvaluator(const IRFunction& func, const ControlFlowGraph& cfg, const std::vector<BlockId>& def_block,
+        const std::vector<const IRInstruction*>& def, BlockId pred, BlockId block)
+        : func_(func)
+        , def_block_(def_block)
+        , def_(def)
+        , pred_(pred)
+        , block_(block)
+    {
+        // A condition defined in a block between the branch and the edge was
+        // redefined after it was tested, so only older definitions count.
+        std::vector<BlockId> walked { block };
+        BlockId to = block;
+        BlockId from = pred;
+        for (int step = 0; step < kMaxWalk && std::ranges::find(walked, from) == walked.end(); ++step)
+        {
+            const IRInstruction& term = func.terminator(from);
+            if ((term.opcode == IROpcode::JUMPIF || term.opcode == IROpcode::JUMPIFNOT) && !(term.operand2 == term.result)
+                && term.operand1.is_temp() && std::ranges::find(walked, def_block[term.operand1.value]) == walked.end())
+            {
+                facts_.push_back({ term.operand1, (term.opcode == IROpcode::JUMPIF) == (term.operand2.value == to) });
+            }
+            walked.push_back(from);
+            if (cfg.predecessors(from).size() != 1)
+                break;
+            to = from;
+            from = cfg.predecessors(from)[0];
+        }
+    }
+
+    /**
+     * @brief Whether an operand read in the block is non-zero, if that is known.
+     */
+    std::optional<bool> truth(const IROperand& op) const { return truth(op, true, 0); }
+
+private:
+    /**
+     * @brief Whether a temp is defined in the block and read in it (rather than
+     * an earlier instance of it flowing into the block).
+     */
+    bool local(const IROperand& op, bool inside) const
+    {
+        return inside && op.is_temp() && def_block_[op.value] == block_;
+    }
+
+    /**
+     * @brief The value an operand stands for outside the block: phis become
+     * their incoming value from the predecessor and copies their source.
+     */
+    IROperand resolve(const IROperand& op, bool inside) const
+    {
+        if (!local(op, inside))
+            return op;
+        for (const auto& phi : func_.blocks[block_].phis)
+        {
+            if (phi.result == op)
+                return phi.value_from(pred_);
+        }
+        const IRInstruction* def = def_[op.value];
+        if (def && def->opcode == IROpcode::ASSIGN)
+            return resolve(def->operand1, true);
+        return op;
+    }
+
+    std::optional<bool> truth(const IROperand& op, bool inside, int depth) const
+    {
+        if (auto v = value(op, inside, depth))
+            return *v != 0;
+        IROperand outer = resolve(op, inside);
+        for (const Fact& fact : facts_)
+        {
+            if (fact.cond == outer)
+                return fact.nonzero;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::int64_t> value(const IROperand& op, bool inside, int depth) const
+    {
+        IROperand outer = resolve(op, inside);
+        if (outer.is_imm())
+            return outer.value;
+        if (!outer.is_temp() || depth > kMaxDepth)
+            return std::nullopt;
+        const bool in_block = local(outer, inside);
+        const IRInstruction* def = def_[outer.value];
+        if (!in_block)
+        {
+            for (const Fact& fact : facts_)
+            {
+                if (fact.cond == outer && !fact.nonzero)
+                    return 0;
+                if (fact.cond == outer && def && (is_comparison(def->opcode) || def->opcode == IROpcode::NOT))
+                    return 1;
+            }
+        }
+        if (!def)
+            return std::nullopt;
+        if (def->opcode == IROpcode::NOT)
+        {
+            if (auto t = truth(def->operand1, in_block, depth + 1))
+                return *t ? 0 : 1;
+            return std::nullopt;
+        }
+        auto a = value(def->operand1, in_block, depth + 1);
+        auto b = def->operand2.empty() ? std::optional<std::int64_t>(0) : value(def->operand2, in_block, depth + 1);
+        if (a && b)
+            return evaluate(def->opcode, *a, *b);
+        if (!is_comparison(def->opcode))
+            return std::nullopt;
+
+        // A branch on a comparison of the same operands settles this one.
+        IROperand lhs = resolve(def->operand1, in_block);
+        IROperand rhs = resolve(def->operand2, in_block);
+        for (const Fact& fact : facts_)
+        {
+            const IRInstruction* tested = def_[fact.cond.value];
+            if (!tested || !is_comparison(tested->opcode))
+                continue;
+            std::optional<bool> outcome;
+            if (tested->operand1 == lhs && tested->operand2 == rhs)
+                outcome = implied(tested->opcode, fact.nonzero, def->opcode);
+            else if (tested->operand1 == rhs && tested->operand2 == lhs)
+                outcome = implied(swap_comparison(tested->opcode), fact.nonzero, def->opcode);
+            if (outcome)
+                return *outcome ? 1 : 0;
+        }
+        return std::nullopt;
+    }
+
+    const IRFunction& func_;
+    const std::vector<BlockId>& def_block_;
+    const std::vector<const IRInstruction*>& def_;
+    BlockId pred_;
+    BlockId block_;
+    std::vector<Fact> facts_; ///< Branch outcomes on the way to the edge, nearest first
+};
+
+/**
+ * @brief Give the edge pred -> block its own copy of block that jumps to target.
+ */
+void thread_edge(IRFunction& func, BlockId pred, BlockId block, BlockId target)
+{
+    BlockId clone = func.add_block(func.new_label("threaded"));
+    std::vector<IRInstruction> instrs(func.block_instructions(block).begin(), func.block_instructions(block).end());
+    instrs.back() = IRInstruction(IROpcode::JUMP, {}, IROperand::block(target));
+    func.set_block_instructions(clone, instrs);
+    for (auto& phi : func.blocks[block].phis)
+    {
+        func.blocks[clone].phis.push_back({ phi.result, { { pred, phi.value_from(pred) } } });
+        std::erase_if(phi.incoming, [&](const PhiIncoming& in) { return in.block == pred; });
+    }
+    for (auto& phi : func.blocks[target].phis)
+        phi.incoming.push_back({ clone, phi.value_from(block) });
+    func.terminator(pred).retarget(block, clone);
+}
+
+} // namespace
+
+JumpThreading::JumpThreading(size_t budget)
+    : budget_(budget)
+{
+}
+
+bool JumpThreading::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = false;
+    size_t spent = 0;
+    for (bool threaded = true; threaded;)
+    {
+        threaded = false;
+        ControlFlowGraph cfg(func);
+        std::vector<BlockId> def_block(func.temp_count, -1);
+        std::vector<const IRInstruction*> def(func.temp_count, nullptr);
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            for (const auto& phi : func.blocks[id].phis)
+                def_block[phi.result.value] = id;
+            for (const auto& instr : func.block_instructions(id))
+            {
+                if (!instr.is_terminator() && instr.result.is_temp())
+                {
+                    def_block[instr.result.value] = id;
+                    def[instr.result.value] = &instr;
+                }
+            }
+        }
+
+        for (BlockId block : cfg.reverse_postorder())
+        {
+            const IRInstruction& term = func.terminator(block);
+            const size_t size = func.block_instructions(block).size();
+            if ((term.opcode != IROpcode::JUMPIF && term.opcode != IROpcode::JUMPIFNOT) || term.operand2 == term.result
+                || size > kMaxBlockSize || spent + size > budget_)
+                continue;
+            const auto& preds = cfg.predecessors(block);
+            if (std::ranges::any_of(preds, [&](BlockId pred) { return cfg.dominates(block, pred); }))
+                continue;
+
+            for (BlockId pred : preds)
+            {
+                auto known = EdgeEvaluator(func, cfg, def_block, def, pred, block).truth(term.operand1);
+                if (!known)
+                    continue;
+                const bool jumpif = term.opcode == IROpcode::JUMPIF;
+                thread_edge(func, pred, block, jumpif == *known ? term.operand2.value : term.result.value);
+                spent += size;
+                threaded = changed = true;
+                break;
+            }
+            if (threaded)
+                break;
+        }
+
+        // The clone defines the same temps as the original; renaming them restores SSA form.
+        if (threaded)
+            SSAConstruction().run(func);
+    }
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,93 @@
+#include "minic/LICM.hpp"
+#include "minic/Loops.hpp"
+#include <vector>
+
+namespace minic
+{
+
+bool LICM::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = ensure_preheaders(func);
+    ControlFlowGraph cfg(func);
+    LoopInfo loops(cfg);
+    std::vector<int> temp_defs(func.temp_count, 0);
+    std::vector<BlockId> def_block(func.temp_count, -1);
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        for (const auto& phi : func.blocks[id].phis)
+        {
+            ++temp_defs.at(phi.result.value);
+            def_block[phi.result.value] = id;
+        }
+        for (const auto& instr : func.block_instructions(id))
+        {
+            if (!instr.is_terminator() && instr.result.is_temp())
+            {
+                ++temp_defs.at(instr.result.value);
+                def_block[instr.result.value] = id;
+            }
+        }
+    }
+
+    // Innermost loops first, so what leaves an inner loop can leave the outer one too.
+    for (auto loop = loops.loops().rbegin(); loop != loops.loops().rend(); ++loop)
+    {
+        BlockId preheader = ensure_preheader(func, cfg, *loop);
+        if (preheader < 0)
+            continue;
+
+        std::vector<bool> written(func.variables.size(), false);
+        for (BlockId id : loop->blocks)
+        {
+            for (const auto& instr : func.block_instructions(id))
+            {
+                if (!instr.is_terminator() && instr.result.is_var())
+                    written[instr.result.value] = true;
+            }
+        }
+        auto invariant = [&](const IROperand& op) {
+            if (op.is_temp())
+                return temp_defs[op.value] == 1 && !loop->contains(def_block[op.value]);
+            if (op.is_var())
+                return !written[op.value];
+            return op.is_imm() || op.empty();
+        };
+
+        std::vector<IRInstruction> hoisted;
+        for (BlockId id : cfg.reverse_postorder())
+        {
+            if (!loop->contains(id))
+                continue;
+            std::vector<IRInstruction> kept;
+            auto instrs = func.block_instructions(id);
+            for (const auto& instr : instrs)
+            {
+                bool movable = !instr.is_terminator() && instr.result.is_temp() && temp_defs[instr.result.value] == 1 && is_speculatable(instr);
+                if (movable && invariant(instr.operand1) && invariant(instr.operand2))
+                {
+                    hoisted.push_back(instr);
+                    def_block[instr.result.value] = preheader;
+                    continue;
+                }
+                kept.push_back(instr);
+            }
+            if (kept.size() != instrs.size())
+                func.set_block_instructions(id, kept);
+        }
+        if (hoisted.empty())
+            continue;
+
+        auto instrs = func.block_instructions(preheader);
+        std::vector<IRInstruction> merged(instrs.begin(), instrs.end() - 1);
+        merged.insert(merged.end(), hoisted.begin(), hoisted.end());
+        merged.push_back(instrs.back());
+        func.set_block_instructions(preheader, merged);
+        changed = true;
+    }
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,178 @@
+#include "minic/LSR.hpp"
+#include "minic/Loops.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief A reduced product: the phi that tracks ivs[iv] * stride.
+ */
+struct Reduction
+{
+    size_t iv;
+    IROperand stride;
+    IROperand phi;
+};
+
+} // namespace
+
+bool LoopStrengthReduction::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = ensure_preheaders(func);
+    ControlFlowGraph cfg(func);
+    LoopInfo loops(cfg);
+    std::vector<int> temp_defs(func.temp_count, 0);
+    std::vector<BlockId> def_block(func.temp_count, -1);
+    std::vector<bool> var_written(func.variables.size(), false);
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        for (const auto& phi : func.blocks[id].phis)
+        {
+            ++temp_defs.at(phi.result.value);
+            def_block[phi.result.value] = id;
+        }
+        for (const auto& instr : func.block_instructions(id))
+        {
+            if (instr.is_terminator())
+                continue;
+            if (instr.result.is_temp())
+            {
+                ++temp_defs.at(instr.result.value);
+                def_block[instr.result.value] = id;
+            }
+            else if (instr.result.is_var())
+                var_written.at(instr.result.value) = true;
+        }
+    }
+
+    for (auto loop = loops.loops().rbegin(); loop != loops.loops().rend(); ++loop)
+    {
+        BlockId preheader = ensure_preheader(func, cfg, *loop);
+        if (preheader < 0)
+            continue;
+        std::vector<InductionVariable> ivs = find_induction_variables(func, cfg, *loop);
+        if (ivs.empty())
+            continue;
+        const BlockId latch = loop->latches[0];
+
+        auto invariant = [&](const IROperand& op) {
+            if (op.is_temp())
+                return temp_defs[op.value] == 1 && !loop->contains(def_block[op.value]);
+            if (op.is_var())
+                return !var_written[op.value];
+            return op.is_imm();
+        };
+        // Code for the end of the preheader (before its jump) and of the latch.
+        std::vector<IRInstruction> setup;
+        std::vector<IRInstruction> updates;
+        auto fresh = [&](BlockId id) {
+            temp_defs.push_back(1);
+            def_block.push_back(id);
+            return func.new_temp();
+        };
+        auto compute = [&](IROpcode op, const IROperand& a, const IROperand& b) {
+            if (auto folded = fold_constant(op, a, b))
+                return *folded;
+            IROperand t = fresh(preheader);
+            setup.push_back(IRInstruction(op, t, a, b));
+            return t;
+        };
+
+        std::vector<Reduction> reductions;
+        auto reduce = [&](size_t iv, const IROperand& stride) {
+            for (const auto& r : reductions)
+            {
+                if (r.iv == iv && r.stride == stride)
+                    return r.phi;
+            }
+            IROperand start = compute(IROpcode::MUL, ivs[iv].init, stride);
+            IROperand step = compute(IROpcode::MUL, IROperand::imm(ivs[iv].step), stride);
+            IROperand phi = fresh(loop->header);
+            IROperand next = fresh(latch);
+            func.blocks[loop->header].phis.push_back({ phi, { { preheader, start }, { latch, next } } });
+            updates.push_back(IRInstruction(IROpcode::ADD, next, phi, step));
+            reductions.push_back({ iv, stride, phi });
+            return phi;
+        };
+
+        for (BlockId id : loop->blocks)
+        {
+            bool rewritten = false;
+            std::vector<IRInstruction> instrs(func.block_instructions(id).begin(), func.block_instructions(id).end());
+            for (auto& instr : instrs)
+            {
+                if (instr.opcode != IROpcode::MUL || !instr.result.is_temp() || temp_defs[instr.result.value] != 1)
+                    continue;
+                for (size_t iv = 0; iv < ivs.size(); ++iv)
+                {
+                    const IROperand& phi = ivs[iv].phi;
+                    const IROperand* stride = instr.operand1 == phi ? &instr.operand2 : instr.operand2 == phi ? &instr.operand1 : nullptr;
+                    if (!stride || !invariant(*stride) || !invariant(ivs[iv].init))
+                        continue;
+                    instr = IRInstruction(IROpcode::ASSIGN, instr.result, reduce(iv, *stride));
+                    rewritten = true;
+                    break;
+                }
+            }
+            if (rewritten)
+                func.set_block_instructions(id, instrs);
+        }
+
+        // Induction variables in lockstep with an earlier one: k == i + (k0 - i0) throughout.
+        std::vector<IRInstruction> derived;
+        std::vector<IROperand> replaced;
+        for (size_t k = 0; k < ivs.size(); ++k)
+        {
+            for (size_t i = 0; i < k; ++i)
+            {
+                if (ivs[i].step != ivs[k].step || std::find(replaced.begin(), replaced.end(), ivs[i].phi) != replaced.end())
+                    continue;
+                IROperand offset;
+                if (ivs[i].init == ivs[k].init)
+                    offset = IROperand::imm(0);
+                else if (auto folded = fold_constant(IROpcode::SUB, ivs[k].init, ivs[i].init))
+                    offset = *folded;
+                else
+                    continue;
+                derived.push_back(offset.value == 0 ? IRInstruction(IROpcode::ASSIGN, ivs[k].phi, ivs[i].phi)
+                                                    : IRInstruction(IROpcode::ADD, ivs[k].phi, ivs[i].phi, offset));
+                replaced.push_back(ivs[k].phi);
+                break;
+            }
+        }
+
+        if (setup.empty() && updates.empty() && derived.empty())
+            continue;
+        changed = true;
+        if (!derived.empty())
+        {
+            auto& phis = func.blocks[loop->header].phis;
+            std::erase_if(phis, [&](const PhiNode& phi) { return std::find(replaced.begin(), replaced.end(), phi.result) != replaced.end(); });
+            auto instrs = func.block_instructions(loop->header);
+            derived.insert(derived.end(), instrs.begin(), instrs.end());
+            func.set_block_instructions(loop->header, derived);
+        }
+        auto insert_before_terminator = [&](BlockId id, const std::vector<IRInstruction>& code) {
+            if (code.empty())
+                return;
+            auto instrs = func.block_instructions(id);
+            std::vector<IRInstruction> merged(instrs.begin(), instrs.end() - 1);
+            merged.insert(merged.end(), code.begin(), code.end());
+            merged.push_back(instrs.back());
+            func.set_block_instructions(id, merged);
+        };
+        insert_before_terminator(preheader, setup);
+        insert_before_terminator(latch, updates);
+    }
+    return changed;
+}
+
+} // namespace minic
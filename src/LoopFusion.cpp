@@ -0,0 +1,194 @@
+#include "minic/LoopFusion.hpp"
+#include "minic/Loops.hpp"
+#include "minic/ScalarEvolution.hpp"
+#include <optional>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief The blocks around a loop that is tested at the top.
+ */
+struct LoopShape
+{
+    BlockId preheader;
+    BlockId latch;
+    BlockId entry; ///< First block of the body
+    BlockId exit;
+};
+
+std::optional<LoopShape> shape_of(const IRFunction& func, const ControlFlowGraph& cfg, const Loop& loop)
+{
+    const BlockId header = loop.header;
+    if (loop.latches.size() != 1 || loop.exits.size() != 1 || cfg.predecessors(header).size() != 2)
+        return std::nullopt;
+    LoopShape shape;
+    shape.latch = loop.latches[0];
+    shape.exit = loop.exits[0];
+    const IRInstruction& test = func.terminator(header);
+    if (test.opcode != IROpcode::JUMPIF && test.opcode != IROpcode::JUMPIFNOT)
+        return std::nullopt;
+    shape.entry = loop.contains(test.operand2.value) ? test.operand2.value : test.result.value;
+    shape.preheader = cfg.predecessors(header)[0] == shape.latch ? cfg.predecessors(header)[1] : cfg.predecessors(header)[0];
+    if (shape.latch == header || shape.entry == header || func.terminator(shape.latch).opcode != IROpcode::JUMP
+        || func.terminator(shape.preheader).opcode != IROpcode::JUMP || cfg.predecessors(shape.entry).size() != 1
+        || cfg.predecessors(shape.exit).size() != 1)
+        return std::nullopt;
+    for (BlockId id : loop.blocks)
+    {
+        for (BlockId succ : cfg.successors(id))
+        {
+            if (id != header && !loop.contains(succ))
+                return std::nullopt;
+        }
+    }
+    return shape;
+}
+
+bool same_test(const LoopTest& a, const LoopTest& b)
+{
+    return a.op == b.op && a.bound == b.bound && a.rec.coeffs[0] == b.rec.coeffs[0] && a.rec.coeffs[1] == b.rec.coeffs[1];
+}
+
+} // namespace
+
+bool LoopFusion::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = ensure_preheaders(func);
+    for (bool fused = true; fused;)
+    {
+        fused = false;
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        std::vector<BlockId> def_block(func.temp_count, -1);
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            for (const auto& phi : func.blocks[id].phis)
+                def_block[phi.result.value] = id;
+            for (const auto& instr : func.block_instructions(id))
+            {
+                if (!instr.is_terminator() && instr.result.is_temp())
+                    def_block[instr.result.value] = id;
+            }
+        }
+
+        for (const Loop& first : loops.loops())
+        {
+            auto one = shape_of(func, cfg, first);
+            if (!one)
+                continue;
+            const BlockId between = one->exit;
+            const IRInstruction& jump = func.terminator(between);
+            if (jump.opcode != IROpcode::JUMP || !func.blocks[between].phis.empty())
+                continue;
+            const Loop* next = nullptr;
+            for (const Loop& loop : loops.loops())
+            {
+                if (loop.header == jump.operand1.value && loop.parent == first.parent)
+                    next = &loop;
+            }
+            if (!next)
+                continue;
+            const Loop& second = *next;
+            auto two = shape_of(func, cfg, second);
+            if (!two || two->preheader != between)
+                continue;
+
+            auto from_first = [&](const IROperand& op) {
+                return op.is_temp() && static_cast<size_t>(op.value) < def_block.size() && first.contains(def_block[op.value]);
+            };
+            const std::vector<IRInstruction> moved(func.block_instructions(between).begin(), func.block_instructions(between).end() - 1);
+            bool legal = true;
+            for (const auto& instr : moved)
+                legal = legal && is_speculatable(instr) && !from_first(instr.operand1) && !from_first(instr.operand2);
+            const std::vector<IRInstruction> joined(func.block_instructions(second.header).begin(), func.block_instructions(second.header).end() - 1);
+            for (const auto& instr : joined)
+                legal = legal && is_speculatable(instr);
+            for (BlockId id : second.blocks)
+            {
+                for (const auto& phi : func.blocks[id].phis)
+                {
+                    for (const auto& in : phi.incoming)
+                        legal = legal && !from_first(in.value);
+                }
+                for (const auto& instr : func.block_instructions(id))
+                    legal = legal && !from_first(instr.operand1) && !from_first(instr.operand2);
+            }
+            if (!legal)
+                continue;
+            auto test_one = ScalarEvolution(func, first).loop_test();
+            auto test_two = ScalarEvolution(func, second).loop_test();
+            if (!test_one || !test_two || !same_test(*test_one, *test_two))
+                continue;
+
+            const BlockId header = first.header;
+            // The code between the loops runs before the first one instead.
+            auto instrs = func.block_instructions(one->preheader);
+            std::vector<IRInstruction> preheader_code(instrs.begin(), instrs.end() - 1);
+            preheader_code.insert(preheader_code.end(), moved.begin(), moved.end());
+            preheader_code.push_back(instrs.back());
+            func.set_block_instructions(one->preheader, preheader_code);
+
+            // One header for both: the back edge now comes from the second latch.
+            for (auto& phi : func.blocks[header].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == one->latch)
+                        in.block = two->latch;
+                }
+            }
+            for (PhiNode phi : func.blocks[second.header].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == between)
+                        in.block = one->preheader;
+                }
+                func.blocks[header].phis.push_back(std::move(phi));
+            }
+            instrs = func.block_instructions(header);
+            std::vector<IRInstruction> header_code(instrs.begin(), instrs.end() - 1);
+            header_code.insert(header_code.end(), joined.begin(), joined.end());
+            header_code.push_back(instrs.back());
+            header_code.back().retarget(between, two->exit);
+            func.set_block_instructions(header, header_code);
+
+            // The second body follows the first.
+            func.terminator(one->latch).retarget(header, two->entry);
+            func.terminator(two->latch).retarget(second.header, header);
+            for (auto& phi : func.blocks[two->entry].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == second.header)
+                        in.block = one->latch;
+                }
+            }
+            for (auto& phi : func.blocks[two->exit].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == second.header)
+                        in.block = header;
+                }
+            }
+
+            std::vector<bool> dead(func.blocks.size(), false);
+            dead[between] = dead[second.header] = true;
+            func.remove_blocks(dead);
+            fused = changed = true;
+            break;
+        }
+    }
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,243 @@
+#include "minic/LoopRotation.hpp"
+#include "minic/Loops.hpp"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace minic
+{
+
+LoopRotation::LoopRotation(size_t max_header)
+    : max_header_(max_header)
+{
+}
+
+bool LoopRotation::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = ensure_preheaders(func);
+    std::vector<std::string> headers;
+    {
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        for (const auto& loop : loops.loops())
+            headers.push_back(func.blocks[loop.header].label);
+    }
+
+    for (const std::string& label : headers)
+    {
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        const Loop* found = nullptr;
+        for (const auto& loop : loops.loops())
+        {
+            if (func.blocks[loop.header].label == label)
+                found = &loop;
+        }
+        if (!found)
+            continue;
+        const Loop& loop = *found;
+        const BlockId header = loop.header;
+        if (loop.latches.size() != 1 || loop.exits.size() != 1 || cfg.predecessors(header).size() != 2)
+            continue;
+        const BlockId latch = loop.latches[0];
+        BlockId exit = loop.exits[0];
+        IRInstruction test = func.terminator(header);
+        if (test.opcode != IROpcode::JUMPIF && test.opcode != IROpcode::JUMPIFNOT)
+            continue;
+        const BlockId entry = loop.contains(test.operand2.value) ? test.operand2.value : test.result.value;
+        const BlockId preheader = cfg.predecessors(header)[0] == latch ? cfg.predecessors(header)[1] : cfg.predecessors(header)[0];
+        if (latch == header || entry == header || func.terminator(latch).opcode != IROpcode::JUMP
+            || func.terminator(preheader).opcode != IROpcode::JUMP || cfg.predecessors(entry).size() != 1
+            || func.block_instructions(header).size() - 1 > max_header_)
+            continue;
+        bool from_header = true;
+        for (BlockId pred : cfg.predecessors(exit))
+            from_header = from_header && (pred == header || !loop.contains(pred));
+        if (!from_header)
+            continue;
+        if (cfg.predecessors(exit).size() != 1)
+        {
+            // The exit gets phis for the guard and the latch; give the loop an exit of its own.
+            BlockId own = func.add_block(func.new_label("loop_exit"));
+            func.append(own, IRInstruction(IROpcode::JUMP, {}, IROperand::block(exit)));
+            func.terminator(header).retarget(exit, own);
+            test.retarget(exit, own);
+            for (auto& phi : func.blocks[exit].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == header)
+                        in.block = own;
+                }
+            }
+            exit = own;
+        }
+
+        const std::vector<PhiNode> phis = func.blocks[header].phis;
+        const std::vector<IRInstruction> instrs(func.block_instructions(header).begin(), func.block_instructions(header).end() - 1);
+        const auto temps = static_cast<size_t>(func.temp_count);
+        std::vector<bool> defined(temps, false);
+        for (const auto& phi : phis)
+            defined[phi.result.value] = true;
+        for (const auto& instr : instrs)
+        {
+            if (instr.result.is_temp())
+                defined[instr.result.value] = true;
+        }
+        auto is_defined = [&](const IROperand& op) { return op.is_temp() && static_cast<size_t>(op.value) < temps && defined[op.value]; };
+
+        // Which header values are read in the body (or fed back by the latch) and after the loop.
+        std::vector<bool> read_in_body(temps, false);
+        std::vector<bool> read_after(temps, false);
+        for (const auto& phi : phis)
+        {
+            IROperand next = phi.value_from(latch);
+            if (is_defined(next))
+                read_in_body[next.value] = true;
+        }
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            if (id == header)
+                continue;
+            auto& reads = loop.contains(id) ? read_in_body : read_after;
+            for (const auto& phi : func.blocks[id].phis)
+            {
+                for (const auto& in : phi.incoming)
+                {
+                    if (in.block != header && is_defined(in.value))
+                        reads[in.value.value] = true;
+                }
+            }
+            for (const auto& instr : func.block_instructions(id))
+            {
+                for (const IROperand* op : { &instr.operand1, &instr.operand2 })
+                {
+                    if (is_defined(*op))
+                        reads[op->value] = true;
+                }
+            }
+        }
+
+        // Header values as the body sees them: phis in the entry block merging the guard and the latch.
+        std::vector<IROperand> in_body(temps);
+        std::vector<IROperand> after(temps);
+        for (size_t t = 0; t < temps; ++t)
+        {
+            if (read_in_body[t])
+                in_body[t] = func.new_temp();
+            if (read_after[t])
+                after[t] = func.new_temp();
+        }
+
+        // The guard computes the header's values from the preheader's, in new temps.
+        std::vector<IROperand> guard(temps);
+        for (const auto& phi : phis)
+            guard[phi.result.value] = phi.value_from(preheader);
+        auto guarded = [&](const IROperand& op) { return is_defined(op) ? guard[op.value] : op; };
+        std::vector<IRInstruction> guard_code;
+        for (IRInstruction instr : instrs)
+        {
+            instr.operand1 = guarded(instr.operand1);
+            instr.operand2 = guarded(instr.operand2);
+            if (instr.result.is_temp())
+            {
+                guard[instr.result.value] = func.new_temp();
+                instr.result = guard[instr.result.value];
+            }
+            guard_code.push_back(instr);
+        }
+
+        // The latch keeps the header's temps, except that its phis become the values fed back.
+        std::vector<IROperand> bottom(temps);
+        for (const auto& instr : instrs)
+        {
+            if (instr.result.is_temp())
+                bottom[instr.result.value] = instr.result;
+        }
+        for (const auto& phi : phis)
+        {
+            IROperand next = phi.value_from(latch);
+            bottom[phi.result.value] = is_defined(next) ? in_body[next.value] : next;
+        }
+        auto at_bottom = [&](const IROperand& op) { return is_defined(op) ? bottom[op.value] : op; };
+
+        // Rename reads outside the header, and split the entries the entry and exit phis had from it.
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            if (id == header)
+                continue;
+            const auto& renamed = loop.contains(id) ? in_body : after;
+            auto rename = [&](IROperand& op) {
+                if (is_defined(op))
+                    op = renamed[op.value];
+            };
+            for (auto& phi : func.blocks[id].phis)
+            {
+                std::vector<PhiIncoming> incoming;
+                for (auto in : phi.incoming)
+                {
+                    if (in.block == header)
+                    {
+                        incoming.push_back({ preheader, guarded(in.value) });
+                        incoming.push_back({ latch, at_bottom(in.value) });
+                        continue;
+                    }
+                    rename(in.value);
+                    incoming.push_back(in);
+                }
+                phi.incoming = std::move(incoming);
+            }
+            std::vector<IRInstruction> block(func.block_instructions(id).begin(), func.block_instructions(id).end());
+            for (auto& instr : block)
+            {
+                rename(instr.operand1);
+                rename(instr.operand2);
+            }
+            func.set_block_instructions(id, block);
+        }
+        for (size_t t = 0; t < temps; ++t)
+        {
+            if (read_in_body[t])
+                func.blocks[entry].phis.push_back({ in_body[t], { { preheader, guard[t] }, { latch, bottom[t] } } });
+            if (read_after[t])
+                func.blocks[exit].phis.push_back({ after[t], { { preheader, guard[t] }, { latch, bottom[t] } } });
+        }
+
+        // The latch runs the header and branches back to the entry, falling through to the exit.
+        std::vector<IRInstruction> latch_code(func.block_instructions(latch).begin(), func.block_instructions(latch).end() - 1);
+        for (IRInstruction instr : instrs)
+        {
+            instr.operand1 = at_bottom(instr.operand1);
+            instr.operand2 = at_bottom(instr.operand2);
+            latch_code.push_back(instr);
+        }
+        IRInstruction back = test;
+        back.operand1 = at_bottom(back.operand1);
+        if (back.operand2.value != entry)
+        {
+            back.opcode = back.opcode == IROpcode::JUMPIF ? IROpcode::JUMPIFNOT : IROpcode::JUMPIF;
+            std::swap(back.operand2, back.result);
+        }
+        latch_code.push_back(back);
+        func.set_block_instructions(latch, latch_code);
+
+        // The preheader runs the header once to decide whether the loop is entered.
+        std::vector<IRInstruction> preheader_code(func.block_instructions(preheader).begin(), func.block_instructions(preheader).end() - 1);
+        preheader_code.insert(preheader_code.end(), guard_code.begin(), guard_code.end());
+        IRInstruction check = test;
+        check.operand1 = guarded(check.operand1);
+        preheader_code.push_back(check);
+        func.set_block_instructions(preheader, preheader_code);
+
+        std::vector<bool> dead(func.blocks.size(), false);
+        dead[header] = true;
+        func.remove_blocks(dead);
+        changed = true;
+    }
+    return changed;
+}
+
+} // namespace minic
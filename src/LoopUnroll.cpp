@@ -0,0 +1,418 @@
+#include "minic/LoopUnroll.hpp"
+#include "minic/ScalarEvolution.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief Lays out copies of one loop's header and body, one after another.
+ *
+ * Each copy renames every temp the loop defines; the header phis of a copy
+ * take the values the previous copy fed back through the latch. Straight-line
+ * code accumulates in an open block (cur) until a jump is needed.
+ */
+class Unroller
+{
+public:
+    Unroller(IRFunction& func, const Loop& loop, BlockId entry)
+        : func_(func)
+        , header_(loop.header)
+        , latch_(loop.latches[0])
+        , entry_(entry)
+        , temps_(func.temp_count)
+        , current_(func.temp_count)
+    {
+        for (BlockId id : loop.blocks)
+        {
+            if (id != header_)
+                body_.push_back(id);
+        }
+    }
+
+    /**
+     * @brief Continue emitting into an empty new block.
+     */
+    BlockId open(const std::string& prefix)
+    {
+        resume(func_.add_block(func_.new_label(prefix)));
+        return cur_;
+    }
+
+    /**
+     * @brief Continue emitting into an existing empty block.
+     */
+    void resume(BlockId id)
+    {
+        cur_ = id;
+        pending_.clear();
+    }
+
+    /**
+     * @brief End the open block with a terminator.
+     */
+    BlockId close(const IRInstruction& term)
+    {
+        pending_.push_back(term);
+        func_.set_block_instructions(cur_, pending_);
+        pending_.clear();
+        return cur_;
+    }
+
+    IROperand map(const IROperand& op) const
+    {
+        if (op.is_temp() && op.value < temps_ && !current_[op.value].empty())
+            return current_[op.value];
+        return op;
+    }
+
+    /**
+     * @brief Set what the header phis stand for in the next copy.
+     */
+    void set_phis(const std::vector<IROperand>& values)
+    {
+        const auto& phis = func_.blocks[header_].phis;
+        for (size_t i = 0; i < phis.size(); ++i)
+            current_[phis[i].result.value] = values[i];
+    }
+
+    /**
+     * @brief The values the current copy's latch feeds back to the header phis.
+     */
+    std::vector<IROperand> latch_values() const
+    {
+        std::vector<IROperand> values;
+        for (const auto& phi : func_.blocks[header_].phis)
+            values.push_back(map(phi.value_from(latch_)));
+        return values;
+    }
+
+    /**
+     * @brief Append the header's instructions (not its test) to the open block.
+     */
+    void copy_header()
+    {
+        std::vector<IRInstruction> instrs(func_.block_instructions(header_).begin(), func_.block_instructions(header_).end() - 1);
+        rename_results(instrs);
+        for (auto& instr : instrs)
+            pending_.push_back(copy(instr));
+    }
+
+    /**
+     * @brief Copy the body after the open block; the latch's copy becomes the open block.
+     */
+    void copy_body()
+    {
+        std::vector<std::vector<IRInstruction>> instrs;
+        for (BlockId id : body_)
+        {
+            instrs.emplace_back(func_.block_instructions(id).begin(), func_.block_instructions(id).end() - 1);
+            for (const auto& phi : func_.blocks[id].phis)
+                current_[phi.result.value] = func_.new_temp();
+            rename_results(instrs.back());
+        }
+
+        if (body_.size() == 1)
+        {
+            // A single block needs no jumps: keep appending.
+            for (auto& instr : instrs[0])
+                pending_.push_back(copy(instr));
+            return;
+        }
+
+        BlockId from = cur_;
+        std::vector<BlockId> copy_of(func_.blocks.size(), -1);
+        for (BlockId id : body_)
+            copy_of[id] = func_.add_block(func_.new_label("unrolled"));
+        close(IRInstruction(IROpcode::JUMP, {}, IROperand::block(copy_of[entry_])));
+        for (BlockId id : body_)
+        {
+            for (const auto& phi : func_.blocks[id].phis)
+            {
+                PhiNode copied { map(phi.result), {} };
+                for (const auto& in : phi.incoming)
+                {
+                    // Entries from unreachable blocks have no copy.
+                    if (in.block == header_)
+                        copied.incoming.push_back({ from, map(in.value) });
+                    else if (copy_of[in.block] >= 0)
+                        copied.incoming.push_back({ copy_of[in.block], map(in.value) });
+                }
+                func_.blocks[copy_of[id]].phis.push_back(std::move(copied));
+            }
+        }
+        // The latch's copy goes last and stays open for the next header copy.
+        size_t latch_index = 0;
+        for (size_t i = 0; i < body_.size(); ++i)
+        {
+            if (body_[i] == latch_)
+            {
+                latch_index = i;
+                continue;
+            }
+            resume(copy_of[body_[i]]);
+            for (auto& instr : instrs[i])
+                pending_.push_back(copy(instr));
+            IRInstruction term = func_.terminator(body_[i]);
+            if (term.opcode != IROpcode::JUMP)
+                term.operand1 = map(term.operand1);
+            for (BlockId id : body_)
+                term.retarget(id, copy_of[id]);
+            close(term);
+        }
+        resume(copy_of[latch_]);
+        for (auto& instr : instrs[latch_index])
+            pending_.push_back(copy(instr));
+    }
+
+    void append(const IRInstruction& instr) { pending_.push_back(instr); }
+
+private:
+    void rename_results(const std::vector<IRInstruction>& instrs)
+    {
+        for (const auto& instr : instrs)
+        {
+            if (instr.result.is_temp())
+                current_[instr.result.value] = func_.new_temp();
+        }
+    }
+
+    IRInstruction copy(IRInstruction instr) const
+    {
+        instr.result = map(instr.result);
+        instr.operand1 = map(instr.operand1);
+        instr.operand2 = map(instr.operand2);
+        return instr;
+    }
+
+    IRFunction& func_;
+    BlockId header_;
+    BlockId latch_;
+    BlockId entry_;
+    std::vector<BlockId> body_;
+    std::int32_t temps_;
+    std::vector<IROperand> current_;
+    BlockId cur_ = -1;
+    std::vector<IRInstruction> pending_;
+};
+
+} // namespace
+
+LoopUnroll::LoopUnroll(int factor, size_t budget)
+    : factor_(factor)
+    , budget_(budget)
+{
+}
+
+bool LoopUnroll::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = ensure_preheaders(func);
+    // Only the loops present now: the loops unrolling creates are not unrolled again.
+    std::vector<std::string> headers;
+    {
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        for (const auto& loop : loops.loops())
+            headers.push_back(func.blocks[loop.header].label);
+    }
+
+    for (const std::string& label : headers)
+    {
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        int index = -1;
+        for (size_t i = 0; i < loops.loops().size(); ++i)
+        {
+            if (func.blocks[loops.loops()[i].header].label == label)
+                index = static_cast<int>(i);
+        }
+        if (index < 0)
+            continue;
+        const Loop& loop = loops.loops()[index];
+        const BlockId header = loop.header;
+        if (loop.latches.size() != 1 || loop.exits.size() != 1 || cfg.predecessors(header).size() != 2)
+            continue;
+        const BlockId latch = loop.latches[0];
+        const BlockId exit = loop.exits[0];
+        const IRInstruction test = func.terminator(header);
+        if (test.opcode != IROpcode::JUMPIF && test.opcode != IROpcode::JUMPIFNOT)
+            continue;
+        const BlockId entry = loop.contains(test.operand2.value) ? test.operand2.value : test.result.value;
+        BlockId preheader = cfg.predecessors(header)[0] == latch ? cfg.predecessors(header)[1] : cfg.predecessors(header)[0];
+        if (func.terminator(latch).opcode != IROpcode::JUMP || cfg.successors(preheader).size() != 1 || cfg.predecessors(exit).size() != 1
+            || entry == header)
+            continue;
+        bool simple = true;
+        size_t size = 0;
+        for (BlockId id : loop.blocks)
+        {
+            simple = simple && loops.loop_of(id) == index;
+            for (BlockId succ : cfg.successors(id))
+                simple = simple && (id == header || loop.contains(succ));
+            size += func.block_instructions(id).size();
+        }
+        if (!simple)
+            continue;
+
+        ScalarEvolution scev(func, loop);
+        auto trips = scev.trip_count();
+        bool full = trips && trips->is_imm() && static_cast<size_t>(trips->value) * size <= budget_;
+        int factor = factor_;
+        while (factor >= 2 && static_cast<size_t>(factor) * size > budget_)
+            --factor;
+        auto loop_test = scev.loop_test();
+        std::int64_t step = loop_test ? loop_test->rec.coeffs[1].value : 0;
+        bool counts = loop_test
+            && (((loop_test->op == IROpcode::LT || loop_test->op == IROpcode::LE) && step > 0)
+                || ((loop_test->op == IROpcode::GT || loop_test->op == IROpcode::GE) && step < 0));
+        std::int64_t distance = (factor - 1) * step;
+        if (!full && (factor < 2 || !counts || distance < std::numeric_limits<std::int32_t>::min() || distance > std::numeric_limits<std::int32_t>::max()))
+            continue;
+
+        Unroller unroller(func, loop, entry);
+        std::vector<IROperand> init;
+        for (const auto& phi : func.blocks[header].phis)
+            init.push_back(phi.value_from(preheader));
+
+        if (full)
+        {
+            BlockId first = unroller.open("unrolled");
+            unroller.set_phis(init);
+            unroller.copy_header();
+            for (std::int32_t i = 0; i < trips->value; ++i)
+            {
+                unroller.copy_body();
+                unroller.set_phis(unroller.latch_values());
+                unroller.copy_header();
+            }
+
+            // Everything after the loop reads the last header copy's values.
+            std::vector<bool> in_header(func.temp_count, false);
+            for (const auto& phi : func.blocks[header].phis)
+                in_header[phi.result.value] = true;
+            for (const auto& instr : func.block_instructions(header))
+            {
+                if (!instr.is_terminator() && instr.result.is_temp())
+                    in_header[instr.result.value] = true;
+            }
+            auto rename = [&](IROperand& op) {
+                if (op.is_temp() && op.value < static_cast<std::int32_t>(in_header.size()) && in_header[op.value])
+                    op = unroller.map(op);
+            };
+            BlockId last = unroller.close(IRInstruction(IROpcode::JUMP, {}, IROperand::block(exit)));
+            for (auto& phi : func.blocks[exit].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == header)
+                        in.block = last;
+                }
+            }
+            for (BlockId id = 0; id < first; ++id)
+            {
+                if (loop.contains(id))
+                    continue;
+                for (auto& phi : func.blocks[id].phis)
+                {
+                    for (auto& in : phi.incoming)
+                        rename(in.value);
+                }
+                std::vector<IRInstruction> instrs(func.block_instructions(id).begin(), func.block_instructions(id).end());
+                for (auto& instr : instrs)
+                {
+                    if (instr.opcode == IROpcode::JUMP)
+                        continue;
+                    rename(instr.operand1);
+                    rename(instr.operand2);
+                }
+                func.set_block_instructions(id, instrs);
+            }
+            func.terminator(preheader).retarget(header, first);
+            std::vector<bool> dead(func.blocks.size(), false);
+            for (BlockId id : loop.blocks)
+                dead[id] = true;
+            // Unreachable blocks may still jump into the loop.
+            for (BlockId id = 0; id < static_cast<BlockId>(cfg.size()); ++id)
+                dead[id] = dead[id] || !cfg.reachable(id);
+            func.remove_blocks(dead);
+            changed = true;
+            continue;
+        }
+
+        // The unrolled loop may run factor more iterations while value op bound - distance holds.
+        // A bound solved from values in the loop may need computing first.
+        const IROperand& bound = loop_test->bound;
+        std::vector<IRInstruction> guard(scev.code().begin(), scev.code().end());
+        IROperand limit;
+        if (auto folded = fold_constant(IROpcode::SUB, bound, IROperand::imm(static_cast<std::int32_t>(distance))))
+            limit = *folded;
+        else
+        {
+            limit = func.new_temp();
+            guard.push_back(IRInstruction(IROpcode::SUB, limit, bound, IROperand::imm(static_cast<std::int32_t>(distance))));
+        }
+
+        BlockId unrolled_header = unroller.open("unroll_header");
+        std::vector<IROperand> carried;
+        for (size_t i = 0; i < init.size(); ++i)
+            carried.push_back(func.new_temp());
+        unroller.set_phis(carried);
+        unroller.copy_header();
+        IROperand check = func.new_temp();
+        unroller.append(IRInstruction(loop_test->op, check, unroller.map(loop_test->value), limit));
+        BlockId unrolled_body = func.add_block(func.new_label("unrolled"));
+        unroller.close(IRInstruction(IROpcode::JUMPIF, IROperand::block(header), check, IROperand::block(unrolled_body)));
+        unroller.resume(unrolled_body);
+        for (int i = 0; i < factor; ++i)
+        {
+            if (i > 0)
+            {
+                unroller.set_phis(unroller.latch_values());
+                unroller.copy_header();
+            }
+            unroller.copy_body();
+        }
+        std::vector<IROperand> back = unroller.latch_values();
+        BlockId last = unroller.close(IRInstruction(IROpcode::JUMP, {}, IROperand::block(unrolled_header)));
+        for (size_t i = 0; i < carried.size(); ++i)
+            func.blocks[unrolled_header].phis.push_back({ carried[i], { { preheader, init[i] }, { last, back[i] } } });
+
+        // Without a guard the preheader always enters the unrolled loop; the
+        // original loop is now entered from the unrolled header.
+        bool guarded = !bound.is_imm();
+        auto& phis = func.blocks[header].phis;
+        for (size_t i = 0; i < phis.size(); ++i)
+        {
+            if (!guarded)
+                std::erase_if(phis[i].incoming, [&](const PhiIncoming& in) { return in.block == preheader; });
+            phis[i].incoming.push_back({ unrolled_header, carried[i] });
+        }
+        auto instrs = func.block_instructions(preheader);
+        std::vector<IRInstruction> entering(instrs.begin(), instrs.end() - 1);
+        entering.insert(entering.end(), guard.begin(), guard.end());
+        if (guarded)
+        {
+            // bound - distance wrapped unless it moved towards the start.
+            IROperand room = func.new_temp();
+            entering.push_back(IRInstruction(step > 0 ? IROpcode::LT : IROpcode::GT, room, limit, bound));
+            entering.push_back(IRInstruction(IROpcode::JUMPIF, IROperand::block(header), room, IROperand::block(unrolled_header)));
+        }
+        else
+            entering.push_back(IRInstruction(IROpcode::JUMP, {}, IROperand::block(unrolled_header)));
+        func.set_block_instructions(preheader, entering);
+        changed = true;
+    }
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,135 @@
+#include "minic/LoopUnswitch.hpp"
+#include "minic/Loops.hpp"
+#include "minic/SSA.hpp"
+#include <vector>
+
+namespace minic
+{
+
+LoopUnswitch::LoopUnswitch(size_t budget)
+    : budget_(budget)
+{
+}
+
+bool LoopUnswitch::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = false;
+    size_t spent = 0;
+    for (bool unswitched = true; unswitched;)
+    {
+        unswitched = false;
+        // The preheader of an unswitched loop branches to both versions, so each needs a new one.
+        changed = ensure_preheaders(func) || changed;
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        std::vector<BlockId> def_block(func.temp_count, -1);
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            for (const auto& phi : func.blocks[id].phis)
+                def_block[phi.result.value] = id;
+            for (const auto& instr : func.block_instructions(id))
+            {
+                if (!instr.is_terminator() && instr.result.is_temp())
+                    def_block[instr.result.value] = id;
+            }
+        }
+
+        for (size_t index = loops.loops().size(); index-- > 0 && !unswitched;)
+        {
+            const Loop& loop = loops.loops()[index];
+            const BlockId header = loop.header;
+            size_t size = 0;
+            for (BlockId id : loop.blocks)
+                size += func.block_instructions(id).size();
+            BlockId preheader = -1;
+            for (BlockId pred : cfg.predecessors(header))
+            {
+                if (!loop.contains(pred))
+                    preheader = pred;
+            }
+            if (spent + size > budget_ || preheader < 0 || func.terminator(preheader).opcode != IROpcode::JUMP)
+                continue;
+
+            auto invariant = [&](const IROperand& op) {
+                if (op.is_temp())
+                    return !loop.contains(def_block[op.value]);
+                return op.is_var() || op.is_imm();
+            };
+            BlockId branch = -1;
+            for (BlockId id : loop.blocks)
+            {
+                const IRInstruction& term = func.terminator(id);
+                if ((term.opcode == IROpcode::JUMPIF || term.opcode == IROpcode::JUMPIFNOT) && !(term.operand2 == term.result)
+                    && loop.contains(term.operand2.value) && loop.contains(term.result.value) && invariant(term.operand1))
+                {
+                    branch = id;
+                    break;
+                }
+            }
+            if (branch < 0)
+                continue;
+
+            const IRInstruction test = func.terminator(branch);
+            const BlockId when_set = test.opcode == IROpcode::JUMPIF ? test.operand2.value : test.result.value;
+            const BlockId when_clear = test.opcode == IROpcode::JUMPIF ? test.result.value : test.operand2.value;
+
+            // Clone the loop's blocks; edges inside the loop go to the clones.
+            std::vector<BlockId> clone_of(func.blocks.size(), -1);
+            for (BlockId id : loop.blocks)
+                clone_of[id] = func.add_block(func.new_label("unswitched"));
+            for (BlockId id : loop.blocks)
+            {
+                for (PhiNode phi : func.blocks[id].phis)
+                {
+                    for (auto& in : phi.incoming)
+                    {
+                        if (loop.contains(in.block))
+                            in.block = clone_of[in.block];
+                    }
+                    func.blocks[clone_of[id]].phis.push_back(std::move(phi));
+                }
+                std::vector<IRInstruction> instrs(func.block_instructions(id).begin(), func.block_instructions(id).end());
+                for (const IROperand& target : instrs.back().targets())
+                {
+                    if (loop.contains(target.value))
+                        instrs.back().retarget(target.value, clone_of[target.value]);
+                }
+                func.set_block_instructions(clone_of[id], instrs);
+            }
+            for (BlockId exit : loop.exits)
+            {
+                for (auto& phi : func.blocks[exit].phis)
+                {
+                    std::vector<PhiIncoming> added;
+                    for (const auto& in : phi.incoming)
+                    {
+                        if (loop.contains(in.block))
+                            added.push_back({ clone_of[in.block], in.value });
+                    }
+                    phi.incoming.insert(phi.incoming.end(), added.begin(), added.end());
+                }
+            }
+
+            // The original loop runs when the condition is nonzero, the clone when it is zero.
+            auto resolve = [&](BlockId id, BlockId keep, BlockId drop) {
+                func.terminator(id) = IRInstruction(IROpcode::JUMP, {}, IROperand::block(keep));
+                for (auto& phi : func.blocks[drop].phis)
+                    std::erase_if(phi.incoming, [&](const PhiIncoming& in) { return in.block == id; });
+            };
+            resolve(branch, when_set, when_clear);
+            resolve(clone_of[branch], clone_of[when_clear], clone_of[when_set]);
+            func.terminator(preheader) = IRInstruction(IROpcode::JUMPIF, IROperand::block(clone_of[header]), test.operand1, IROperand::block(header));
+
+            // Both versions define the same temps; renaming them restores SSA form.
+            SSAConstruction().run(func);
+            spent += size;
+            unswitched = changed = true;
+        }
+    }
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,177 @@
+#include "minic/Loops.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace minic
+{
+
+bool Loop::contains(BlockId id) const
+{
+    return std::binary_search(blocks.begin(), blocks.end(), id);
+}
+
+LoopInfo::LoopInfo(const ControlFlowGraph& cfg)
+    : loop_of_(cfg.size(), -1)
+{
+    // Headers in reverse postorder: an enclosing loop's header dominates, and
+    // so precedes, the headers of the loops nested in it.
+    for (BlockId header : cfg.reverse_postorder())
+    {
+        Loop loop { header, {}, {}, {} };
+        for (BlockId pred : cfg.predecessors(header))
+        {
+            if (cfg.reachable(pred) && cfg.dominates(header, pred))
+                loop.latches.push_back(pred);
+        }
+        if (loop.latches.empty())
+            continue;
+
+        // Everything that reaches a latch without passing through the header.
+        std::vector<bool> in_loop(cfg.size(), false);
+        in_loop[header] = true;
+        std::vector<BlockId> work(loop.latches);
+        while (!work.empty())
+        {
+            BlockId id = work.back();
+            work.pop_back();
+            if (in_loop[id])
+                continue;
+            in_loop[id] = true;
+            for (BlockId pred : cfg.predecessors(id))
+            {
+                if (!in_loop[pred] && cfg.reachable(pred))
+                    work.push_back(pred);
+            }
+        }
+        for (BlockId id = 0; id < static_cast<BlockId>(cfg.size()); ++id)
+        {
+            if (in_loop[id])
+                loop.blocks.push_back(id);
+        }
+        for (BlockId id : loop.blocks)
+        {
+            for (BlockId succ : cfg.successors(id))
+            {
+                if (!in_loop[succ] && std::find(loop.exits.begin(), loop.exits.end(), succ) == loop.exits.end())
+                    loop.exits.push_back(succ);
+            }
+        }
+        std::sort(loop.exits.begin(), loop.exits.end());
+        loops_.push_back(std::move(loop));
+    }
+
+    for (size_t i = 0; i < loops_.size(); ++i)
+    {
+        // The enclosing loops all come earlier; the latest one is the innermost.
+        for (size_t j = i; j-- > 0;)
+        {
+            if (loops_[j].contains(loops_[i].header))
+            {
+                loops_[i].parent = static_cast<int>(j);
+                loops_[i].depth = loops_[j].depth + 1;
+                break;
+            }
+        }
+        for (BlockId id : loops_[i].blocks)
+            loop_of_[id] = static_cast<int>(i);
+    }
+}
+
+BlockId ensure_preheader(IRFunction& func, const ControlFlowGraph& cfg, const Loop& loop)
+{
+    std::vector<BlockId> outside;
+    for (BlockId pred : cfg.predecessors(loop.header))
+    {
+        if (!loop.contains(pred))
+            outside.push_back(pred);
+    }
+    if (outside.empty())
+        return -1;
+    if (outside.size() == 1 && cfg.successors(outside[0]).size() == 1)
+        return outside[0];
+
+    BlockId preheader = func.add_block(func.new_label("preheader"));
+    for (auto& phi : func.blocks[loop.header].phis)
+    {
+        std::vector<PhiIncoming> entering;
+        std::erase_if(phi.incoming, [&](const PhiIncoming& in) {
+            if (std::find(outside.begin(), outside.end(), in.block) == outside.end())
+                return false;
+            entering.push_back(in);
+            return true;
+        });
+        if (entering.empty())
+            continue;
+        IROperand value = entering[0].value;
+        bool same = std::all_of(entering.begin(), entering.end(), [&](const PhiIncoming& in) { return in.value == value; });
+        if (!same)
+        {
+            value = func.new_temp();
+            func.blocks[preheader].phis.push_back({ value, std::move(entering) });
+        }
+        phi.incoming.push_back({ preheader, value });
+    }
+    func.append(preheader, IRInstruction(IROpcode::JUMP, {}, IROperand::block(loop.header)));
+    for (BlockId pred : outside)
+        func.terminator(pred).retarget(loop.header, preheader);
+    return preheader;
+}
+
+bool ensure_preheaders(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+    bool changed = false;
+    for (bool inserted = true; inserted;)
+    {
+        // Inserting a block changes the CFG, so rebuild after each one.
+        inserted = false;
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        for (const auto& loop : loops.loops())
+        {
+            size_t before = func.blocks.size();
+            ensure_preheader(func, cfg, loop);
+            if (func.blocks.size() != before)
+            {
+                inserted = changed = true;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+std::vector<InductionVariable> find_induction_variables(const IRFunction& func, const ControlFlowGraph& cfg, const Loop& loop)
+{
+    std::vector<InductionVariable> ivs;
+    if (loop.latches.size() != 1 || cfg.predecessors(loop.header).size() != 2)
+        return ivs;
+    const BlockId latch = loop.latches[0];
+    for (const auto& phi : func.blocks[loop.header].phis)
+    {
+        if (phi.incoming.size() != 2)
+            continue;
+        IROperand next = phi.value_from(latch);
+        if (!next.is_temp())
+            continue;
+        const PhiIncoming& entering = phi.incoming[0].block == latch ? phi.incoming[1] : phi.incoming[0];
+        for (BlockId id : loop.blocks)
+        {
+            for (const auto& instr : func.block_instructions(id))
+            {
+                if (instr.is_terminator() || instr.result != next)
+                    continue;
+                if (instr.opcode == IROpcode::ADD && instr.operand1 == phi.result && instr.operand2.is_imm())
+                    ivs.push_back({ phi.result, entering.value, next, instr.operand2.value });
+                else if (instr.opcode == IROpcode::ADD && instr.operand2 == phi.result && instr.operand1.is_imm())
+                    ivs.push_back({ phi.result, entering.value, next, instr.operand1.value });
+                else if (instr.opcode == IROpcode::SUB && instr.operand1 == phi.result && instr.operand2.is_imm() && instr.operand2.value != INT32_MIN)
+                    ivs.push_back({ phi.result, entering.value, next, -instr.operand2.value });
+            }
+        }
+    }
+    return ivs;
+}
+
+} // namespace minic
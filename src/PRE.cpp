@@ -0,0 +1,314 @@
+#include "minic/PRE.hpp"
+#include "minic/CFG.hpp"
+#include "minic/SSA.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief A computation by its opcode and operands, wherever it occurs.
+ */
+struct Expression
+{
+    IROpcode opcode;
+    IROperand a;
+    IROperand b;
+
+    bool operator==(const Expression&) const = default;
+};
+
+/**
+ * @brief Whether an instruction computes an expression that may be moved.
+ */
+bool movable(const IRInstruction& instr)
+{
+    auto operand = [](const IROperand& op) { return op.is_temp() || op.is_var() || op.is_imm() || op.empty(); };
+    return instr.opcode != IROpcode::ASSIGN && instr.result.is_temp() && is_speculatable(instr) && operand(instr.operand1)
+        && operand(instr.operand2) && !(instr.operand1.is_imm() && (instr.operand2.is_imm() || instr.operand2.empty()));
+}
+
+/**
+ * @brief The CFG with a node of its own on every critical edge.
+ *
+ * Nodes below the block count are the blocks; the rest stand for the edge
+ * from a block with several successors to a block with several predecessors,
+ * where code cannot be placed in either without running on other paths too.
+ */
+class EdgeGraph
+{
+public:
+    explicit EdgeGraph(const ControlFlowGraph& cfg)
+        : succs_(cfg.size())
+        , preds_(cfg.size())
+    {
+        for (BlockId id = 0; id < static_cast<BlockId>(cfg.size()); ++id)
+        {
+            if (!cfg.reachable(id))
+                continue;
+            for (BlockId succ : cfg.successors(id))
+            {
+                int to = succ;
+                if (cfg.successors(id).size() > 1 && cfg.predecessors(succ).size() > 1)
+                {
+                    to = static_cast<int>(succs_.size());
+                    edges_.emplace_back(id, succ);
+                    succs_.push_back({ succ });
+                    preds_.push_back({ id });
+                    preds_[succ].push_back(to);
+                }
+                else
+                {
+                    preds_[succ].push_back(id);
+                }
+                succs_[id].push_back(to);
+            }
+        }
+    }
+
+    size_t size() const { return succs_.size(); }
+    const std::vector<int>& successors(int node) const { return succs_[node]; }
+    const std::vector<int>& predecessors(int node) const { return preds_[node]; }
+
+    /**
+     * @brief The edge a node past the blocks stands for.
+     */
+    std::pair<BlockId, BlockId> edge(int node, size_t blocks) const { return edges_[node - blocks]; }
+
+private:
+    std::vector<std::vector<int>> succs_;
+    std::vector<std::vector<int>> preds_;
+    std::vector<std::pair<BlockId, BlockId>> edges_;
+};
+
+/**
+ * @brief Iterate a dataflow problem to its fixpoint; step(node) recomputes
+ * one node and reports whether it changed.
+ */
+template <typename Step>
+void solve(size_t nodes, Step step)
+{
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (int node = 0; node < static_cast<int>(nodes); ++node)
+            changed = step(node) || changed;
+    }
+}
+
+/**
+ * @brief Where lazy code motion computes one expression.
+ */
+struct Placement
+{
+    std::vector<bool> insert; ///< Nodes that compute the expression into the new temp on entry
+    std::vector<bool> replace; ///< Blocks whose computations become copies of the new temp
+};
+
+/**
+ * @brief Run the four lazy code motion problems for one expression.
+ * @param use Nodes that compute it before anything defines its operands.
+ * @param kill Nodes that define one of its operands.
+ */
+Placement place(const EdgeGraph& graph, const std::vector<bool>& use, const std::vector<bool>& kill)
+{
+    const size_t n = graph.size();
+    auto all = [](const std::vector<int>& nodes, auto pred) {
+        return !nodes.empty() && std::ranges::all_of(nodes, pred);
+    };
+
+    // Anticipated: every path from the node computes it before a kill.
+    std::vector<bool> ant_in(n, true);
+    std::vector<bool> ant_out(n, true);
+    solve(n, [&](int node) {
+        bool out = all(graph.successors(node), [&](int s) { return ant_in[s]; });
+        bool in = use[node] || (out && !kill[node]);
+        bool changed = out != ant_out[node] || in != ant_in[node];
+        ant_out[node] = out;
+        ant_in[node] = in;
+        return changed;
+    });
+
+    // Available (counting where it is anticipated): every path to the node could have computed it.
+    std::vector<bool> av_in(n, true);
+    std::vector<bool> av_out(n, true);
+    solve(n, [&](int node) {
+        bool in = all(graph.predecessors(node), [&](int p) { return av_out[p]; });
+        bool out = (ant_in[node] || in) && !kill[node];
+        bool changed = in != av_in[node] || out != av_out[node];
+        av_in[node] = in;
+        av_out[node] = out;
+        return changed;
+    });
+    std::vector<bool> earliest(n);
+    for (size_t node = 0; node < n; ++node)
+        earliest[node] = ant_in[node] && !av_in[node];
+
+    // Postponable: the computation can still move down past the node's entry.
+    std::vector<bool> post_in(n, true);
+    std::vector<bool> post_out(n, true);
+    solve(n, [&](int node) {
+        bool in = all(graph.predecessors(node), [&](int p) { return post_out[p]; });
+        bool out = (earliest[node] || in) && !use[node];
+        bool changed = in != post_in[node] || out != post_out[node];
+        post_in[node] = in;
+        post_out[node] = out;
+        return changed;
+    });
+    std::vector<bool> latest(n);
+    for (int node = 0; node < static_cast<int>(n); ++node)
+    {
+        auto movable_into = [&](int s) { return earliest[s] || post_in[s]; };
+        const auto& succs = graph.successors(node);
+        bool further = !succs.empty() && std::ranges::all_of(succs, movable_into);
+        latest[node] = movable_into(node) && (use[node] || !further);
+    }
+
+    // Used: some later computation reads the temp placed here.
+    std::vector<bool> used_in(n, false);
+    std::vector<bool> used_out(n, false);
+    solve(n, [&](int node) {
+        bool out = std::ranges::any_of(graph.successors(node), [&](int s) { return used_in[s]; });
+        bool in = (use[node] || out) && !latest[node];
+        bool changed = out != used_out[node] || in != used_in[node];
+        used_out[node] = out;
+        used_in[node] = in;
+        return changed;
+    });
+
+    Placement placement { std::vector<bool>(n), std::vector<bool>(n) };
+    for (size_t node = 0; node < n; ++node)
+    {
+        placement.insert[node] = latest[node] && used_out[node];
+        placement.replace[node] = use[node] && !(latest[node] && !used_out[node]);
+    }
+    return placement;
+}
+
+} // namespace
+
+bool PartialRedundancyElimination::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    ControlFlowGraph cfg(func);
+    EdgeGraph graph(cfg);
+    const size_t blocks = func.blocks.size();
+    std::vector<BlockId> def_block(func.temp_count, -1);
+    std::vector<Expression> exprs;
+    std::vector<int> computed;
+    for (BlockId id = 0; id < static_cast<BlockId>(blocks); ++id)
+    {
+        for (const auto& phi : func.blocks[id].phis)
+            def_block[phi.result.value] = id;
+        for (const auto& instr : func.block_instructions(id))
+        {
+            if (instr.is_terminator() || !instr.result.is_temp())
+                continue;
+            def_block[instr.result.value] = id;
+            if (!movable(instr))
+                continue;
+            Expression expr { instr.opcode, instr.operand1, instr.operand2 };
+            auto it = std::ranges::find(exprs, expr);
+            if (it == exprs.end())
+            {
+                exprs.push_back(expr);
+                computed.push_back(1);
+            }
+            else
+            {
+                ++computed[it - exprs.begin()];
+            }
+        }
+    }
+
+    bool changed = false;
+    // Split blocks by the edge node they were created for.
+    std::vector<BlockId> split(graph.size(), -1);
+    for (size_t e = 0; e < exprs.size(); ++e)
+    {
+        // An expression computed once has nothing to be redundant with.
+        if (computed[e] < 2)
+            continue;
+        const Expression& expr = exprs[e];
+        auto defines_operand = [&](BlockId id) {
+            return (expr.a.is_temp() && def_block[expr.a.value] == id) || (expr.b.is_temp() && def_block[expr.b.value] == id);
+        };
+        std::vector<bool> use(graph.size(), false);
+        std::vector<bool> kill(graph.size(), false);
+        for (BlockId id = 0; id < static_cast<BlockId>(blocks); ++id)
+        {
+            kill[id] = defines_operand(id);
+            // Operands dominate their uses, so a block defining one computes the expression after it.
+            if (!kill[id])
+            {
+                for (const auto& instr : func.block_instructions(id))
+                    use[id] = use[id] || (movable(instr) && Expression { instr.opcode, instr.operand1, instr.operand2 } == expr);
+            }
+        }
+
+        Placement placement = place(graph, use, kill);
+        bool moves = false;
+        for (size_t node = 0; node < graph.size(); ++node)
+            moves = moves || placement.insert[node];
+        if (!moves)
+            continue;
+
+        const IROperand temp = func.new_temp();
+        const IRInstruction compute(expr.opcode, temp, expr.a, expr.b);
+        for (int node = 0; node < static_cast<int>(graph.size()); ++node)
+        {
+            if (!placement.insert[node])
+                continue;
+            if (node < static_cast<int>(blocks))
+            {
+                std::vector<IRInstruction> instrs { compute };
+                instrs.insert(instrs.end(), func.block_instructions(node).begin(), func.block_instructions(node).end());
+                func.set_block_instructions(node, instrs);
+                continue;
+            }
+            if (split[node] < 0)
+            {
+                auto [from, to] = graph.edge(node, blocks);
+                split[node] = func.add_block(func.new_label("pre"));
+                func.append(split[node], IRInstruction(IROpcode::JUMP, {}, IROperand::block(to)));
+                func.terminator(from).retarget(to, split[node]);
+                for (auto& phi : func.blocks[to].phis)
+                {
+                    for (auto& in : phi.incoming)
+                    {
+                        if (in.block == from)
+                            in.block = split[node];
+                    }
+                }
+            }
+            std::vector<IRInstruction> instrs(func.block_instructions(split[node]).begin(), func.block_instructions(split[node]).end());
+            instrs.insert(instrs.end() - 1, compute);
+            func.set_block_instructions(split[node], instrs);
+        }
+        for (BlockId id = 0; id < static_cast<BlockId>(blocks); ++id)
+        {
+            if (!placement.replace[id])
+                continue;
+            for (auto& instr : func.block_instructions(id))
+            {
+                if (!(instr.result == temp) && movable(instr) && Expression { instr.opcode, instr.operand1, instr.operand2 } == expr)
+                    instr = IRInstruction(IROpcode::ASSIGN, instr.result, temp);
+            }
+        }
+        changed = true;
+    }
+
+    // Each new temp is defined once per insertion point; renaming merges them.
+    if (changed)
+        SSAConstruction().run(func);
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,44 @@
+#include "minic/Pass.hpp"
+#include <iostream>
+#include <stdexcept>
+
+namespace minic
+{
+
+void PassManager::add(std::unique_ptr<IRPass> pass)
+{
+    passes_.push_back(std::move(pass));
+}
+
+bool PassManager::run(IRFunction& func)
+{
+    bool changed = false;
+    for (auto& pass : passes_)
+    {
+        if (!pass->run(func))
+            continue;
+        changed = true;
+        func.compact();
+        try
+        {
+            func.verify();
+        }
+        catch (const std::runtime_error& e)
+        {
+            throw std::runtime_error("After pass " + pass->name() + ": " + e.what());
+        }
+        if (verbose_)
+            std::cerr << "[PassManager] " << pass->name() << " changed " << func.name << '\n';
+    }
+    return changed;
+}
+
+bool PassManager::run(IRProgram& program)
+{
+    bool changed = false;
+    for (auto& func : program.functions)
+        changed |= run(*func);
+    return changed;
+}
+
+} // namespace minic
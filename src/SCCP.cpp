@@ -0,0 +1,362 @@
+#include "minic/SCCP.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief A temp's value in the constant lattice: UNDEFINED > CONSTANT > OVERDEFINED.
+ */
+struct LatticeValue
+{
+    enum State : std::uint8_t
+    {
+        UNDEFINED,
+        CONSTANT,
+        OVERDEFINED
+    };
+
+    State state = UNDEFINED;
+    std::int32_t value = 0; ///< Meaningful only for CONSTANT
+
+    static LatticeValue constant(std::int32_t v) { return { CONSTANT, v }; }
+    static LatticeValue overdefined() { return { OVERDEFINED, 0 }; }
+    bool operator==(const LatticeValue&) const = default;
+};
+
+/**
+ * @brief Greatest lower bound of two lattice values.
+ */
+LatticeValue meet(LatticeValue a, LatticeValue b)
+{
+    if (a.state == LatticeValue::UNDEFINED)
+        return b;
+    if (b.state == LatticeValue::UNDEFINED)
+        return a;
+    if (a == b)
+        return a;
+    return LatticeValue::overdefined();
+}
+
+/**
+ * @brief The propagation state for one function: lattice values, executable
+ * edges and the two worklists.
+ */
+class Solver
+{
+public:
+    explicit Solver(const IRFunction& func)
+        : func_(func)
+        , values_(func.temp_count)
+        , phi_uses_(func.temp_count)
+        , instr_uses_(func.temp_count)
+        , block_of_(func.instructions.size(), -1)
+        , executable_(func.blocks.size(), false)
+        , executable_preds_(func.blocks.size())
+    {
+        std::vector<int> defs(func.temp_count, 0);
+        auto note_use = [&](const IROperand& op, std::uint32_t index) {
+            if (op.is_temp())
+                instr_uses_.at(op.value).push_back(index);
+        };
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            const BasicBlock& block = func.blocks[id];
+            for (std::uint32_t p = 0; p < block.phis.size(); ++p)
+            {
+                const PhiNode& phi = block.phis[p];
+                if (phi.result.is_temp())
+                    ++defs.at(phi.result.value);
+                for (const auto& in : phi.incoming)
+                {
+                    if (in.value.is_temp())
+                        phi_uses_.at(in.value.value).push_back({ id, p });
+                }
+            }
+            for (std::uint32_t i = block.begin; i < block.begin + block.size; ++i)
+            {
+                const IRInstruction& instr = func.instructions[i];
+                block_of_[i] = id;
+                note_use(instr.operand1, i);
+                note_use(instr.operand2, i);
+                if (!instr.is_terminator() && instr.result.is_temp())
+                    ++defs.at(instr.result.value);
+            }
+        }
+        // Without a single definition a temp cannot be tracked as one value.
+        for (size_t t = 0; t < defs.size(); ++t)
+        {
+            if (defs[t] != 1)
+                values_[t] = LatticeValue::overdefined();
+        }
+    }
+
+    void solve()
+    {
+        flow_work_.push_back({ -1, 0 });
+        do
+            propagate();
+        while (resolve_undefined_branches());
+    }
+
+    bool executable(BlockId block) const { return executable_[block]; }
+
+    bool edge_executable(BlockId from, BlockId to) const
+    {
+        return std::ranges::find(executable_preds_[to], from) != executable_preds_[to].end();
+    }
+
+    LatticeValue value_of(const IROperand& op) const
+    {
+        if (op.is_imm())
+            return LatticeValue::constant(op.value);
+        if (op.is_temp())
+            return values_[op.value];
+        return LatticeValue::overdefined();
+    }
+
+private:
+    /**
+     * @brief Run the worklists until both are empty.
+     */
+    void propagate()
+    {
+        while (!flow_work_.empty() || !ssa_work_.empty())
+        {
+            while (!flow_work_.empty())
+            {
+                auto [from, to] = flow_work_.back();
+                flow_work_.pop_back();
+                visit_edge(from, to);
+            }
+            while (!ssa_work_.empty())
+            {
+                std::int32_t temp = ssa_work_.back();
+                ssa_work_.pop_back();
+                for (auto [block, phi] : phi_uses_[temp])
+                {
+                    if (executable_[block])
+                        visit_phi(block, func_.blocks[block].phis[phi]);
+                }
+                for (std::uint32_t index : instr_uses_[temp])
+                {
+                    if (executable_[block_of_[index]])
+                        visit_instruction(block_of_[index], func_.instructions[index]);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Mark one edge of each executable conditional jump whose condition is still undefined.
+     *
+     * Such a condition has no executable definition (it reads a value the
+     * input never defines, say); without an executable edge the rewrite would
+     * remove both targets. The other target (result) is taken.
+     *
+     * @return Whether any edge was marked.
+     */
+    bool resolve_undefined_branches()
+    {
+        bool marked = false;
+        for (BlockId id = 0; id < static_cast<BlockId>(func_.blocks.size()); ++id)
+        {
+            if (!executable_[id])
+                continue;
+            const IRInstruction& term = func_.terminator(id);
+            if ((term.opcode != IROpcode::JUMPIF && term.opcode != IROpcode::JUMPIFNOT) || value_of(term.operand1).state != LatticeValue::UNDEFINED)
+                continue;
+            if (edge_executable(id, term.operand2.value) || edge_executable(id, term.result.value))
+                continue;
+            flow_work_.push_back({ id, term.result.value });
+            marked = true;
+        }
+        return marked;
+    }
+
+    void visit_edge(BlockId from, BlockId to)
+    {
+        if (from >= 0)
+        {
+            if (edge_executable(from, to))
+                return;
+            executable_preds_[to].push_back(from);
+        }
+        for (const auto& phi : func_.blocks[to].phis)
+            visit_phi(to, phi);
+        if (executable_[to])
+            return;
+        executable_[to] = true;
+        for (const auto& instr : func_.block_instructions(to))
+            visit_instruction(to, instr);
+    }
+
+    void visit_phi(BlockId block, const PhiNode& phi)
+    {
+        LatticeValue value;
+        for (const auto& in : phi.incoming)
+        {
+            if (edge_executable(in.block, block))
+                value = meet(value, value_of(in.value));
+        }
+        lower(phi.result, value);
+    }
+
+    void visit_instruction(BlockId block, const IRInstruction& instr)
+    {
+        switch (instr.opcode)
+        {
+        case IROpcode::JUMP:
+            flow_work_.push_back({ block, instr.operand1.value });
+            return;
+        case IROpcode::JUMPIF:
+        case IROpcode::JUMPIFNOT:
+        {
+            LatticeValue cond = value_of(instr.operand1);
+            if (cond.state == LatticeValue::UNDEFINED)
+                return;
+            if (cond.state == LatticeValue::OVERDEFINED)
+            {
+                flow_work_.push_back({ block, instr.operand2.value });
+                flow_work_.push_back({ block, instr.result.value });
+                return;
+            }
+            bool to_operand2 = instr.opcode == IROpcode::JUMPIF ? cond.value != 0 : cond.value == 0;
+            flow_work_.push_back({ block, to_operand2 ? instr.operand2.value : instr.result.value });
+            return;
+        }
+        case IROpcode::RETURN:
+            return;
+        default:
+            break;
+        }
+        if (!instr.result.is_temp())
+            return;
+
+        LatticeValue a = value_of(instr.operand1);
+        LatticeValue b = instr.operand2.empty() ? LatticeValue::constant(0) : value_of(instr.operand2);
+        if (instr.operand1.is_str() || a.state == LatticeValue::OVERDEFINED || b.state == LatticeValue::OVERDEFINED)
+        {
+            lower(instr.result, LatticeValue::overdefined());
+            return;
+        }
+        if (a.state == LatticeValue::UNDEFINED || b.state == LatticeValue::UNDEFINED)
+            return;
+        // A trapping division or a value wider than an immediate is not folded.
+        auto folded = fold_constant(instr.opcode, IROperand::imm(a.value), IROperand::imm(b.value));
+        lower(instr.result, folded ? LatticeValue::constant(folded->value) : LatticeValue::overdefined());
+    }
+
+    void lower(const IROperand& temp, LatticeValue value)
+    {
+        LatticeValue& current = values_[temp.value];
+        LatticeValue lowered = meet(current, value);
+        if (lowered == current)
+            return;
+        current = lowered;
+        ssa_work_.push_back(temp.value);
+    }
+
+    const IRFunction& func_;
+    std::vector<LatticeValue> values_; ///< Lattice value per temp
+    std::vector<std::vector<std::pair<BlockId, std::uint32_t>>> phi_uses_; ///< Phis (block, index) reading each temp
+    std::vector<std::vector<std::uint32_t>> instr_uses_; ///< Arena indices of instructions reading each temp
+    std::vector<BlockId> block_of_; ///< Block owning each arena slot
+    std::vector<bool> executable_; ///< Whether any executable edge reaches the block
+    std::vector<std::vector<BlockId>> executable_preds_; ///< Sources of the executable edges into each block
+    std::vector<std::pair<BlockId, BlockId>> flow_work_; ///< Edges to mark executable
+    std::vector<std::int32_t> ssa_work_; ///< Temps whose value was lowered
+};
+
+} // namespace
+
+bool SCCP::run(IRFunction& func)
+{
+    Solver solver(func);
+    solver.solve();
+
+    bool changed = false;
+    auto replace = [&](IROperand& op) {
+        LatticeValue value = solver.value_of(op);
+        if (op.is_temp() && value.state == LatticeValue::CONSTANT)
+        {
+            op = IROperand::imm(value.value);
+            changed = true;
+        }
+    };
+
+    std::vector<bool> dead(func.blocks.size(), false);
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (!solver.executable(id))
+        {
+            dead[id] = true;
+            continue;
+        }
+        BasicBlock& block = func.blocks[id];
+        // A constant phi has no uses left once they are all replaced.
+        changed |= std::erase_if(block.phis, [&](const PhiNode& phi) { return solver.value_of(phi.result).state == LatticeValue::CONSTANT; }) > 0;
+        for (auto& phi : block.phis)
+        {
+            for (auto& in : phi.incoming)
+                replace(in.value);
+        }
+
+        for (auto& instr : func.block_instructions(id))
+        {
+            if (instr.is_terminator())
+                continue;
+            LatticeValue value = solver.value_of(instr.result);
+            if (instr.result.is_temp() && value.state == LatticeValue::CONSTANT)
+            {
+                if (!(instr.opcode == IROpcode::ASSIGN && instr.operand1 == IROperand::imm(value.value)))
+                {
+                    instr = IRInstruction(IROpcode::ASSIGN, instr.result, IROperand::imm(value.value));
+                    changed = true;
+                }
+                continue;
+            }
+            replace(instr.operand1);
+            replace(instr.operand2);
+        }
+
+        IRInstruction& term = func.block_instructions(id).back();
+        if (term.opcode == IROpcode::RETURN)
+        {
+            replace(term.operand1);
+        }
+        else if (term.opcode == IROpcode::JUMPIF || term.opcode == IROpcode::JUMPIFNOT)
+        {
+            BlockId a = term.operand2.value;
+            BlockId b = term.result.value;
+            bool a_taken = solver.edge_executable(id, a);
+            bool b_taken = solver.edge_executable(id, b);
+            if (a != b && a_taken != b_taken)
+            {
+                BlockId dropped = a_taken ? b : a;
+                for (auto& phi : func.blocks[dropped].phis)
+                    std::erase_if(phi.incoming, [&](const PhiIncoming& in) { return in.block == id; });
+                term = IRInstruction(IROpcode::JUMP, {}, IROperand::block(a_taken ? a : b));
+                changed = true;
+            }
+            else
+            {
+                replace(term.operand1);
+            }
+        }
+    }
+
+    if (std::ranges::find(dead, true) != dead.end())
+    {
+        func.remove_blocks(dead);
+        changed = true;
+    }
+    return changed;
+}
+
+} // namespace minic
@@ -0,0 +1,504 @@
+#include "minic/SSA.hpp"
+#include "minic/CFG.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief Delete blocks the entry cannot reach; they would never be renamed.
+ */
+bool remove_unreachable_blocks(IRFunction& func)
+{
+    ControlFlowGraph cfg(func);
+    std::vector<bool> dead(func.blocks.size(), false);
+    bool any = false;
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (!cfg.reachable(id))
+            dead[id] = any = true;
+    }
+    if (any)
+        func.remove_blocks(dead);
+    return any;
+}
+
+/**
+ * @brief Lower a parallel copy (all sources read before any destination is written)
+ * to a sequence of ASSIGNs, breaking cycles with a scratch temp.
+ */
+std::vector<IRInstruction> sequentialize_copies(IRFunction& func, std::vector<std::pair<IROperand, IROperand>> copies)
+{
+    std::erase_if(copies, [](const auto& copy) { return copy.first == copy.second; });
+    std::vector<IRInstruction> out;
+    while (!copies.empty())
+    {
+        // A copy is safe to emit once no pending copy still reads its destination.
+        auto ready = std::find_if(copies.begin(), copies.end(), [&](const auto& copy) {
+            return std::none_of(copies.begin(), copies.end(), [&](const auto& other) { return other.second == copy.first; });
+        });
+        if (ready != copies.end())
+        {
+            out.emplace_back(IROpcode::ASSIGN, ready->first, ready->second);
+            copies.erase(ready);
+            continue;
+        }
+
+        // Only cycles are left: save one destination and read the saved copy instead.
+        IROperand dst = copies.front().first;
+        IROperand saved = func.new_temp();
+        out.emplace_back(IROpcode::ASSIGN, saved, dst);
+        for (auto& copy : copies)
+        {
+            if (copy.second == dst)
+                copy.second = saved;
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Whether the copies for the edge pred -> id may go at the end of pred
+ * although pred also branches elsewhere.
+ *
+ * They may when neither pred's branch nor anything reachable from its other
+ * successors before passing through id again reads one of id's phi results.
+ */
+bool copies_fit_before_branch(const IRFunction& func, const ControlFlowGraph& cfg, BlockId pred, BlockId id)
+{
+    std::vector<bool> result(func.temp_count, false);
+    for (const auto& phi : func.blocks[id].phis)
+        result[phi.result.value] = true;
+    auto reads = [&](const IROperand& op) { return op.is_temp() && result[op.value]; };
+    auto reads_on_edge = [&](BlockId from, BlockId to) {
+        return std::any_of(func.blocks[to].phis.begin(), func.blocks[to].phis.end(), [&](const PhiNode& phi) { return reads(phi.value_from(from)); });
+    };
+    if (reads(func.terminator(pred).operand1))
+        return false;
+
+    std::vector<bool> seen(func.blocks.size(), false);
+    std::vector<BlockId> work;
+    for (BlockId succ : cfg.successors(pred))
+    {
+        if (succ == id)
+            continue;
+        if (reads_on_edge(pred, succ))
+            return false;
+        work.push_back(succ);
+    }
+    while (!work.empty())
+    {
+        BlockId block = work.back();
+        work.pop_back();
+        if (seen[block])
+            continue;
+        seen[block] = true;
+        for (const auto& instr : func.block_instructions(block))
+        {
+            if (reads(instr.operand1) || reads(instr.operand2))
+                return false;
+        }
+        for (BlockId succ : cfg.successors(block))
+        {
+            if (reads_on_edge(block, succ))
+                return false;
+            if (succ != id)
+                work.push_back(succ);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool SSAConstruction::run(IRFunction& func)
+{
+    // A SELECT reads the result it writes, which a single SSA definition cannot express.
+    for (const auto& block : func.blocks)
+    {
+        for (const auto& instr : func.block_instructions(block))
+        {
+            if (instr.opcode == IROpcode::SELECT)
+                throw std::runtime_error("Function " + func.name + " has a SELECT in block " + block.label + " and cannot be put into SSA form");
+        }
+    }
+
+    bool changed = remove_unreachable_blocks(func);
+    ControlFlowGraph cfg(func);
+    const size_t block_count = func.blocks.size();
+
+    // Slots are every variable plus every temp that does not have exactly one definition.
+    const int var_count = static_cast<int>(func.variables.size());
+    std::vector<int> temp_defs(func.temp_count, 0);
+    std::vector<bool> temp_seen(func.temp_count, false);
+    auto note_temp = [&](const IROperand& op, bool def) {
+        if (!op.is_temp())
+            return;
+        if (static_cast<size_t>(op.value) >= temp_seen.size())
+        {
+            temp_seen.resize(op.value + 1, false);
+            temp_defs.resize(op.value + 1, 0);
+        }
+        temp_seen[op.value] = true;
+        if (def)
+            ++temp_defs[op.value];
+    };
+    for (BlockId id = 0; id < static_cast<BlockId>(block_count); ++id)
+    {
+        for (const auto& phi : func.blocks[id].phis)
+        {
+            note_temp(phi.result, true);
+            for (const auto& in : phi.incoming)
+                note_temp(in.value, false);
+        }
+        for (const auto& instr : func.block_instructions(id))
+        {
+            note_temp(instr.result, !instr.is_terminator());
+            note_temp(instr.operand1, false);
+            note_temp(instr.operand2, false);
+        }
+    }
+
+    std::vector<IROperand> slot_operand;
+    for (int v = 0; v < var_count; ++v)
+        slot_operand.push_back(IROperand::var(v));
+    std::vector<int> temp_slot(temp_seen.size(), -1);
+    for (size_t t = 0; t < temp_seen.size(); ++t)
+    {
+        if (temp_seen[t] && temp_defs[t] != 1)
+        {
+            temp_slot[t] = static_cast<int>(slot_operand.size());
+            slot_operand.push_back(IROperand::temp(static_cast<std::int32_t>(t)));
+        }
+    }
+    const size_t slot_count = slot_operand.size();
+    auto slot_of = [&](const IROperand& op) {
+        if (op.is_var())
+            return static_cast<int>(op.value);
+        if (op.is_temp() && static_cast<size_t>(op.value) < temp_slot.size())
+            return temp_slot[op.value];
+        return -1;
+    };
+
+    // Where each slot is defined, and which slots are read before being
+    // defined in some block (only those can need a phi).
+    std::vector<std::vector<BlockId>> def_blocks(slot_count);
+    std::vector<bool> global(slot_count, false);
+    std::vector<BlockId> defined_in(slot_count, -1);
+    for (BlockId id = 0; id < static_cast<BlockId>(block_count); ++id)
+    {
+        auto define = [&](int slot) {
+            if (slot < 0 || defined_in[slot] == id)
+                return;
+            defined_in[slot] = id;
+            def_blocks[slot].push_back(id);
+        };
+        auto use = [&](int slot) {
+            if (slot >= 0 && defined_in[slot] != id)
+                global[slot] = true;
+        };
+        for (const auto& phi : func.blocks[id].phis)
+        {
+            // Incoming values are read at the end of a predecessor; treat them as live across blocks.
+            for (const auto& in : phi.incoming)
+            {
+                if (slot_of(in.value) >= 0)
+                    global[slot_of(in.value)] = true;
+            }
+            define(slot_of(phi.result));
+        }
+        for (const auto& instr : func.block_instructions(id))
+        {
+            use(slot_of(instr.operand1));
+            use(slot_of(instr.operand2));
+            if (!instr.is_terminator())
+                define(slot_of(instr.result));
+        }
+    }
+
+    // Place phis at the iterated dominance frontier of each slot's definitions.
+    std::vector<size_t> first_new_phi(block_count);
+    for (size_t id = 0; id < block_count; ++id)
+        first_new_phi[id] = func.blocks[id].phis.size();
+    std::vector<int> has_phi(block_count, -1);
+    std::vector<int> queued(block_count, -1);
+    for (size_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (!global[slot])
+            continue;
+        const int s = static_cast<int>(slot);
+        std::vector<BlockId> worklist = def_blocks[slot];
+        for (BlockId id : worklist)
+            queued[id] = s;
+        while (!worklist.empty())
+        {
+            BlockId block = worklist.back();
+            worklist.pop_back();
+            for (BlockId join : cfg.dominance_frontier(block))
+            {
+                if (has_phi[join] == s)
+                    continue;
+                has_phi[join] = s;
+                auto& phis = func.blocks[join].phis;
+                bool exists = std::any_of(phis.begin(), phis.end(), [&](const PhiNode& phi) { return phi.result == slot_operand[slot]; });
+                if (!exists)
+                {
+                    PhiNode phi;
+                    phi.result = slot_operand[slot];
+                    for (BlockId pred : cfg.predecessors(join))
+                        phi.incoming.push_back({ pred, slot_operand[slot] });
+                    phis.push_back(std::move(phi));
+                    changed = true;
+                }
+                if (queued[join] != s)
+                {
+                    queued[join] = s;
+                    worklist.push_back(join);
+                }
+            }
+        }
+    }
+
+    // Rename along the dominator tree. Each slot has a stack of reaching
+    // values; a slot with no definition yet reads as the parameter's incoming
+    // value, or 0 for locals.
+    const size_t param_count = func.parameters.size();
+    std::vector<std::vector<IROperand>> stacks(slot_count);
+    auto current = [&](int slot) {
+        if (!stacks[slot].empty())
+            return stacks[slot].back();
+        if (static_cast<size_t>(slot) < param_count)
+            return IROperand::var(slot);
+        return IROperand::imm(0);
+    };
+    auto rename_use = [&](IROperand& op) {
+        int slot = slot_of(op);
+        if (slot < 0)
+            return;
+        IROperand value = current(slot);
+        if (!(value == op))
+        {
+            op = value;
+            changed = true;
+        }
+    };
+
+    std::vector<bool> new_phi_temp;
+    auto mark_new_phi = [&](const IROperand& temp) {
+        if (static_cast<size_t>(temp.value) >= new_phi_temp.size())
+            new_phi_temp.resize(temp.value + 1, false);
+        new_phi_temp[temp.value] = true;
+    };
+
+    struct Frame
+    {
+        BlockId block;
+        size_t next_child;
+        std::vector<int> pushed;
+    };
+    std::vector<Frame> walk;
+    auto enter = [&](BlockId id) {
+        Frame frame { id, 0, {} };
+        auto& phis = func.blocks[id].phis;
+        for (size_t i = 0; i < phis.size(); ++i)
+        {
+            int slot = slot_of(phis[i].result);
+            if (slot < 0)
+                continue;
+            IROperand temp = func.new_temp();
+            phis[i].result = temp;
+            stacks[slot].push_back(temp);
+            frame.pushed.push_back(slot);
+            if (i >= first_new_phi[id])
+                mark_new_phi(temp);
+            changed = true;
+        }
+
+        std::vector<IRInstruction> renamed;
+        auto instrs = func.block_instructions(id);
+        renamed.reserve(instrs.size());
+        bool block_changed = false;
+        for (IRInstruction instr : instrs)
+        {
+            IRInstruction before = instr;
+            rename_use(instr.operand1);
+            rename_use(instr.operand2);
+            int slot = instr.is_terminator() ? -1 : slot_of(instr.result);
+            if (slot >= 0)
+            {
+                // A plain copy needs no code: later reads use the copied value.
+                // String addresses stay materialized in a temp.
+                if (instr.opcode == IROpcode::ASSIGN && !instr.operand1.is_str())
+                {
+                    stacks[slot].push_back(instr.operand1);
+                    frame.pushed.push_back(slot);
+                    block_changed = true;
+                    continue;
+                }
+                instr.result = func.new_temp();
+                stacks[slot].push_back(instr.result);
+                frame.pushed.push_back(slot);
+            }
+            block_changed |= !(instr.result == before.result && instr.operand1 == before.operand1 && instr.operand2 == before.operand2);
+            renamed.push_back(instr);
+        }
+        if (block_changed)
+        {
+            func.set_block_instructions(id, renamed);
+            changed = true;
+        }
+
+        for (BlockId succ : cfg.successors(id))
+        {
+            for (auto& phi : func.blocks[succ].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == id)
+                        rename_use(in.value);
+                }
+            }
+        }
+        walk.push_back(std::move(frame));
+    };
+
+    if (block_count > 0)
+        enter(0);
+    while (!walk.empty())
+    {
+        Frame& frame = walk.back();
+        const auto& children = cfg.dom_children(frame.block);
+        if (frame.next_child < children.size())
+        {
+            enter(children[frame.next_child++]);
+            continue;
+        }
+        for (int slot : frame.pushed)
+            stacks[slot].pop_back();
+        walk.pop_back();
+    }
+
+    // Drop inserted phis whose value is never needed (semi-pruned SSA still
+    // places some for slots that are dead at the join).
+    std::vector<bool> live(func.temp_count, false);
+    auto mark_live = [&](const IROperand& op) {
+        if (op.is_temp() && !live[op.value])
+        {
+            live[op.value] = true;
+            return true;
+        }
+        return false;
+    };
+    for (const auto& block : func.blocks)
+    {
+        for (const auto& instr : func.block_instructions(block))
+        {
+            mark_live(instr.operand1);
+            mark_live(instr.operand2);
+        }
+    }
+    auto is_new = [&](const IROperand& op) { return static_cast<size_t>(op.value) < new_phi_temp.size() && new_phi_temp[op.value]; };
+    for (bool grew = true; grew;)
+    {
+        grew = false;
+        for (const auto& block : func.blocks)
+        {
+            for (const auto& phi : block.phis)
+            {
+                if (is_new(phi.result) && !live[phi.result.value])
+                    continue;
+                for (const auto& in : phi.incoming)
+                    grew |= mark_live(in.value);
+            }
+        }
+    }
+    for (auto& block : func.blocks)
+        std::erase_if(block.phis, [&](const PhiNode& phi) { return is_new(phi.result) && !live[phi.result.value]; });
+
+    return changed;
+}
+
+bool SSADestruction::run(IRFunction& func)
+{
+    bool has_phis = std::any_of(func.blocks.begin(), func.blocks.end(), [](const BasicBlock& block) { return !block.phis.empty(); });
+    if (!has_phis)
+        return false;
+
+    // Split edges that leave a conditional branch and enter a phi block, so
+    // every predecessor of a phi block has that block as its only successor.
+    // A back edge stays when its copies can go before the branch: a loop that
+    // tests at the bottom then keeps a single conditional jump per iteration.
+    const BlockId original_count = static_cast<BlockId>(func.blocks.size());
+    {
+        ControlFlowGraph cfg(func);
+        std::vector<std::pair<BlockId, BlockId>> splits;
+        for (BlockId id = 0; id < original_count; ++id)
+        {
+            if (func.blocks[id].phis.empty())
+                continue;
+            for (BlockId pred : cfg.predecessors(id))
+            {
+                if (func.terminator(pred).opcode == IROpcode::JUMP)
+                    continue;
+                if (cfg.dominates(id, pred) && copies_fit_before_branch(func, cfg, pred, id))
+                    continue;
+                splits.emplace_back(pred, id);
+            }
+        }
+        for (const auto& [pred, id] : splits)
+        {
+            BlockId split = func.add_block(func.new_label("split"));
+            func.append(split, IRInstruction(IROpcode::JUMP, {}, IROperand::block(id)));
+            func.terminator(pred).retarget(id, split);
+            for (auto& phi : func.blocks[id].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == pred)
+                        in.block = split;
+                }
+            }
+        }
+    }
+
+    // Each predecessor performs the parallel copy of its phi values just
+    // before its jump (or branch, on a back edge left in place).
+    ControlFlowGraph cfg(func);
+    for (BlockId id = 0; id < original_count; ++id)
+    {
+        const auto& phis = func.blocks[id].phis;
+        if (phis.empty())
+            continue;
+        for (BlockId pred : cfg.predecessors(id))
+        {
+            std::vector<std::pair<IROperand, IROperand>> copies;
+            for (const auto& phi : phis)
+            {
+                IROperand value = phi.value_from(pred);
+                if (value.empty())
+                    throw std::runtime_error("Phi in " + func.name + " block " + func.blocks[id].label + " has no value for predecessor " + func.blocks[pred].label);
+                copies.emplace_back(phi.result, value);
+            }
+            std::vector<IRInstruction> seq = sequentialize_copies(func, copies);
+            if (seq.empty())
+                continue;
+            auto instrs = func.block_instructions(pred);
+            std::vector<IRInstruction> rewritten(instrs.begin(), instrs.end() - 1);
+            rewritten.insert(rewritten.end(), seq.begin(), seq.end());
+            rewritten.push_back(instrs.back());
+            func.set_block_instructions(pred, rewritten);
+        }
+    }
+
+    for (auto& block : func.blocks)
+        block.phis.clear();
+    return true;
+}
+
+} // namespace minic
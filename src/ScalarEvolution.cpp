@@ -0,0 +1,523 @@
+#include "minic/ScalarEvolution.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace minic
+{
+
+namespace
+{
+
+/**
+ * @brief Trip count of `x < bound` for x starting at start and growing by step, if it exists without wrapping.
+ */
+std::optional<std::int64_t> count_less(std::int64_t start, std::int64_t step, std::int64_t bound)
+{
+    if (start >= bound)
+        return 0;
+    if (step <= 0)
+        return std::nullopt;
+    std::int64_t diff;
+    if (__builtin_sub_overflow(bound, start, &diff))
+        return std::nullopt;
+    std::int64_t count = diff / step + (diff % step != 0);
+    // The counter must reach its last value without wrapping.
+    std::int64_t last;
+    if (__builtin_mul_overflow(count, step, &last) || __builtin_add_overflow(last, start, &last))
+        return std::nullopt;
+    return count;
+}
+
+/**
+ * @brief Trip count of a loop that runs while `x op bound` holds.
+ */
+std::optional<std::int64_t> count_iterations(IROpcode op, std::int64_t start, std::int64_t step, std::int64_t bound)
+{
+    constexpr std::int64_t min = std::numeric_limits<std::int64_t>::min();
+    constexpr std::int64_t max = std::numeric_limits<std::int64_t>::max();
+    switch (op)
+    {
+    case IROpcode::LT:
+        return count_less(start, step, bound);
+    case IROpcode::LE:
+        if (bound == max)
+            return std::nullopt;
+        return count_less(start, step, bound + 1);
+    case IROpcode::GT:
+        if (start == min || bound == min)
+            return std::nullopt;
+        return count_less(-start, -step, -bound);
+    case IROpcode::GE:
+        if (start == min || bound == min)
+            return std::nullopt;
+        return count_iterations(IROpcode::LE, -start, -step, -bound);
+    case IROpcode::NEQ:
+    {
+        std::int64_t diff;
+        if (__builtin_sub_overflow(bound, start, &diff))
+            return std::nullopt;
+        if (diff == 0)
+            return 0;
+        if (step == 0 || diff % step != 0 || diff / step < 0)
+            return std::nullopt;
+        return diff / step;
+    }
+    case IROpcode::EQ:
+        if (start != bound)
+            return 0;
+        return step == 0 ? std::nullopt : std::optional<std::int64_t>(1);
+    default:
+        return std::nullopt;
+    }
+}
+
+bool is_zero(const IROperand& op)
+{
+    return op == IROperand::imm(0);
+}
+
+} // namespace
+
+int Recurrence::degree() const
+{
+    for (int i = 2; i > 0; --i)
+    {
+        if (!is_zero(coeffs[i]))
+            return i;
+    }
+    return 0;
+}
+
+ScalarEvolution::ScalarEvolution(IRFunction& func, const Loop& loop)
+    : func_(func)
+    , loop_(loop)
+    , def_block_(func.temp_count, -1)
+    , def_(func.temp_count, nullptr)
+    , var_written_(func.variables.size(), false)
+    , cache_(func.temp_count)
+    , in_progress_(func.temp_count, false)
+{
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        for (const auto& phi : func.blocks[id].phis)
+            def_block_.at(phi.result.value) = id;
+        for (const auto& instr : func.block_instructions(id))
+        {
+            if (instr.is_terminator())
+                continue;
+            if (instr.result.is_temp())
+            {
+                def_block_.at(instr.result.value) = id;
+                def_[instr.result.value] = &instr;
+            }
+            else if (instr.result.is_var() && loop.contains(id))
+                var_written_.at(instr.result.value) = true;
+        }
+    }
+}
+
+bool ScalarEvolution::invariant(const IROperand& op) const
+{
+    if (op.is_temp())
+    {
+        // Temps created for coefficients are computed outside the loop.
+        return static_cast<size_t>(op.value) >= def_block_.size() || !loop_.contains(def_block_[op.value]);
+    }
+    if (op.is_var())
+        return !var_written_[op.value];
+    return op.is_imm();
+}
+
+IROperand ScalarEvolution::compute(IROpcode op, const IROperand& a, const IROperand& b)
+{
+    if (auto folded = fold_constant(op, a, b))
+        return *folded;
+    IROperand t = func_.new_temp();
+    code_.push_back(IRInstruction(op, t, a, b));
+    return t;
+}
+
+IROperand ScalarEvolution::add(const IROperand& a, const IROperand& b)
+{
+    if (is_zero(a))
+        return b;
+    if (is_zero(b))
+        return a;
+    return compute(IROpcode::ADD, a, b);
+}
+
+IROperand ScalarEvolution::sub(const IROperand& a, const IROperand& b)
+{
+    if (is_zero(b))
+        return a;
+    if (is_zero(a))
+        return compute(IROpcode::NEG, b, {});
+    return compute(IROpcode::SUB, a, b);
+}
+
+IROperand ScalarEvolution::mul(const IROperand& a, const IROperand& b)
+{
+    if (is_zero(a) || is_zero(b))
+        return IROperand::imm(0);
+    if (a == IROperand::imm(1))
+        return b;
+    if (b == IROperand::imm(1))
+        return a;
+    return compute(IROpcode::MUL, a, b);
+}
+
+std::optional<Recurrence> ScalarEvolution::recurrence(const IROperand& value)
+{
+    auto term = analyze(value);
+    if (!term || term->self != 0)
+        return std::nullopt;
+    return term->rec;
+}
+
+std::optional<ScalarEvolution::Term> ScalarEvolution::analyze(const IROperand& op)
+{
+    if (invariant(op))
+    {
+        Term term { 0, {} };
+        term.rec.coeffs[0] = op;
+        return term;
+    }
+    if (!op.is_temp())
+        return std::nullopt;
+    if (op == solving_)
+    {
+        Term term { 1, {} };
+        return term;
+    }
+    if (cache_[op.value])
+        return Term { 0, *cache_[op.value] };
+
+    std::optional<Term> term;
+    if (def_block_[op.value] == loop_.header && !def_[op.value])
+    {
+        for (const auto& phi : func_.blocks[loop_.header].phis)
+        {
+            if (phi.result == op)
+                term = solve_phi(phi);
+        }
+    }
+    else if (def_[op.value])
+        term = analyze_instruction(*def_[op.value]);
+    // Only values that do not depend on the phi being solved are final.
+    if (term && term->self == 0)
+        cache_[op.value] = term->rec;
+    return term;
+}
+
+std::optional<ScalarEvolution::Term> ScalarEvolution::solve_phi(const PhiNode& phi)
+{
+    if (loop_.latches.size() != 1 || phi.incoming.size() != 2 || in_progress_[phi.result.value])
+        return std::nullopt;
+    const BlockId latch = loop_.latches[0];
+    const PhiIncoming& entering = phi.incoming[0].block == latch ? phi.incoming[1] : phi.incoming[0];
+    if (entering.block == latch || !invariant(entering.value))
+        return std::nullopt;
+
+    // Solve phi = phi(init, phi + step) with the phi itself as the unknown `self`.
+    IROperand outer = solving_;
+    solving_ = phi.result;
+    in_progress_[phi.result.value] = true;
+    auto next = analyze(phi.value_from(latch));
+    in_progress_[phi.result.value] = false;
+    solving_ = outer;
+    if (!next || next->self != 1 || next->rec.degree() > 1)
+        return std::nullopt;
+    Term term { 0, {} };
+    term.rec.coeffs = { entering.value, next->rec.coeffs[0], next->rec.coeffs[1] };
+    return term;
+}
+
+std::optional<ScalarEvolution::Term> ScalarEvolution::analyze_instruction(const IRInstruction& instr)
+{
+    switch (instr.opcode)
+    {
+    case IROpcode::ASSIGN:
+        return analyze(instr.operand1);
+    case IROpcode::NEG:
+    {
+        auto a = analyze(instr.operand1);
+        if (!a || a->self != 0)
+            return std::nullopt;
+        Term term { 0, {} };
+        for (size_t i = 0; i < 3; ++i)
+            term.rec.coeffs[i] = sub(IROperand::imm(0), a->rec.coeffs[i]);
+        return term;
+    }
+    case IROpcode::ADD:
+    case IROpcode::SUB:
+    {
+        auto a = analyze(instr.operand1);
+        auto b = a ? analyze(instr.operand2) : std::nullopt;
+        if (!b)
+            return std::nullopt;
+        bool adding = instr.opcode == IROpcode::ADD;
+        Term term { adding ? a->self + b->self : a->self - b->self, {} };
+        if (term.self != 0 && term.self != 1)
+            return std::nullopt;
+        for (size_t i = 0; i < 3; ++i)
+            term.rec.coeffs[i] = adding ? add(a->rec.coeffs[i], b->rec.coeffs[i]) : sub(a->rec.coeffs[i], b->rec.coeffs[i]);
+        return term;
+    }
+    case IROpcode::MUL:
+    {
+        auto a = analyze(instr.operand1);
+        auto b = a ? analyze(instr.operand2) : std::nullopt;
+        if (!b || a->self != 0 || b->self != 0)
+            return std::nullopt;
+        const auto& x = a->rec.coeffs;
+        const auto& y = b->rec.coeffs;
+        Term term { 0, {} };
+        if (a->rec.degree() == 0 || b->rec.degree() == 0)
+        {
+            const IROperand& scale = a->rec.degree() == 0 ? x[0] : y[0];
+            const auto& other = a->rec.degree() == 0 ? y : x;
+            for (size_t i = 0; i < 3; ++i)
+                term.rec.coeffs[i] = mul(other[i], scale);
+            return term;
+        }
+        if (a->rec.degree() > 1 || b->rec.degree() > 1)
+            return std::nullopt;
+        // (x0 + x1 k)(y0 + y1 k), with k^2 = 2 * k(k-1)/2 + k.
+        IROperand square = mul(x[1], y[1]);
+        term.rec.coeffs[0] = mul(x[0], y[0]);
+        term.rec.coeffs[1] = add(add(mul(x[0], y[1]), mul(x[1], y[0])), square);
+        term.rec.coeffs[2] = add(square, square);
+        return term;
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<LoopTest> ScalarEvolution::loop_test()
+{
+    const IRInstruction& term = func_.terminator(loop_.header);
+    if (term.opcode != IROpcode::JUMPIF && term.opcode != IROpcode::JUMPIFNOT)
+        return std::nullopt;
+    bool taken_stays = loop_.contains(term.operand2.value);
+    if (taken_stays == loop_.contains(term.result.value))
+        return std::nullopt;
+    const IROperand& cond = term.operand1;
+    if (!cond.is_temp() || static_cast<size_t>(cond.value) >= def_.size() || !def_[cond.value] || def_block_[cond.value] != loop_.header)
+        return std::nullopt;
+    const IRInstruction& cmp = *def_[cond.value];
+    if (!is_comparison(cmp.opcode))
+        return std::nullopt;
+
+    // Normalize to "the loop runs while x op bound" with x the varying side.
+    IROpcode op = cmp.opcode;
+    if ((term.opcode == IROpcode::JUMPIF) != taken_stays)
+        op = invert_comparison(op);
+    IROperand value = cmp.operand1;
+    IROperand limit = cmp.operand2;
+    auto x = recurrence(value);
+    auto bound = x ? recurrence(limit) : std::nullopt;
+    if (!bound)
+        return std::nullopt;
+    if (x->degree() == 0)
+    {
+        std::swap(x, bound);
+        std::swap(value, limit);
+        op = swap_comparison(op);
+    }
+    if (x->degree() != 1 || bound->degree() != 0 || !x->coeffs[1].is_imm())
+        return std::nullopt;
+    // The compared operand may be defined in the loop (a header phi that only
+    // feeds itself back, say); its solved value is available before it.
+    return LoopTest { value, op, bound->coeffs[0], *x };
+}
+
+std::optional<IROperand> ScalarEvolution::trip_count()
+{
+    auto test = loop_test();
+    if (!test)
+        return std::nullopt;
+    const IROpcode op = test->op;
+    const IROperand& start = test->rec.coeffs[0];
+    const IROperand& limit = test->bound;
+    std::int32_t step = test->rec.coeffs[1].value;
+
+    if (start.is_imm() && limit.is_imm())
+    {
+        auto count = count_iterations(op, start.value, step, limit.value);
+        if (!count || *count > std::numeric_limits<std::int32_t>::max())
+            return std::nullopt;
+        return IROperand::imm(static_cast<std::int32_t>(*count));
+    }
+    // Stepping by one to a strict bound stops exactly at it, without wrapping.
+    if (op == IROpcode::LT && step == 1)
+        return sub(limit, start);
+    if (op == IROpcode::GT && step == -1)
+        return sub(start, limit);
+    return std::nullopt;
+}
+
+IROperand ScalarEvolution::evaluate(const Recurrence& rec, const IROperand& k)
+{
+    IROperand value = add(rec.coeffs[0], mul(rec.coeffs[1], k));
+    if (is_zero(rec.coeffs[2]))
+        return value;
+    // k(k-1)/2 = h * (2k - 2h - 1) with h = k / 2, exact even where k(k-1) would overflow.
+    IROperand half = compute(IROpcode::DIV, k, IROperand::imm(2));
+    IROperand odd = sub(sub(add(k, k), add(half, half)), IROperand::imm(1));
+    return add(value, mul(rec.coeffs[2], mul(half, odd)));
+}
+
+bool LoopFolding::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = ensure_preheaders(func);
+    for (bool folded = true; folded;)
+    {
+        folded = false;
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        for (size_t index = loops.loops().size(); index-- > 0 && !folded;)
+        {
+            const Loop* loop = &loops.loops()[index];
+            const BlockId header = loop->header;
+            if (loop->latches.size() != 1 || loop->exits.size() != 1)
+                continue;
+            const BlockId exit = loop->exits[0];
+            if (cfg.predecessors(exit).size() != 1 || cfg.predecessors(header).size() != 2)
+                continue;
+            bool pure = true;
+            for (BlockId id : loop->blocks)
+            {
+                // A nested loop might not terminate, so it cannot simply disappear.
+                pure = pure && loops.loop_of(id) == static_cast<int>(index);
+                for (const auto& instr : func.block_instructions(id))
+                {
+                    if (instr.is_terminator())
+                        pure = pure && instr.opcode != IROpcode::RETURN;
+                    else
+                        pure = pure && instr.result.is_temp() && is_speculatable(instr);
+                }
+                for (BlockId succ : cfg.successors(id))
+                    pure = pure && (id == header || loop->contains(succ));
+            }
+            if (!pure)
+                continue;
+
+            ScalarEvolution scev(func, *loop);
+            auto trips = scev.trip_count();
+            if (!trips)
+                continue;
+
+            // Values of the header that are used after the loop need a closed form.
+            std::vector<bool> defined_in_header(func.temp_count, false);
+            for (const auto& phi : func.blocks[header].phis)
+                defined_in_header[phi.result.value] = true;
+            for (const auto& instr : func.block_instructions(header))
+            {
+                if (!instr.is_terminator() && instr.result.is_temp())
+                    defined_in_header[instr.result.value] = true;
+            }
+            std::vector<IROperand> escaping;
+            auto note_use = [&](const IROperand& op) {
+                if (op.is_temp() && static_cast<size_t>(op.value) < defined_in_header.size() && defined_in_header[op.value]
+                    && std::find(escaping.begin(), escaping.end(), op) == escaping.end())
+                    escaping.push_back(op);
+            };
+            for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+            {
+                if (loop->contains(id))
+                    continue;
+                for (const auto& phi : func.blocks[id].phis)
+                {
+                    for (const auto& in : phi.incoming)
+                        note_use(in.value);
+                }
+                for (const auto& instr : func.block_instructions(id))
+                {
+                    if (instr.opcode == IROpcode::JUMP)
+                        continue;
+                    note_use(instr.operand1);
+                    note_use(instr.operand2);
+                }
+            }
+            std::vector<IROperand> finals;
+            for (const IROperand& value : escaping)
+            {
+                auto rec = scev.recurrence(value);
+                if (!rec)
+                    break;
+                finals.push_back(scev.evaluate(*rec, *trips));
+            }
+            if (finals.size() != escaping.size())
+                continue;
+
+            BlockId closed = func.add_block(func.new_label("closed_form"));
+            for (const auto& instr : scev.code())
+                func.append(closed, instr);
+            func.append(closed, IRInstruction(IROpcode::JUMP, {}, IROperand::block(exit)));
+            IRInstruction& branch = func.terminator(header);
+            branch.retarget(loop->contains(branch.operand2.value) ? branch.operand2.value : branch.result.value, closed);
+            for (auto& phi : func.blocks[header].phis)
+                std::erase_if(phi.incoming, [&](const PhiIncoming& in) { return loop->contains(in.block); });
+
+            // The exit now merges the header's values (loop not entered) with the closed forms.
+            std::vector<IROperand> merged(escaping.size());
+            auto final_of = [&](const IROperand& op) {
+                auto it = std::find(escaping.begin(), escaping.end(), op);
+                return it == escaping.end() ? op : finals[it - escaping.begin()];
+            };
+            auto& exit_phis = func.blocks[exit].phis;
+            for (auto& phi : exit_phis)
+                phi.incoming.push_back({ closed, final_of(phi.value_from(header)) });
+            for (size_t i = 0; i < escaping.size(); ++i)
+            {
+                merged[i] = func.new_temp();
+                exit_phis.push_back({ merged[i], { { header, escaping[i] }, { closed, finals[i] } } });
+            }
+            auto rename = [&](IROperand& op) {
+                auto it = std::find(escaping.begin(), escaping.end(), op);
+                if (it != escaping.end())
+                    op = merged[it - escaping.begin()];
+            };
+            for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+            {
+                if (id == closed || loop->contains(id))
+                    continue;
+                for (auto& phi : func.blocks[id].phis)
+                {
+                    // The exit's phis already take the right value from each side.
+                    for (auto& in : phi.incoming)
+                    {
+                        if (id != exit)
+                            rename(in.value);
+                    }
+                }
+                std::vector<IRInstruction> instrs(func.block_instructions(id).begin(), func.block_instructions(id).end());
+                for (auto& instr : instrs)
+                {
+                    if (instr.opcode == IROpcode::JUMP)
+                        continue;
+                    rename(instr.operand1);
+                    rename(instr.operand2);
+                }
+                func.set_block_instructions(id, instrs);
+            }
+
+            std::vector<bool> dead(func.blocks.size(), false);
+            for (BlockId id : loop->blocks)
+                dead[id] = id != header;
+            // Unreachable blocks may still jump into the body.
+            for (BlockId id = 0; id < static_cast<BlockId>(cfg.size()); ++id)
+                dead[id] = dead[id] || !cfg.reachable(id);
+            func.remove_blocks(dead);
+            folded = changed = true;
+        }
+    }
+    return changed;
+}
+
+} // namespace minic
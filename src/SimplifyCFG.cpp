@@ -0,0 +1,132 @@
+#include "minic/SimplifyCFG.hpp"
+#include "minic/CFG.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+bool remove_unreachable(IRFunction& func, const ControlFlowGraph& cfg)
+{
+    std::vector<bool> dead(func.blocks.size(), false);
+    bool any = false;
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (!cfg.reachable(id))
+            dead[id] = any = true;
+    }
+    if (any)
+        func.remove_blocks(dead);
+    return any;
+}
+
+bool fold_same_target_branches(IRFunction& func)
+{
+    bool changed = false;
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        IRInstruction& term = func.terminator(id);
+        if ((term.opcode == IROpcode::JUMPIF || term.opcode == IROpcode::JUMPIFNOT) && term.operand2 == term.result)
+        {
+            term = IRInstruction(IROpcode::JUMP, {}, term.result);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Send the predecessors of one jump-only block straight to its target.
+bool skip_jump_only_block(IRFunction& func, const ControlFlowGraph& cfg)
+{
+    for (BlockId id = 1; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (func.blocks[id].size != 1 || !func.blocks[id].phis.empty() || func.terminator(id).opcode != IROpcode::JUMP)
+            continue;
+        const BlockId target = func.terminator(id).operand1.value;
+        if (target == id)
+            continue;
+
+        bool changed = false;
+        for (BlockId pred : cfg.predecessors(id))
+        {
+            if (pred == id)
+                continue;
+            // A phi cannot tell two edges from the same block apart.
+            const auto& target_preds = cfg.predecessors(target);
+            if (!func.blocks[target].phis.empty() && std::ranges::find(target_preds, pred) != target_preds.end())
+                continue;
+            func.terminator(pred).retarget(id, target);
+            for (auto& phi : func.blocks[target].phis)
+                phi.incoming.push_back({ pred, phi.value_from(id) });
+            changed = true;
+        }
+        // Once nothing jumps to it, the block is deleted along with its phi entries.
+        if (changed)
+            return true;
+    }
+    return false;
+}
+
+// Append one block to its only predecessor when that predecessor only jumps to it.
+bool merge_into_predecessor(IRFunction& func, const ControlFlowGraph& cfg)
+{
+    for (BlockId id = 1; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        const auto& preds = cfg.predecessors(id);
+        if (preds.size() != 1 || preds[0] == id)
+            continue;
+        const BlockId pred = preds[0];
+        if (func.terminator(pred).opcode != IROpcode::JUMP)
+            continue;
+
+        auto head = func.block_instructions(pred);
+        std::vector<IRInstruction> merged(head.begin(), head.end() - 1);
+        for (const auto& phi : func.blocks[id].phis)
+            merged.emplace_back(IROpcode::ASSIGN, phi.result, phi.value_from(pred));
+        auto tail = func.block_instructions(id);
+        merged.insert(merged.end(), tail.begin(), tail.end());
+        func.set_block_instructions(pred, merged);
+        func.blocks[id].phis.clear();
+
+        // The successors now see control arrive from the predecessor.
+        for (BlockId succ : cfg.successors(id))
+        {
+            for (auto& phi : func.blocks[succ].phis)
+            {
+                for (auto& in : phi.incoming)
+                {
+                    if (in.block == id)
+                        in.block = pred;
+                }
+            }
+        }
+        std::vector<bool> dead(func.blocks.size(), false);
+        dead[id] = true;
+        func.remove_blocks(dead);
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool SimplifyCFG::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    bool changed = false;
+    for (bool again = true; again;)
+    {
+        ControlFlowGraph cfg(func);
+        again = remove_unreachable(func, cfg) || fold_same_target_branches(func) || skip_jump_only_block(func, cfg)
+            || merge_into_predecessor(func, cfg);
+        changed = changed || again;
+    }
+    return changed;
+}
+
+} // namespace minic
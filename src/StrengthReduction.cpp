@@ -0,0 +1,259 @@
+#include "minic/StrengthReduction.hpp"
+#include <bit>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace minic
+{
+
+DivisionMagic division_magic(std::int64_t d)
+{
+    const std::uint64_t two63 = 1ULL << 63;
+    const std::uint64_t ad = d < 0 ? 0 - static_cast<std::uint64_t>(d) : static_cast<std::uint64_t>(d);
+    const std::uint64_t t = two63 + (static_cast<std::uint64_t>(d) >> 63);
+    const std::uint64_t anc = t - 1 - t % ad; // Absolute value of nc
+    int p = 63;
+    std::uint64_t q1 = two63 / anc;
+    std::uint64_t r1 = two63 - q1 * anc;
+    std::uint64_t q2 = two63 / ad;
+    std::uint64_t r2 = two63 - q2 * ad;
+    std::uint64_t delta;
+    do
+    {
+        ++p;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc)
+        {
+            ++q1;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad)
+        {
+            ++q2;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    auto multiplier = static_cast<std::int64_t>(q2 + 1);
+    if (d < 0)
+        multiplier = static_cast<std::int64_t>(0 - static_cast<std::uint64_t>(multiplier));
+    return { multiplier, p - 64 };
+}
+
+namespace
+{
+
+/**
+ * @brief Rewrites one function, collecting the wide constants it needs in the entry block.
+ */
+class Reducer
+{
+public:
+    explicit Reducer(IRFunction& func)
+        : func_(func)
+    {
+    }
+
+    bool run()
+    {
+        bool changed = false;
+        for (BlockId id = 0; id < static_cast<BlockId>(func_.blocks.size()); ++id)
+        {
+            std::vector<IRInstruction> code;
+            bool rewritten = false;
+            for (const auto& instr : func_.block_instructions(id))
+                rewritten = reduce(instr, code) || rewritten;
+            if (rewritten)
+            {
+                func_.set_block_instructions(id, code);
+                changed = true;
+            }
+        }
+        if (!entry_code_.empty())
+        {
+            auto instrs = func_.block_instructions(0);
+            entry_code_.insert(entry_code_.end(), instrs.begin(), instrs.end());
+            func_.set_block_instructions(0, entry_code_);
+        }
+        return changed;
+    }
+
+private:
+    IRFunction& func_;
+    std::map<std::int64_t, IROperand> constants_; ///< Wide multipliers already built
+    std::vector<IRInstruction> entry_code_; ///< Code building them
+
+    /**
+     * @brief Append instr, or the cheaper sequence computing the same result, to code.
+     */
+    bool reduce(const IRInstruction& instr, std::vector<IRInstruction>& code)
+    {
+        if (instr.opcode == IROpcode::MUL && instr.operand1.is_imm() != instr.operand2.is_imm())
+        {
+            bool swapped = instr.operand1.is_imm();
+            if (reduce_mul(instr.result, swapped ? instr.operand2 : instr.operand1, swapped ? instr.operand1.value : instr.operand2.value, code))
+                return true;
+        }
+        if (instr.opcode == IROpcode::DIV && !instr.operand1.is_imm() && instr.operand2.is_imm())
+        {
+            std::int64_t d = instr.operand2.value;
+            if (d != -1 && d != 0 && d != 1)
+            {
+                reduce_div(instr.result, instr.operand1, d, code);
+                return true;
+            }
+        }
+        code.push_back(instr);
+        return false;
+    }
+
+    bool reduce_mul(const IROperand& result, const IROperand& x, std::int64_t c, std::vector<IRInstruction>& code)
+    {
+        if (c == -1)
+        {
+            code.push_back(IRInstruction(IROpcode::NEG, result, x));
+            return true;
+        }
+        if (c == 0)
+            return false; // Left to constant folding; 0 has no lowest set bit
+        if (c == 3 || c == 5 || c == 9)
+            return false; // Already a single lea
+        const std::uint64_t m = static_cast<std::uint64_t>(c < 0 ? -c : c);
+        const int k = std::countr_zero(m);
+        const std::uint64_t odd = m >> k;
+        if (odd == 1)
+        {
+            if (c > 0)
+                code.push_back(IRInstruction(IROpcode::SHL, result, x, IROperand::imm(k)));
+            else
+            {
+                IROperand shifted = func_.new_temp();
+                code.push_back(IRInstruction(IROpcode::SHL, shifted, x, IROperand::imm(k)));
+                code.push_back(IRInstruction(IROpcode::NEG, result, shifted));
+            }
+            return true;
+        }
+        if (k == 0 && std::has_single_bit(m - 1) && c > 0)
+        {
+            // x * (2^j + 1) = (x << j) + x
+            IROperand shifted = func_.new_temp();
+            code.push_back(IRInstruction(IROpcode::SHL, shifted, x, IROperand::imm(std::countr_zero(m - 1))));
+            code.push_back(IRInstruction(IROpcode::ADD, result, shifted, x));
+            return true;
+        }
+        if (k == 0 && std::has_single_bit(m + 1))
+        {
+            // x * (2^j - 1) = (x << j) - x, and x * -(2^j - 1) = x - (x << j)
+            IROperand shifted = func_.new_temp();
+            code.push_back(IRInstruction(IROpcode::SHL, shifted, x, IROperand::imm(std::countr_zero(m + 1))));
+            code.push_back(c > 0 ? IRInstruction(IROpcode::SUB, result, shifted, x) : IRInstruction(IROpcode::SUB, result, x, shifted));
+            return true;
+        }
+        if (k > 0 && c > 0 && (odd == 3 || odd == 5 || odd == 9))
+        {
+            IROperand scaled = func_.new_temp();
+            code.push_back(IRInstruction(IROpcode::MUL, scaled, x, IROperand::imm(static_cast<std::int32_t>(odd))));
+            code.push_back(IRInstruction(IROpcode::SHL, result, scaled, IROperand::imm(k)));
+            return true;
+        }
+        return false;
+    }
+
+    void reduce_div(const IROperand& result, const IROperand& x, std::int64_t d, std::vector<IRInstruction>& code)
+    {
+        const std::uint64_t ad = static_cast<std::uint64_t>(d < 0 ? -d : d);
+        if (std::has_single_bit(ad))
+        {
+            // Bias a negative x by 2^k - 1 so the arithmetic shift rounds toward zero.
+            const int k = std::countr_zero(ad);
+            IROperand quotient = d < 0 ? func_.new_temp() : result;
+            IROperand bias = func_.new_temp();
+            if (k == 1)
+            {
+                code.push_back(IRInstruction(IROpcode::SHR, bias, x, IROperand::imm(63)));
+            }
+            else
+            {
+                IROperand sign = func_.new_temp();
+                code.push_back(IRInstruction(IROpcode::SAR, sign, x, IROperand::imm(63)));
+                code.push_back(IRInstruction(IROpcode::SHR, bias, sign, IROperand::imm(64 - k)));
+            }
+            IROperand biased = func_.new_temp();
+            code.push_back(IRInstruction(IROpcode::ADD, biased, x, bias));
+            code.push_back(IRInstruction(IROpcode::SAR, quotient, biased, IROperand::imm(k)));
+            if (d < 0)
+                code.push_back(IRInstruction(IROpcode::NEG, result, quotient));
+            return;
+        }
+
+        const DivisionMagic magic = division_magic(d);
+        IROperand estimate = func_.new_temp();
+        code.push_back(IRInstruction(IROpcode::MULH, estimate, x, constant(magic.multiplier)));
+        if (d > 0 && magic.multiplier < 0)
+        {
+            IROperand corrected = func_.new_temp();
+            code.push_back(IRInstruction(IROpcode::ADD, corrected, estimate, x));
+            estimate = corrected;
+        }
+        else if (d < 0 && magic.multiplier > 0)
+        {
+            IROperand corrected = func_.new_temp();
+            code.push_back(IRInstruction(IROpcode::SUB, corrected, estimate, x));
+            estimate = corrected;
+        }
+        if (magic.shift > 0)
+        {
+            IROperand shifted = func_.new_temp();
+            code.push_back(IRInstruction(IROpcode::SAR, shifted, estimate, IROperand::imm(magic.shift)));
+            estimate = shifted;
+        }
+        // A negative estimate is one below the quotient truncated toward zero.
+        IROperand sign = func_.new_temp();
+        code.push_back(IRInstruction(IROpcode::SHR, sign, estimate, IROperand::imm(63)));
+        code.push_back(IRInstruction(IROpcode::ADD, result, estimate, sign));
+    }
+
+    /**
+     * @brief An operand holding value: an immediate when it fits, else a temp set up in the entry block.
+     */
+    IROperand constant(std::int64_t value)
+    {
+        if (value >= std::numeric_limits<std::int32_t>::min() && value <= std::numeric_limits<std::int32_t>::max())
+            return IROperand::imm(static_cast<std::int32_t>(value));
+        auto found = constants_.find(value);
+        if (found != constants_.end())
+            return found->second;
+
+        // (high << 32) + low, with low sign-extended and high taking up the difference.
+        const auto low = static_cast<std::int32_t>(static_cast<std::uint32_t>(value));
+        const auto high = static_cast<std::int32_t>(static_cast<std::uint32_t>((static_cast<std::uint64_t>(value) - static_cast<std::uint64_t>(std::int64_t { low })) >> 32));
+        IROperand upper = func_.new_temp();
+        IROperand shifted = func_.new_temp();
+        entry_code_.push_back(IRInstruction(IROpcode::ASSIGN, upper, IROperand::imm(high)));
+        entry_code_.push_back(IRInstruction(IROpcode::SHL, shifted, upper, IROperand::imm(32)));
+        IROperand built = shifted;
+        if (low != 0)
+        {
+            built = func_.new_temp();
+            entry_code_.push_back(IRInstruction(IROpcode::ADD, built, shifted, IROperand::imm(low)));
+        }
+        constants_[value] = built;
+        return built;
+    }
+};
+
+} // namespace
+
+bool StrengthReduction::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+    return Reducer(func).run();
+}
+
+} // namespace minic
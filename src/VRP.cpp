@@ -0,0 +1,565 @@
+#include "minic/VRP.hpp"
+#include "minic/CFG.hpp"
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace minic
+{
+
+namespace
+{
+
+constexpr std::int64_t kMin = std::numeric_limits<std::int64_t>::min();
+constexpr std::int64_t kMax = std::numeric_limits<std::int64_t>::max();
+
+/**
+ * @brief A closed interval of 64-bit values; lo > hi is the empty interval
+ * of a value not computed yet.
+ */
+struct Range
+{
+    std::int64_t lo = kMax;
+    std::int64_t hi = kMin;
+
+    static Range full() { return { kMin, kMax }; }
+    static Range constant(std::int64_t v) { return { v, v }; }
+    bool empty() const { return lo > hi; }
+    bool singleton() const { return lo == hi; }
+    bool contains(std::int64_t v) const { return lo <= v && v <= hi; }
+    bool operator==(const Range&) const = default;
+};
+
+/**
+ * @brief Smallest interval holding both.
+ */
+Range hull(Range a, Range b)
+{
+    if (a.empty())
+        return b;
+    if (b.empty())
+        return a;
+    return { std::min(a.lo, b.lo), std::max(a.hi, b.hi) };
+}
+
+/**
+ * @brief Narrow r to the values v for which `v op other` can hold.
+ */
+Range refine(Range r, IROpcode op, Range other)
+{
+    if (r.empty() || other.empty())
+        return r;
+    switch (op)
+    {
+    case IROpcode::LT:
+        if (other.hi == kMin)
+            return {};
+        r.hi = std::min(r.hi, other.hi - 1);
+        break;
+    case IROpcode::LE:
+        r.hi = std::min(r.hi, other.hi);
+        break;
+    case IROpcode::GT:
+        if (other.lo == kMax)
+            return {};
+        r.lo = std::max(r.lo, other.lo + 1);
+        break;
+    case IROpcode::GE:
+        r.lo = std::max(r.lo, other.lo);
+        break;
+    case IROpcode::EQ:
+        r.lo = std::max(r.lo, other.lo);
+        r.hi = std::min(r.hi, other.hi);
+        break;
+    case IROpcode::NEQ:
+        if (other.singleton() && r.lo == other.lo)
+            r.lo = r.lo == kMax ? r.lo : r.lo + 1;
+        else if (other.singleton() && r.hi == other.lo)
+            r.hi = r.hi == kMin ? r.hi : r.hi - 1;
+        if (other.singleton() && r == other)
+            return {};
+        break;
+    default:
+        break;
+    }
+    return r.empty() ? Range {} : r;
+}
+
+/**
+ * @brief The outcome of `a op b` for every a and b in the intervals, if there is one.
+ */
+std::optional<bool> decide(IROpcode op, Range a, Range b)
+{
+    switch (op)
+    {
+    case IROpcode::LT:
+        if (a.hi < b.lo)
+            return true;
+        if (a.lo >= b.hi)
+            return false;
+        break;
+    case IROpcode::LE:
+        if (a.hi <= b.lo)
+            return true;
+        if (a.lo > b.hi)
+            return false;
+        break;
+    case IROpcode::GT:
+    case IROpcode::GE:
+        return decide(swap_comparison(op), b, a);
+    case IROpcode::EQ:
+        if (a.singleton() && b.singleton() && a.lo == b.lo)
+            return true;
+        if (a.hi < b.lo || b.hi < a.lo)
+            return false;
+        break;
+    case IROpcode::NEQ:
+        if (auto equal = decide(IROpcode::EQ, a, b))
+            return !*equal;
+        break;
+    default:
+        break;
+    }
+    return std::nullopt;
+}
+
+Range boolean(std::optional<bool> known)
+{
+    return known ? Range::constant(*known ? 1 : 0) : Range { 0, 1 };
+}
+
+/**
+ * @brief Interval of `a op b`; the full range whenever the result could wrap.
+ */
+Range transfer(IROpcode op, Range a, Range b)
+{
+    bool unary = op == IROpcode::NEG || op == IROpcode::NOT || op == IROpcode::ASSIGN;
+    if (a.empty() || (!unary && b.empty()))
+        return {};
+    std::int64_t x;
+    std::int64_t y;
+    switch (op)
+    {
+    case IROpcode::ASSIGN:
+        return a;
+    case IROpcode::ADD:
+        if (__builtin_add_overflow(a.lo, b.lo, &x) || __builtin_add_overflow(a.hi, b.hi, &y))
+            return Range::full();
+        return { x, y };
+    case IROpcode::SUB:
+        if (__builtin_sub_overflow(a.lo, b.hi, &x) || __builtin_sub_overflow(a.hi, b.lo, &y))
+            return Range::full();
+        return { x, y };
+    case IROpcode::NEG:
+        if (a.lo == kMin)
+            return Range::full();
+        return { -a.hi, -a.lo };
+    case IROpcode::MUL:
+    {
+        Range r;
+        for (std::int64_t u : { a.lo, a.hi })
+        {
+            for (std::int64_t v : { b.lo, b.hi })
+            {
+                if (__builtin_mul_overflow(u, v, &x))
+                    return Range::full();
+                r = hull(r, Range::constant(x));
+            }
+        }
+        return r;
+    }
+    case IROpcode::DIV:
+        // Truncating division by a positive constant is monotonic.
+        if (b.singleton() && b.lo > 0)
+            return { a.lo / b.lo, a.hi / b.lo };
+        return Range::full();
+    case IROpcode::NOT:
+        return boolean(decide(IROpcode::EQ, a, Range::constant(0)));
+    default:
+        if (is_comparison(op))
+            return boolean(decide(op, a, b));
+        return Range::full();
+    }
+}
+
+/**
+ * @brief `subject op other` is known to hold.
+ */
+struct Fact
+{
+    IROperand subject;
+    IROpcode op;
+    IROperand other;
+};
+
+/**
+ * @brief Interval propagation over the executable part of the CFG.
+ */
+class Solver
+{
+public:
+    /// Updates a value may take before its interval is widened.
+    static constexpr int kWidenAfter = 3;
+    /// Sweeps that recompute values after the fixpoint.
+    static constexpr int kNarrowRounds = 2;
+
+    explicit Solver(const IRFunction& func)
+        : func_(func)
+        , cfg_(func)
+        , ranges_(func.temp_count + func.variables.size())
+        , updates_(ranges_.size(), 0)
+        , tracked_(ranges_.size(), true)
+        , def_(func.temp_count, nullptr)
+        , executable_(func.blocks.size(), false)
+        , executable_preds_(func.blocks.size())
+        , facts_(func.blocks.size())
+    {
+        std::vector<int> defs(func.temp_count, 0);
+        for (const auto& block : func.blocks)
+        {
+            for (const auto& phi : block.phis)
+                ++defs.at(phi.result.value);
+            for (const auto& instr : func.block_instructions(block))
+            {
+                if (instr.is_terminator())
+                    continue;
+                if (instr.result.is_temp())
+                {
+                    ++defs.at(instr.result.value);
+                    def_[instr.result.value] = &instr;
+                }
+                else if (instr.result.is_var())
+                    tracked_[func.temp_count + instr.result.value] = false;
+            }
+        }
+        for (size_t t = 0; t < defs.size(); ++t)
+        {
+            if (defs[t] != 1)
+            {
+                tracked_[t] = false;
+                def_[t] = nullptr;
+            }
+        }
+        // Variables still read in SSA form are parameters: anything is possible.
+        for (size_t i = 0; i < ranges_.size(); ++i)
+        {
+            if (!tracked_[i] || i >= static_cast<size_t>(func.temp_count))
+                ranges_[i] = Range::full();
+        }
+
+        // Facts from the edge into a single-predecessor block hold in its whole dominator subtree.
+        for (BlockId id : cfg_.reverse_postorder())
+        {
+            if (id == 0)
+                continue;
+            facts_[id] = facts_[cfg_.idom(id)];
+            if (cfg_.predecessors(id).size() == 1)
+                edge_facts(cfg_.predecessors(id)[0], id, facts_[id]);
+        }
+    }
+
+    void solve()
+    {
+        executable_[0] = true;
+        for (bool changed = true; changed;)
+        {
+            changed_ = false;
+            for (BlockId id : cfg_.reverse_postorder())
+            {
+                if (executable_[id])
+                    visit_block(id);
+            }
+            // Facts that contradict each other can leave a branch with no
+            // executable side; keep both rather than delete a live block.
+            for (BlockId id : cfg_.reverse_postorder())
+            {
+                const IRInstruction& term = func_.terminator(id);
+                if (executable_[id] && (term.opcode == IROpcode::JUMPIF || term.opcode == IROpcode::JUMPIFNOT) && !changed_
+                    && !edge_executable(id, term.operand2.value) && !edge_executable(id, term.result.value))
+                {
+                    mark_edge(id, term.operand2.value);
+                    mark_edge(id, term.result.value);
+                }
+            }
+            changed = changed_;
+        }
+
+        // Widening overshoots loop bounds; recomputing every value from the
+        // fixpoint and keeping the tighter interval takes some of that back.
+        narrowing_ = true;
+        for (int round = 0; round < kNarrowRounds; ++round)
+        {
+            for (BlockId id : cfg_.reverse_postorder())
+            {
+                if (executable_[id])
+                    visit_block(id);
+            }
+        }
+    }
+
+    bool executable(BlockId block) const { return executable_[block]; }
+
+    /**
+     * @brief Whether the block's conditional branch always sees a non-zero
+     * (true) or zero (false) condition, if that is known.
+     */
+    std::optional<bool> condition(BlockId block) const
+    {
+        Range cond = range_at(block, func_.terminator(block).operand1);
+        if (cond.empty())
+            return std::nullopt;
+        if (!cond.contains(0))
+            return true;
+        if (cond == Range::constant(0))
+            return false;
+        return std::nullopt;
+    }
+
+    bool edge_executable(BlockId from, BlockId to) const
+    {
+        return std::ranges::find(executable_preds_[to], from) != executable_preds_[to].end();
+    }
+
+    Range range_of(const IROperand& op) const
+    {
+        if (op.is_imm())
+            return Range::constant(op.value);
+        int index = index_of(op);
+        return index < 0 ? Range::full() : ranges_[index];
+    }
+
+private:
+    int index_of(const IROperand& op) const
+    {
+        if (op.is_temp())
+            return op.value;
+        if (op.is_var())
+            return func_.temp_count + op.value;
+        return -1;
+    }
+
+    bool tracked(const IROperand& op) const
+    {
+        int index = index_of(op);
+        return index >= 0 && tracked_[index];
+    }
+
+    /**
+     * @brief Append what the edge from -> to tells about the values its branch tested.
+     */
+    void edge_facts(BlockId from, BlockId to, std::vector<Fact>& out) const
+    {
+        const IRInstruction& term = func_.terminator(from);
+        if ((term.opcode != IROpcode::JUMPIF && term.opcode != IROpcode::JUMPIFNOT) || term.operand2 == term.result)
+            return;
+        const bool nonzero = (term.opcode == IROpcode::JUMPIF) == (term.operand2.value == to);
+        const IROperand cond = term.operand1;
+        if (!tracked(cond))
+            return;
+        out.push_back({ cond, nonzero ? IROpcode::NEQ : IROpcode::EQ, IROperand::imm(0) });
+        const IRInstruction* def = cond.is_temp() ? def_[cond.value] : nullptr;
+        if (!def)
+            return;
+        if (is_comparison(def->opcode))
+        {
+            IROpcode op = nonzero ? def->opcode : invert_comparison(def->opcode);
+            if (tracked(def->operand1))
+                out.push_back({ def->operand1, op, def->operand2 });
+            if (tracked(def->operand2))
+                out.push_back({ def->operand2, swap_comparison(op), def->operand1 });
+        }
+        else if (def->opcode == IROpcode::NOT && tracked(def->operand1))
+        {
+            out.push_back({ def->operand1, nonzero ? IROpcode::EQ : IROpcode::NEQ, IROperand::imm(0) });
+        }
+    }
+
+    Range narrow(Range r, const IROperand& op, const std::vector<Fact>& facts) const
+    {
+        for (const Fact& fact : facts)
+        {
+            if (fact.subject == op)
+                r = refine(r, fact.op, range_of(fact.other));
+        }
+        return r;
+    }
+
+    /**
+     * @brief Interval of an operand where it is read in a block.
+     */
+    Range range_at(BlockId block, const IROperand& op) const
+    {
+        if (!tracked(op))
+            return range_of(op);
+        return narrow(range_of(op), op, facts_[block]);
+    }
+
+    /**
+     * @brief Interval of an operand as it flows along the edge from -> to.
+     */
+    Range range_on_edge(BlockId from, BlockId to, const IROperand& op) const
+    {
+        std::vector<Fact> facts;
+        edge_facts(from, to, facts);
+        return narrow(range_at(from, op), op, facts);
+    }
+
+    void update(const IROperand& op, Range value)
+    {
+        int index = index_of(op);
+        if (index < 0 || !tracked_[index])
+            return;
+        Range old = ranges_[index];
+        if (narrowing_)
+        {
+            if (!value.empty())
+                ranges_[index] = { std::max(old.lo, value.lo), std::min(old.hi, value.hi) };
+            return;
+        }
+        Range joined = hull(old, value);
+        if (joined == old)
+            return;
+        if (++updates_[index] > kWidenAfter && !old.empty())
+        {
+            if (joined.lo < old.lo)
+                joined.lo = kMin;
+            if (joined.hi > old.hi)
+                joined.hi = kMax;
+        }
+        ranges_[index] = joined;
+        changed_ = true;
+    }
+
+    void mark_edge(BlockId from, BlockId to)
+    {
+        if (narrowing_ || edge_executable(from, to))
+            return;
+        executable_preds_[to].push_back(from);
+        executable_[to] = true;
+        changed_ = true;
+    }
+
+    void visit_block(BlockId id)
+    {
+        for (const auto& phi : func_.blocks[id].phis)
+        {
+            Range value;
+            for (const auto& in : phi.incoming)
+            {
+                if (edge_executable(in.block, id))
+                    value = hull(value, range_on_edge(in.block, id, in.value));
+            }
+            update(phi.result, value);
+        }
+        for (const auto& instr : func_.block_instructions(id))
+        {
+            switch (instr.opcode)
+            {
+            case IROpcode::JUMP:
+                mark_edge(id, instr.operand1.value);
+                break;
+            case IROpcode::JUMPIF:
+            case IROpcode::JUMPIFNOT:
+            {
+                Range cond = range_at(id, instr.operand1);
+                if (cond.empty())
+                    break;
+                bool may_be_zero = cond.contains(0);
+                bool may_be_nonzero = !(cond == Range::constant(0));
+                bool jumpif = instr.opcode == IROpcode::JUMPIF;
+                if (jumpif ? may_be_nonzero : may_be_zero)
+                    mark_edge(id, instr.operand2.value);
+                if (jumpif ? may_be_zero : may_be_nonzero)
+                    mark_edge(id, instr.result.value);
+                break;
+            }
+            case IROpcode::RETURN:
+                break;
+            default:
+                if (instr.result.is_temp())
+                    update(instr.result, instr.operand1.is_str() ? Range::full() : transfer(instr.opcode, range_at(id, instr.operand1), range_at(id, instr.operand2)));
+                break;
+            }
+        }
+    }
+
+    const IRFunction& func_;
+    ControlFlowGraph cfg_;
+    std::vector<Range> ranges_; ///< Interval per temp, then per variable
+    std::vector<int> updates_; ///< Times each interval grew
+    std::vector<bool> tracked_; ///< Whether the value has a single definition
+    std::vector<const IRInstruction*> def_; ///< Defining instruction of each single-definition temp
+    std::vector<bool> executable_; ///< Whether any executable edge reaches the block
+    std::vector<std::vector<BlockId>> executable_preds_; ///< Sources of the executable edges into each block
+    std::vector<std::vector<Fact>> facts_; ///< What dominating edges tell at the top of each block
+    bool changed_ = false; ///< Whether the current round changed anything
+    bool narrowing_ = false; ///< Whether values may only shrink now
+};
+
+} // namespace
+
+bool ValueRangePropagation::run(IRFunction& func)
+{
+    if (func.blocks.empty())
+        return false;
+
+    Solver solver(func);
+    solver.solve();
+
+    bool changed = false;
+    std::vector<bool> dead(func.blocks.size(), false);
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (!solver.executable(id))
+        {
+            dead[id] = true;
+            continue;
+        }
+        for (auto& instr : func.block_instructions(id))
+        {
+            if (instr.is_terminator() || !instr.result.is_temp() || (!is_comparison(instr.opcode) && instr.opcode != IROpcode::NOT))
+                continue;
+            Range value = solver.range_of(instr.result);
+            if (value.singleton())
+            {
+                instr = IRInstruction(IROpcode::ASSIGN, instr.result, IROperand::imm(static_cast<std::int32_t>(value.lo)));
+                changed = true;
+            }
+        }
+
+        IRInstruction& term = func.terminator(id);
+        if (term.opcode != IROpcode::JUMPIF && term.opcode != IROpcode::JUMPIFNOT)
+            continue;
+        BlockId a = term.operand2.value;
+        BlockId b = term.result.value;
+        bool a_taken = solver.edge_executable(id, a);
+        bool b_taken = solver.edge_executable(id, b);
+        if (auto cond = solver.condition(id))
+        {
+            a_taken = (term.opcode == IROpcode::JUMPIF) == *cond;
+            b_taken = !a_taken;
+        }
+        if (a != b && a_taken != b_taken)
+        {
+            BlockId dropped = a_taken ? b : a;
+            for (auto& phi : func.blocks[dropped].phis)
+                std::erase_if(phi.incoming, [&](const PhiIncoming& in) { return in.block == id; });
+            term = IRInstruction(IROpcode::JUMP, {}, IROperand::block(a_taken ? a : b));
+            changed = true;
+        }
+    }
+
+    // Branches decided after narrowing can cut off blocks that were executable.
+    ControlFlowGraph cfg(func);
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        dead[id] = dead[id] || !cfg.reachable(id);
+    if (std::ranges::find(dead, true) != dead.end())
+    {
+        func.remove_blocks(dead);
+        changed = true;
+    }
+    return changed;
+}
+
+} // namespace minic
@@ -1,34 +1,57 @@
+#include "minic/BlockLayout.hpp"
 #include "minic/CodeGenerator.hpp"
+#include "minic/CodeSinking.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/DCE.hpp"
+#include "minic/GVN.hpp"
 #include "minic/IRGenerator.hpp"
+#include "minic/IfConversion.hpp"
+#include "minic/InstCombine.hpp"
+#include "minic/JumpThreading.hpp"
+#include "minic/LICM.hpp"
+#include "minic/LSR.hpp"
 #include "minic/Lexer.hpp"
+#include "minic/LoopFusion.hpp"
+#include "minic/LoopRotation.hpp"
+#include "minic/LoopUnroll.hpp"
+#include "minic/LoopUnswitch.hpp"
+#include "minic/PRE.hpp"
 #include "minic/Parser.hpp"
+#include "minic/SCCP.hpp"
+#include "minic/SSA.hpp"
+#include "minic/ScalarEvolution.hpp"
 #include "minic/SemanticAnalyzer.hpp"
+#include "minic/SimplifyCFG.hpp"
+#include "minic/StrengthReduction.hpp"
+#include "minic/VRP.hpp"
 #include <fstream>
 #include <iostream>
 #include <memory>
 
-int compile_file(const std::string& filename, const std::string& source);
+int compile_file(const std::string& filename, const std::string& source, bool verbose);
 
 int main(int argc, char** argv)
 {
-    if (argc < 2)
+    bool verbose = argc == 3 && std::string(argv[1]) == "--verbose";
+    if (argc != 2 && !verbose)
     {
-        std::cerr << "Usage: cminusminus <input.cmm>\n";
+        std::cerr << "Usage: cminusminus [--verbose] <input.cmm>\n";
         return 1;
     }
 
-    std::ifstream input_file(argv[1]);
+    const char* path = argv[argc - 1];
+    std::ifstream input_file(path);
     if (!input_file)
     {
-        std::cerr << "Error: Could not open input file '" << argv[1] << "'.\n";
+        std::cerr << "Error: Could not open input file '" << path << "'.\n";
         return 1;
     }
 
     std::string source((std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>());
-    return compile_file(argv[1], source);
+    return compile_file(path, source, verbose);
 }
 
-int compile_file(const std::string& filename, const std::string& source)
+int compile_file(const std::string& filename, const std::string& source, bool verbose)
 {
     std::cout << "Compiling: " << filename << "\n";
 
@@ -79,6 +102,41 @@ int compile_file(const std::string& filename, const std::string& source)
         return 1;
     }
 
+    try
+    {
+        minic::PassManager passes(verbose);
+        passes.add(std::make_unique<minic::SSAConstruction>());
+        passes.add(std::make_unique<minic::SimplifyCFG>());
+        passes.add(std::make_unique<minic::SCCP>());
+        passes.add(std::make_unique<minic::InstCombine>());
+        passes.add(std::make_unique<minic::ValueRangePropagation>());
+        passes.add(std::make_unique<minic::JumpThreading>());
+        passes.add(std::make_unique<minic::GVN>());
+        passes.add(std::make_unique<minic::PartialRedundancyElimination>());
+        passes.add(std::make_unique<minic::LoopFolding>());
+        passes.add(std::make_unique<minic::LICM>());
+        passes.add(std::make_unique<minic::LoopFusion>());
+        passes.add(std::make_unique<minic::LoopUnswitch>());
+        passes.add(std::make_unique<minic::LoopStrengthReduction>());
+        passes.add(std::make_unique<minic::LoopUnroll>());
+        passes.add(std::make_unique<minic::LoopRotation>());
+        passes.add(std::make_unique<minic::SCCP>());
+        passes.add(std::make_unique<minic::StrengthReduction>());
+        passes.add(std::make_unique<minic::CodeSinking>());
+        passes.add(std::make_unique<minic::CopyPropagation>());
+        passes.add(std::make_unique<minic::DeadCodeElimination>());
+        passes.add(std::make_unique<minic::SSADestruction>());
+        passes.add(std::make_unique<minic::IfConversion>());
+        passes.add(std::make_unique<minic::SimplifyCFG>());
+        passes.add(std::make_unique<minic::BlockLayout>());
+        passes.run(*ir_program);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error during optimization: " << e.what() << "\n";
+        return 1;
+    }
+
     try
     {
         minic::CodeGenerator code_gen;
@@ -0,0 +1,119 @@
+#include "TestUtils.hpp"
+#include "minic/BlockLayout.hpp"
+#include "minic/LoopRotation.hpp"
+#include "minic/Loops.hpp"
+#include "minic/SSA.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <iostream>
+
+namespace minic
+{
+
+class BlockLayoutTest : public IRTest
+{
+protected:
+    // Rotated loops out of SSA form: preheaders, guards and split edges sit at the end of the function.
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        LoopRotation().run(func);
+        SSADestruction().run(func);
+        return func;
+    }
+
+    // Lay out and check every input.
+    void Layout(IRFunction& func, const Inputs& inputs)
+    {
+        const std::string entry = func.blocks[0].label;
+        ExpectPreserved(func, inputs, [](IRFunction& f) { EXPECT_TRUE(BlockLayout().run(f)); });
+        EXPECT_EQ(func.blocks[0].label, entry);
+    }
+
+    // Jumps the code generator has to emit: JUMPs to a block other than the
+    // next one, and conditional jumps with neither target next.
+    size_t Jumps(const IRFunction& func)
+    {
+        size_t count = 0;
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            const IRInstruction& term = func.terminator(id);
+            auto targets = term.targets();
+            count += !targets.empty() && std::ranges::none_of(targets, [&](const IROperand& t) { return t.value == id + 1; });
+        }
+        return count;
+    }
+};
+
+TEST_F(BlockLayoutTest, KeepsGeneratorOrderOfSimpleLoop)
+{
+    // The body follows the test and the exit follows the body already.
+    IRFunction& func = IRTest::Generate("int main(int n) {\n"
+                                        "    int s = 0;\n"
+                                        "    while (s < n) { s = s + 3; }\n"
+                                        "    return s;\n"
+                                        "}\n");
+    EXPECT_FALSE(BlockLayout().run(func));
+}
+
+TEST_F(BlockLayoutTest, MovesAppendedBlocksNextToTheirCode)
+{
+    IRFunction& func = Generate("int main(int n, int m) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int j = 0;\n"
+                                "        while (j < m) { s = s + j; j = j + 1; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    size_t before = Jumps(func);
+    Layout(func, { { 0, 0 }, { 3, 0 }, { 0, 3 }, { 4, 5 } });
+    EXPECT_LT(Jumps(func), before);
+}
+
+TEST_F(BlockLayoutTest, LoopsAreContiguous)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        if (i > 3) { s = s + i; } else { s = s - 1; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    if (s > 10) { s = s * 2; }\n"
+                                "    return s;\n"
+                                "}\n");
+    Layout(func, { { 0 }, { 2 }, { 9 } });
+    ControlFlowGraph cfg(func);
+    LoopInfo loops(cfg);
+    ASSERT_EQ(loops.loops().size(), 1);
+    const auto& blocks = loops.loops()[0].blocks;
+    EXPECT_EQ(static_cast<size_t>(blocks.back() - blocks.front() + 1), blocks.size());
+}
+
+TEST_F(BlockLayoutTest, BenchEmittedJumps)
+{
+    IRFunction& func = Generate("int main(int n, int m) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int j = 0;\n"
+                                "        while (j < m) {\n"
+                                "            if (j > i) { s = s + j; } else { s = s - i; }\n"
+                                "            j = j + 1;\n"
+                                "        }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    size_t before = JmpInstructions(func);
+    Layout(func, { { 5, 6 } });
+    size_t after = JmpInstructions(func);
+    std::cout << "[ bench    ] nested loops with a diamond: " << before << " -> " << after << " jmp instructions emitted\n";
+    EXPECT_LT(after, before);
+}
+
+} // namespace minic
@@ -0,0 +1,88 @@
+#include "TestUtils.hpp"
+#include "minic/CFG.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class ControlFlowGraphTest : public IRTest
+{
+};
+
+TEST_F(ControlFlowGraphTest, IfElseDiamond)
+{
+    const auto& func = Generate("int main() {\n"
+                                "    int x = 1;\n"
+                                "    if (x) { x = 2; } else { x = 3; }\n"
+                                "    return x;\n"
+                                "}\n");
+    ControlFlowGraph cfg(func);
+    BlockId then_b = FindBlock(func, "if_then");
+    BlockId else_b = FindBlock(func, "if_else");
+    BlockId end_b = FindBlock(func, "if_end");
+
+    EXPECT_EQ(cfg.successors(0), (std::vector<BlockId> { else_b, then_b }));
+    EXPECT_EQ(cfg.predecessors(end_b), (std::vector<BlockId> { then_b, else_b }));
+    EXPECT_TRUE(cfg.successors(end_b).empty());
+
+    EXPECT_EQ(cfg.reverse_postorder().front(), 0);
+    EXPECT_EQ(cfg.reverse_postorder().back(), end_b);
+    EXPECT_EQ(cfg.idom(0), 0);
+    EXPECT_EQ(cfg.idom(then_b), 0);
+    EXPECT_EQ(cfg.idom(else_b), 0);
+    EXPECT_EQ(cfg.idom(end_b), 0);
+    EXPECT_EQ(cfg.dom_children(0).size(), 3);
+    EXPECT_TRUE(cfg.dominates(0, end_b));
+    EXPECT_FALSE(cfg.dominates(then_b, end_b));
+    EXPECT_TRUE(cfg.dominates(end_b, end_b));
+
+    EXPECT_EQ(cfg.dominance_frontier(then_b), (std::vector<BlockId> { end_b }));
+    EXPECT_EQ(cfg.dominance_frontier(else_b), (std::vector<BlockId> { end_b }));
+    EXPECT_TRUE(cfg.dominance_frontier(0).empty());
+}
+
+TEST_F(ControlFlowGraphTest, WhileLoop)
+{
+    const auto& func = Generate("int main() {\n"
+                                "    int i = 0;\n"
+                                "    while (i < 10) { i = i + 1; }\n"
+                                "    return i;\n"
+                                "}\n");
+    ControlFlowGraph cfg(func);
+    BlockId cond = FindBlock(func, "while_cond");
+    BlockId body = FindBlock(func, "while_body");
+    BlockId end = FindBlock(func, "while_end");
+
+    EXPECT_EQ(cfg.predecessors(cond), (std::vector<BlockId> { 0, body }));
+    EXPECT_EQ(cfg.successors(body), (std::vector<BlockId> { cond }));
+    EXPECT_EQ(cfg.idom(body), cond);
+    EXPECT_EQ(cfg.idom(end), cond);
+    EXPECT_TRUE(cfg.dominates(cond, body));
+    EXPECT_FALSE(cfg.dominates(body, cond));
+    EXPECT_LT(cfg.rpo_index(cond), cfg.rpo_index(body));
+
+    // The back edge puts the loop header in the frontier of the body and of itself.
+    EXPECT_EQ(cfg.dominance_frontier(body), (std::vector<BlockId> { cond }));
+    EXPECT_EQ(cfg.dominance_frontier(cond), (std::vector<BlockId> { cond }));
+    EXPECT_TRUE(cfg.dominance_frontier(0).empty());
+    EXPECT_TRUE(cfg.dominance_frontier(end).empty());
+}
+
+TEST_F(ControlFlowGraphTest, UnreachableBlocks)
+{
+    const auto& func = Generate("int main() {\n"
+                                "    return 1;\n"
+                                "    while (1) { }\n"
+                                "}\n");
+    ControlFlowGraph cfg(func);
+    BlockId cond = FindBlock(func, "while_cond");
+
+    EXPECT_TRUE(cfg.reachable(0));
+    EXPECT_FALSE(cfg.reachable(cond));
+    EXPECT_EQ(cfg.reverse_postorder().size(), 1);
+    EXPECT_EQ(cfg.idom(cond), -1);
+    EXPECT_FALSE(cfg.dominates(0, cond));
+    EXPECT_TRUE(cfg.predecessors(cond).size() > 0); // from the unreachable loop body
+}
+
+} // namespace minic
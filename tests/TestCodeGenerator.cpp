@@ -0,0 +1,169 @@
+#include "minic/CodeGenerator.hpp"
+#include "minic/IRGenerator.hpp"
+#include "minic/Parser.hpp"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace minic
+{
+
+class CodeGeneratorTest : public ::testing::Test
+{
+protected:
+    std::string Compile(const std::string& source)
+    {
+        Lexer lexer(source);
+        auto tokens = lexer.Lex();
+        Parser parser(tokens);
+        auto program = parser.parse();
+        IRGenerator ir_gen;
+        auto ir = ir_gen.generate(*program);
+        return Emit(*ir);
+    }
+
+    std::string Emit(const IRProgram& ir)
+    {
+        std::ostringstream out;
+        CodeGenerator code_gen(out);
+        code_gen.generate(ir);
+        return out.str();
+    }
+
+    bool Contains(const std::string& text, const std::string& needle)
+    {
+        return text.find(needle) != std::string::npos;
+    }
+};
+
+TEST_F(CodeGeneratorTest, BranchesUseExplicitTargets)
+{
+    std::string asm_text = Compile("int main() {\n"
+                                   "    int x = 5;\n"
+                                   "    while (x < 10) {\n"
+                                   "        x = x + 1;\n"
+                                   "    }\n"
+                                   "    return x;\n"
+                                   "}\n");
+    EXPECT_TRUE(Contains(asm_text, "main:\n"));
+    EXPECT_TRUE(Contains(asm_text, ", 5\nwhile_cond_1:\n")); // entry falls into the loop
+    EXPECT_TRUE(Contains(asm_text, "    jge while_end_3\nwhile_body_2:\n")); // body falls through
+    EXPECT_TRUE(Contains(asm_text, "    jmp while_cond_1\nwhile_end_3:\n")); // back edge
+    EXPECT_FALSE(Contains(asm_text, "jmp main_epilogue")); // the last block returns into the epilogue
+}
+
+TEST_F(CodeGeneratorTest, ComparisonFusesWithBranch)
+{
+    std::string asm_text = Compile("int main(int x) {\n"
+                                   "    if (x == 3) { return 1; }\n"
+                                   "    int big = x > 10;\n"
+                                   "    if (big) { return 2; }\n"
+                                   "    return big;\n"
+                                   "}\n");
+    // The first condition is only read by its branch: cmp and the inverted jcc.
+    EXPECT_TRUE(Contains(asm_text, "    cmp rax, 3\n    jne "));
+    EXPECT_FALSE(Contains(asm_text, "sete"));
+    // big is also returned, so it is stored and tested.
+    EXPECT_TRUE(Contains(asm_text, "    setg al\n"));
+    EXPECT_TRUE(Contains(asm_text, "    cmp rax, 0\n    je "));
+}
+
+TEST_F(CodeGeneratorTest, ConditionalJumpToNonAdjacentBlock)
+{
+    IRProgram program;
+    auto func = std::make_unique<IRFunction>("main", TokenType::KEYWORD_INT, std::vector<Parameter> {});
+    BlockId entry = func->add_block("entry");
+    BlockId other = func->add_block("other");
+    BlockId taken = func->add_block("taken");
+    IROperand cond = func->new_temp();
+    func->append(entry, IRInstruction(IROpcode::ASSIGN, cond, IROperand::imm(1)));
+    func->append(entry, IRInstruction(IROpcode::JUMPIFNOT, IROperand::block(taken), cond, IROperand::block(other)));
+    func->append(other, IRInstruction(IROpcode::RETURN, {}, IROperand::imm(0)));
+    func->append(taken, IRInstruction(IROpcode::RETURN, {}, IROperand::imm(1)));
+    program.functions.push_back(std::move(func));
+
+    std::string asm_text = Emit(program);
+    // The branch is inverted so that it falls through to the next block.
+    EXPECT_TRUE(Contains(asm_text, "    jne taken\nother:\n"));
+    EXPECT_TRUE(Contains(asm_text, "    jmp main_epilogue\ntaken:\n"));
+}
+
+TEST_F(CodeGeneratorTest, CheapMultiplicationsAndShifts)
+{
+    IRProgram program;
+    auto func = std::make_unique<IRFunction>("main", TokenType::KEYWORD_INT, std::vector<Parameter> { Parameter(TokenType::KEYWORD_INT, "x") });
+    BlockId entry = func->add_block("entry");
+    IROperand x = func->variable("x");
+    IROperand scaled = func->new_temp();
+    IROperand shifted = func->new_temp();
+    IROperand high = func->new_temp();
+    IROperand moved = func->new_temp();
+    func->append(entry, IRInstruction(IROpcode::MUL, scaled, x, IROperand::imm(9)));
+    func->append(entry, IRInstruction(IROpcode::SAR, shifted, scaled, IROperand::imm(3)));
+    func->append(entry, IRInstruction(IROpcode::MULH, high, shifted, x));
+    func->append(entry, IRInstruction(IROpcode::SHL, moved, high, x));
+    func->append(entry, IRInstruction(IROpcode::RETURN, {}, moved));
+    program.functions.push_back(std::move(func));
+
+    std::string asm_text = Emit(program);
+    EXPECT_TRUE(Contains(asm_text, "    lea rax, [rax+rax*8]\n"));
+    EXPECT_TRUE(Contains(asm_text, "    sar rax, 3\n"));
+    EXPECT_TRUE(Contains(asm_text, "    imul rbx\n"));
+    EXPECT_TRUE(Contains(asm_text, "    shl rax, cl\n"));
+    EXPECT_FALSE(Contains(asm_text, "imul rax"));
+}
+
+TEST_F(CodeGeneratorTest, SelectBecomesConditionalMove)
+{
+    IRProgram program;
+    auto func = std::make_unique<IRFunction>("main", TokenType::KEYWORD_INT, std::vector<Parameter> { Parameter(TokenType::KEYWORD_INT, "x") });
+    BlockId entry = func->add_block("entry");
+    IROperand x = func->variable("x");
+    IROperand r = func->new_temp();
+    func->append(entry, IRInstruction(IROpcode::ASSIGN, r, IROperand::imm(1)));
+    func->append(entry, IRInstruction(IROpcode::SELECT, r, x, IROperand::imm(7)));
+    func->append(entry, IRInstruction(IROpcode::RETURN, {}, r));
+    program.functions.push_back(std::move(func));
+
+    std::string asm_text = Emit(program);
+    EXPECT_TRUE(Contains(asm_text, "    mov rcx, 7\n"));
+    EXPECT_TRUE(Contains(asm_text, "    test rdx, rdx\n    cmovne rax, rcx\n"));
+    EXPECT_FALSE(Contains(asm_text, "    jne "));
+}
+
+TEST_F(CodeGeneratorTest, StringConstantsGoToDataSection)
+{
+    std::string asm_text = Compile("int main() {\n"
+                                   "    string s = \"hi\";\n"
+                                   "    return 0;\n"
+                                   "}\n");
+    EXPECT_TRUE(Contains(asm_text, "    lea rax, [rel main_str0]\n"));
+    EXPECT_TRUE(Contains(asm_text, "main_str0: db 104, 105, 0\n"));
+}
+
+TEST_F(CodeGeneratorTest, RejectsBlocksWithoutTerminator)
+{
+    IRProgram program;
+    auto func = std::make_unique<IRFunction>("main", TokenType::KEYWORD_INT, std::vector<Parameter> {});
+    BlockId entry = func->add_block("entry");
+    func->append(entry, IRInstruction(IROpcode::ASSIGN, func->new_temp(), IROperand::imm(1)));
+    program.functions.push_back(std::move(func));
+
+    EXPECT_THROW(Emit(program), std::runtime_error);
+}
+
+TEST_F(CodeGeneratorTest, RejectsSSAForm)
+{
+    IRProgram program;
+    auto func = std::make_unique<IRFunction>("main", TokenType::KEYWORD_INT, std::vector<Parameter> {});
+    BlockId entry = func->add_block("entry");
+    BlockId exit = func->add_block("exit");
+    func->append(entry, IRInstruction(IROpcode::JUMP, {}, IROperand::block(exit)));
+    IROperand value = func->new_temp();
+    func->blocks[exit].phis.push_back({ value, { { entry, IROperand::imm(1) } } });
+    func->append(exit, IRInstruction(IROpcode::RETURN, {}, value));
+    program.functions.push_back(std::move(func));
+
+    EXPECT_THROW(Emit(program), std::runtime_error);
+}
+
+} // namespace minic
@@ -0,0 +1,155 @@
+#include "TestUtils.hpp"
+#include "minic/CodeSinking.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/Loops.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+namespace minic
+{
+
+class CodeSinkingTest : public IRTest
+{
+protected:
+    // SSA form with the copies of source variables gone, as in the compiler.
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        CopyPropagation().run(func);
+        return func;
+    }
+
+    // Sink and check every input; returns the summed step counts before and after.
+    std::pair<std::uint64_t, std::uint64_t> Sink(IRFunction& func, const Inputs& inputs)
+    {
+        auto [before, after] = ExpectPreserved(func, inputs, [](IRFunction& f) {
+            EXPECT_TRUE(CodeSinking().run(f));
+            f.compact();
+        });
+        return { before.steps, after.steps };
+    }
+};
+
+TEST_F(CodeSinkingTest, SinksIntoArmThatUsesValue)
+{
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int p = a * b;\n"
+                                "    int q = p + 7;\n"
+                                "    if (a > 0) { return q; }\n"
+                                "    return b;\n"
+                                "}\n");
+    Sink(func, { { -1, 4 }, { 0, 4 }, { 3, 4 } });
+    // Both the product and the sum it feeds moved into the then side.
+    BlockId mul = BlockOf(func, IROpcode::MUL);
+    EXPECT_NE(mul, 0);
+    EXPECT_EQ(BlockOf(func, IROpcode::ADD), mul);
+    EXPECT_EQ(func.terminator(mul).opcode, IROpcode::RETURN);
+}
+
+TEST_F(CodeSinkingTest, SinksToCommonDominatorOfUses)
+{
+    // Both arms of the inner if read p, so it goes to the block testing b.
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int p = a * 3;\n"
+                                "    int r = 0;\n"
+                                "    if (a > 0) {\n"
+                                "        if (b > 0) { r = p + 1; } else { r = p - 1; }\n"
+                                "    }\n"
+                                "    return r;\n"
+                                "}\n");
+    Sink(func, { { -2, 1 }, { 2, 1 }, { 2, -1 } });
+    BlockId mul = BlockOf(func, IROpcode::MUL);
+    ASSERT_NE(mul, -1);
+    EXPECT_NE(mul, 0);
+    EXPECT_EQ(func.terminator(mul).opcode, IROpcode::JUMPIFNOT);
+}
+
+TEST_F(CodeSinkingTest, KeepsValuesUsedOnBothPaths)
+{
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int p = a * b;\n"
+                                "    int r = 0;\n"
+                                "    if (a > 0) { r = p; } else { r = p + 1; }\n"
+                                "    return r;\n"
+                                "}\n");
+    EXPECT_FALSE(CodeSinking().run(func));
+    EXPECT_EQ(BlockOf(func, IROpcode::MUL), 0);
+}
+
+TEST_F(CodeSinkingTest, DoesNotSinkIntoLoops)
+{
+    IRFunction& func = Generate("int main(int n, int a) {\n"
+                                "    int p = a * a;\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    if (n > 0) {\n"
+                                "        while (i < n) { s = s + p; i = i + 1; }\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    Sink(func, { { 0, 3 }, { 4, 3 } });
+    // The product stops in front of the loop.
+    ControlFlowGraph cfg(func);
+    LoopInfo loops(cfg);
+    BlockId mul = BlockOf(func, IROpcode::MUL);
+    EXPECT_NE(mul, 0);
+    EXPECT_EQ(loops.loop_of(mul), -1);
+}
+
+TEST_F(CodeSinkingTest, DoesNotMoveTrappingDivision)
+{
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int q = a / b;\n"
+                                "    if (a > 0) { return q; }\n"
+                                "    return 0;\n"
+                                "}\n");
+    EXPECT_FALSE(CodeSinking().run(func));
+}
+
+TEST_F(CodeSinkingTest, IgnoresReadersInUnreachableBlocks)
+{
+    // Branch folding leaves blocks like dead behind; they have no dominators.
+    IRFunction func("main", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "a") });
+    BlockId entry = func.add_block("entry");
+    BlockId then = func.add_block("then");
+    BlockId other = func.add_block("other");
+    BlockId dead = func.add_block("dead");
+    IROperand p = func.new_temp();
+    IROperand q = func.new_temp();
+    IROperand cond = func.new_temp();
+    IROperand r = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::MUL, p, func.variable("a"), IROperand::imm(3)));
+    func.append(entry, IRInstruction(IROpcode::ADD, q, func.variable("a"), IROperand::imm(5)));
+    func.append(entry, IRInstruction(IROpcode::GT, cond, func.variable("a"), IROperand::imm(0)));
+    func.append(entry, IRInstruction(IROpcode::JUMPIF, IROperand::block(other), cond, IROperand::block(then)));
+    func.append(then, IRInstruction(IROpcode::RETURN, {}, p));
+    func.append(other, IRInstruction(IROpcode::RETURN, {}, IROperand::imm(0)));
+    func.append(dead, IRInstruction(IROpcode::ADD, r, p, q));
+    func.append(dead, IRInstruction(IROpcode::RETURN, {}, r));
+    Sink(func, { { -1 }, { 0 }, { 4 } });
+    // The product follows its reachable reader; the sum has none and stays.
+    EXPECT_EQ(BlockOf(func, IROpcode::MUL), then);
+    EXPECT_EQ(func.block_instructions(entry)[0].opcode, IROpcode::ADD);
+}
+
+TEST_F(CodeSinkingTest, BenchWorkOnlyOneArmNeeds)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int w = i * i + i * 3 - 5;\n"
+                                "        if (i > 900) { s = s + w; } else { s = s + 1; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    auto [before, after] = Sink(func, { { 1000 } });
+    // Nine in ten iterations skip computing w.
+    std::cout << "[ bench    ] value used in one arm, n = 1000: " << before << " -> " << after << " steps\n";
+    EXPECT_LT(after + 3000, before);
+}
+
+} // namespace minic
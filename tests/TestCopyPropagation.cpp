@@ -0,0 +1,103 @@
+#include "TestUtils.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/InstCombine.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class CopyPropagationTest : public IRTest
+{
+protected:
+    const IRInstruction& Return(const IRFunction& func)
+    {
+        for (const auto& block : func.blocks)
+        {
+            const IRInstruction& term = func.block_instructions(block).back();
+            if (term.opcode == IROpcode::RETURN)
+                return term;
+        }
+        throw std::runtime_error("no return");
+    }
+};
+
+TEST_F(CopyPropagationTest, ChainsResolveToTheSource)
+{
+    // InstCombine turns each identity into a copy; the chain then collapses onto a.
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int x = a + 0;\n"
+                                "    int y = x * 1;\n"
+                                "    return y - 0;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    InstCombine().run(func);
+    EXPECT_TRUE(CopyPropagation().run(func));
+    func.verify();
+    EXPECT_EQ(Count(func, IROpcode::ASSIGN), 0);
+    EXPECT_EQ(func.terminator(0).operand1, func.variable("a"));
+    EXPECT_FALSE(CopyPropagation().run(func));
+}
+
+TEST_F(CopyPropagationTest, TrivialPhisDisappear)
+{
+    // Both phis merge a with itself: the if's directly, the loop's through its own back edge.
+    IRFunction& func = Generate("int main(int a, int n) {\n"
+                                "    int x = a;\n"
+                                "    if (n > 3) { x = a; }\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { x = x; i = i + 1; }\n"
+                                "    return x;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    size_t before = PhiCount(func);
+    CopyPropagation().run(func);
+    func.verify();
+    EXPECT_EQ(PhiCount(func), before - 2);
+    EXPECT_EQ(Return(func).operand1, func.variable("a"));
+    EXPECT_EQ(IRInterpreter().run(func, { 11, 5 }).value, 11);
+}
+
+TEST_F(CopyPropagationTest, CopiesFromUnstableSourcesStayLocal)
+{
+    // Straight from the generator x and y are written variables; y = x is only
+    // forwarded until x is overwritten.
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int x = a;\n"
+                                "    int y = x;\n"
+                                "    x = 3;\n"
+                                "    return y + x;\n"
+                                "}\n");
+    IRInterpreter interp;
+    std::int64_t expected = interp.run(func, { 4 }).value;
+    EXPECT_TRUE(CopyPropagation().run(func));
+    func.verify();
+    const IRInstruction* add = nullptr;
+    for (const auto& instr : func.block_instructions(0))
+    {
+        if (instr.opcode == IROpcode::ADD)
+            add = &instr;
+    }
+    ASSERT_NE(add, nullptr);
+    EXPECT_EQ(add->operand1, func.variable("a"));
+    EXPECT_EQ(add->operand2, IROperand::imm(3));
+    EXPECT_EQ(interp.run(func, { 4 }).value, expected);
+}
+
+TEST_F(CopyPropagationTest, WrittenVariableIsNotPropagatedAcrossBlocks)
+{
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int x = a;\n"
+                                "    if (a > 1) { x = 7; }\n"
+                                "    return x;\n"
+                                "}\n");
+    IRInterpreter interp;
+    CopyPropagation().run(func);
+    func.verify();
+    EXPECT_EQ(Return(func).operand1, func.variable("x"));
+    EXPECT_EQ(interp.run(func, { 0 }).value, 0);
+    EXPECT_EQ(interp.run(func, { 5 }).value, 7);
+}
+
+} // namespace minic
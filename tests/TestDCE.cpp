@@ -0,0 +1,105 @@
+#include "TestUtils.hpp"
+#include "minic/DCE.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class DCETest : public IRTest
+{
+protected:
+    size_t InstructionCount(const IRFunction& func)
+    {
+        size_t count = 0;
+        for (const auto& block : func.blocks)
+            count += block.size;
+        return count;
+    }
+
+    // Run DCE and check the function still computes the same values.
+    void Eliminate(IRFunction& func, const Inputs& inputs)
+    {
+        ExpectPreserved(func, inputs, [](IRFunction& f) { DeadCodeElimination().run(f); });
+    }
+};
+
+TEST_F(DCETest, UnusedTempsAreDeleted)
+{
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int t = a * 3 + 1;\n"
+                                "    int unused = a - 2;\n"
+                                "    return a;\n"
+                                "}\n");
+    Eliminate(func, { { 4 } });
+    EXPECT_EQ(InstructionCount(func), 1);
+    EXPECT_EQ(func.terminator(0).opcode, IROpcode::RETURN);
+    EXPECT_FALSE(DeadCodeElimination().run(func));
+}
+
+TEST_F(DCETest, OverwrittenStoresAreDeleted)
+{
+    // Outside SSA form: the first store to x is overwritten on every path,
+    // and the last store to y is never read before the return.
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int x = a + 1;\n"
+                                "    int y = 0;\n"
+                                "    if (a > 2) { x = a * 2; } else { x = a * 3; }\n"
+                                "    y = x + 7;\n"
+                                "    return x;\n"
+                                "}\n");
+    Eliminate(func, { { 1 }, { 5 } });
+    EXPECT_EQ(Count(func, IROpcode::ADD), 0);
+    EXPECT_EQ(Count(func, IROpcode::MUL), 2);
+    for (const auto& block : func.blocks)
+    {
+        for (const auto& instr : func.block_instructions(block))
+            EXPECT_NE(instr.result, func.variable("y"));
+    }
+}
+
+TEST_F(DCETest, StoreReadOnOnePathIsKept)
+{
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int x = 5;\n"
+                                "    if (a) { x = 6; }\n"
+                                "    return x;\n"
+                                "}\n");
+    Eliminate(func, { { 0 }, { 1 } });
+    EXPECT_EQ(Count(func, IROpcode::ASSIGN), 2);
+}
+
+TEST_F(DCETest, DeadLoopCycleIsDeleted)
+{
+    // j is only read to update itself, so its phi and add form a dead cycle.
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int i = 0;\n"
+                                "    int j = 0;\n"
+                                "    while (i < n) { j = j + 2; i = i + 1; }\n"
+                                "    return i;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    Eliminate(func, { { 0 }, { 3 } });
+    size_t phis = 0;
+    for (const auto& block : func.blocks)
+        phis += block.phis.size();
+    EXPECT_EQ(phis, 1);
+    EXPECT_EQ(Count(func, IROpcode::ADD), 1);
+}
+
+TEST_F(DCETest, TrappingDivisionIsKept)
+{
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int q = a / b;\n"
+                                "    int r = a / 4;\n"
+                                "    return a;\n"
+                                "}\n");
+    DeadCodeElimination().run(func);
+    func.verify();
+    ASSERT_EQ(Count(func, IROpcode::DIV), 1);
+    EXPECT_EQ(func.block_instructions(0)[0].operand2, func.variable("b"));
+    EXPECT_THROW(IRInterpreter().run(func, { 1, 0 }), std::runtime_error);
+}
+
+} // namespace minic
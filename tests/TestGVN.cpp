@@ -0,0 +1,107 @@
+#include "TestUtils.hpp"
+#include "minic/GVN.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class GVNTest : public IRTest
+{
+protected:
+    // Generate IR in SSA form, number it and check the results did not change.
+    IRFunction& Number(const std::string& source, const Inputs& inputs)
+    {
+        IRFunction& func = Generate(source);
+        SSAConstruction().run(func);
+        ExpectPreserved(func, inputs, [](IRFunction& f) { GVN().run(f); });
+        return func;
+    }
+};
+
+TEST_F(GVNTest, RepeatedExpressionIsComputedOnce)
+{
+    IRFunction& func = Number("int main(int a, int b) {\n"
+                              "    return a * b + b * a;\n"
+                              "}\n",
+        { { 3, 4 } });
+    EXPECT_EQ(Count(func, IROpcode::MUL), 1);
+    const IRInstruction& add = func.block_instructions(0)[1];
+    ASSERT_EQ(add.opcode, IROpcode::ADD);
+    EXPECT_EQ(add.operand1, add.operand2);
+    EXPECT_FALSE(GVN().run(func));
+}
+
+TEST_F(GVNTest, NumbersLookThroughCopiesAndChains)
+{
+    // i and j are the same value, so both index expressions are the same.
+    IRFunction& func = Number("int main(int a, int n) {\n"
+                              "    int i = n + 1;\n"
+                              "    int j = i;\n"
+                              "    int p = (i * 4 + a) - (j * 4 + a);\n"
+                              "    return p;\n"
+                              "}\n",
+        { { 2, 7 } });
+    EXPECT_EQ(Count(func, IROpcode::MUL), 1);
+    EXPECT_EQ(Count(func, IROpcode::ADD), 2);
+}
+
+TEST_F(GVNTest, DominatingComparisonIsReused)
+{
+    IRFunction& func = Number("int main(int a, int b) {\n"
+                              "    int r = 0;\n"
+                              "    if (a < b) {\n"
+                              "        if (b > a) { r = 1; }\n"
+                              "    }\n"
+                              "    return r;\n"
+                              "}\n",
+        { { 1, 2 }, { 2, 1 } });
+    EXPECT_EQ(Count(func, IROpcode::LT) + Count(func, IROpcode::GT), 1);
+}
+
+TEST_F(GVNTest, SiblingBranchesAreNotMerged)
+{
+    // Neither arm dominates the other, so each keeps its own multiplication.
+    IRFunction& func = Number("int main(int a, int b) {\n"
+                              "    int r;\n"
+                              "    if (a) { r = a * b; } else { r = a * b + 1; }\n"
+                              "    return r;\n"
+                              "}\n",
+        { { 0, 5 }, { 2, 5 } });
+    EXPECT_EQ(Count(func, IROpcode::MUL), 2);
+}
+
+TEST_F(GVNTest, IdenticalPhisAreMerged)
+{
+    IRFunction& func = Number("int main(int c, int a) {\n"
+                              "    int x = 1;\n"
+                              "    int y = 1;\n"
+                              "    if (c) { x = a; y = a; }\n"
+                              "    return x * 10 + y;\n"
+                              "}\n",
+        { { 0, 4 }, { 1, 4 } });
+    size_t phis = 0;
+    for (const auto& block : func.blocks)
+        phis += block.phis.size();
+    EXPECT_EQ(phis, 1);
+}
+
+TEST_F(GVNTest, WrittenVariablesAreNotNumbered)
+{
+    // Outside SSA form x changes between the two x * 2.
+    IRFunction& func = Generate("int main(int x) {\n"
+                                "    int a = x * 2;\n"
+                                "    x = x + 1;\n"
+                                "    int b = x * 2;\n"
+                                "    return a + b;\n"
+                                "}\n");
+    IRInterpreter interp;
+    std::int64_t expected = interp.run(func, { 5 }).value;
+    GVN().run(func);
+    func.verify();
+    EXPECT_EQ(Count(func, IROpcode::MUL), 2);
+    EXPECT_EQ(interp.run(func, { 5 }).value, expected);
+}
+
+} // namespace minic
@@ -0,0 +1,172 @@
+#include "minic/IR.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class IRFunctionTest : public ::testing::Test
+{
+protected:
+    IRFunction func_ { "f", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "a") } };
+
+    std::vector<int> Immediates(BlockId id)
+    {
+        std::vector<int> values;
+        for (const auto& instr : func_.block_instructions(id))
+            values.push_back(instr.operand1.value);
+        return values;
+    }
+
+    IRInstruction Assign(int value)
+    {
+        return IRInstruction(IROpcode::ASSIGN, func_.variable("x"), IROperand::imm(value));
+    }
+};
+
+TEST_F(IRFunctionTest, OperandNames)
+{
+    EXPECT_EQ(func_.variables.size(), 1);
+    EXPECT_EQ(func_.variable("a"), IROperand::var(0));
+    EXPECT_EQ(func_.variable("x"), IROperand::var(1));
+    EXPECT_EQ(func_.new_temp(), IROperand::temp(0));
+    BlockId entry = func_.add_block("entry_0");
+
+    EXPECT_EQ(func_.operand_name(IROperand::var(1)), "x");
+    EXPECT_EQ(func_.operand_name(IROperand::temp(0)), "t0");
+    EXPECT_EQ(func_.operand_name(IROperand::imm(-3)), "-3");
+    EXPECT_EQ(func_.operand_name(IROperand::block(entry)), "entry_0");
+    EXPECT_EQ(func_.operand_name(func_.add_string("hi")), "str0");
+    EXPECT_EQ(func_.operand_name({}), "");
+}
+
+TEST_F(IRFunctionTest, BlocksAreContiguousRanges)
+{
+    BlockId a = func_.add_block("a");
+    func_.append(a, Assign(1));
+    func_.append(a, Assign(2));
+    BlockId b = func_.add_block("b");
+    func_.append(b, Assign(3));
+
+    EXPECT_EQ(func_.instructions.size(), 3);
+    EXPECT_EQ(func_.blocks[a].begin, 0);
+    EXPECT_EQ(func_.blocks[b].begin, 2);
+    EXPECT_EQ(Immediates(a), (std::vector<int> { 1, 2 }));
+    EXPECT_EQ(Immediates(b), (std::vector<int> { 3 }));
+}
+
+TEST_F(IRFunctionTest, AppendToEarlierBlockRelocatesAndCompactRestoresOrder)
+{
+    BlockId a = func_.add_block("a");
+    func_.append(a, Assign(1));
+    BlockId b = func_.add_block("b");
+    func_.append(b, Assign(2));
+
+    func_.append(a, Assign(3));
+    EXPECT_EQ(func_.blocks[a].begin, 2);
+    EXPECT_EQ(Immediates(a), (std::vector<int> { 1, 3 }));
+
+    func_.compact();
+    EXPECT_EQ(func_.instructions.size(), 3);
+    EXPECT_EQ(func_.blocks[a].begin, 0);
+    EXPECT_EQ(func_.blocks[b].begin, 2);
+    EXPECT_EQ(Immediates(a), (std::vector<int> { 1, 3 }));
+    EXPECT_EQ(Immediates(b), (std::vector<int> { 2 }));
+}
+
+TEST_F(IRFunctionTest, SetBlockInstructions)
+{
+    BlockId a = func_.add_block("a");
+    func_.append(a, Assign(1));
+    func_.append(a, Assign(2));
+    BlockId b = func_.add_block("b");
+    func_.append(b, Assign(3));
+
+    // Shrinking stays in place
+    func_.set_block_instructions(a, { Assign(4) });
+    EXPECT_EQ(func_.blocks[a].begin, 0);
+    EXPECT_EQ(Immediates(a), (std::vector<int> { 4 }));
+
+    // Growing the last block extends it in place
+    func_.set_block_instructions(b, { Assign(5), Assign(6) });
+    EXPECT_EQ(func_.blocks[b].begin, 2);
+    EXPECT_EQ(Immediates(b), (std::vector<int> { 5, 6 }));
+
+    // Growing an earlier block moves it to the end
+    func_.set_block_instructions(a, { Assign(7), Assign(8), Assign(9) });
+    EXPECT_EQ(func_.blocks[a].begin, 4);
+    EXPECT_EQ(Immediates(a), (std::vector<int> { 7, 8, 9 }));
+
+    func_.set_block_instructions(b, {});
+    func_.compact();
+    EXPECT_EQ(func_.instructions.size(), 3);
+    EXPECT_EQ(Immediates(a), (std::vector<int> { 7, 8, 9 }));
+    EXPECT_TRUE(Immediates(b).empty());
+}
+
+TEST_F(IRFunctionTest, VerifyRejectsMalformedBlocks)
+{
+    IRFunction func("bad", TokenType::KEYWORD_VOID, {});
+    BlockId entry = func.add_block("entry");
+    func.append(entry, IRInstruction(IROpcode::ASSIGN, func.new_temp(), IROperand::imm(1)));
+    EXPECT_THROW(func.verify(), std::runtime_error);
+
+    func.append(entry, IRInstruction(IROpcode::JUMP, {}, IROperand::block(3)));
+    EXPECT_THROW(func.verify(), std::runtime_error);
+
+    func.terminator(entry).operand1 = IROperand::block(entry);
+    EXPECT_NO_THROW(func.verify());
+
+    func.append(entry, IRInstruction(IROpcode::RETURN));
+    EXPECT_THROW(func.verify(), std::runtime_error);
+}
+
+TEST_F(IRFunctionTest, RemoveBlocksRenumbersTargetsAndPhis)
+{
+    BlockId entry = func_.add_block("entry_0");
+    BlockId dead = func_.add_block("dead_1");
+    BlockId exit = func_.add_block("exit_2");
+    func_.append(entry, IRInstruction(IROpcode::JUMP, {}, IROperand::block(exit)));
+    func_.append(dead, IRInstruction(IROpcode::JUMP, {}, IROperand::block(exit)));
+    func_.append(exit, IRInstruction(IROpcode::RETURN, {}, IROperand::temp(0)));
+    func_.blocks[exit].phis.push_back({ IROperand::temp(0), { { entry, IROperand::imm(1) }, { dead, IROperand::imm(2) } } });
+    EXPECT_EQ(func_.new_label("exit"), "exit_3");
+    EXPECT_EQ(func_.new_label("split"), "split_3");
+
+    func_.remove_blocks({ false, true, false });
+    func_.verify();
+    ASSERT_EQ(func_.blocks.size(), 2);
+    EXPECT_EQ(func_.blocks[1].label, "exit_2");
+    EXPECT_EQ(func_.terminator(0).operand1, IROperand::block(1));
+    ASSERT_EQ(func_.blocks[1].phis[0].incoming.size(), 1);
+    EXPECT_EQ(func_.blocks[1].phis[0].value_from(0), IROperand::imm(1));
+    EXPECT_TRUE(func_.blocks[1].phis[0].value_from(1).empty());
+    EXPECT_EQ(func_.instructions.size(), 2);
+
+    EXPECT_THROW(func_.remove_blocks({ true, false }), std::runtime_error);
+}
+
+TEST_F(IRFunctionTest, ReorderBlocksRenumbersTargetsAndPhis)
+{
+    BlockId entry = func_.add_block("entry_0");
+    BlockId exit = func_.add_block("exit_1");
+    BlockId then = func_.add_block("then_2");
+    func_.append(entry, IRInstruction(IROpcode::JUMPIF, IROperand::block(exit), func_.variable("a"), IROperand::block(then)));
+    func_.append(exit, IRInstruction(IROpcode::RETURN, {}, IROperand::temp(0)));
+    func_.append(then, IRInstruction(IROpcode::JUMP, {}, IROperand::block(exit)));
+    func_.blocks[exit].phis.push_back({ IROperand::temp(0), { { entry, IROperand::imm(1) }, { then, IROperand::imm(2) } } });
+
+    func_.reorder_blocks({ entry, then, exit });
+    func_.verify();
+    EXPECT_EQ(func_.blocks[1].label, "then_2");
+    EXPECT_EQ(func_.blocks[2].label, "exit_1");
+    EXPECT_EQ(func_.terminator(0).operand2, IROperand::block(1));
+    EXPECT_EQ(func_.terminator(0).result, IROperand::block(2));
+    EXPECT_EQ(func_.terminator(1).operand1, IROperand::block(2));
+    EXPECT_EQ(func_.blocks[2].phis[0].value_from(1), IROperand::imm(2));
+    EXPECT_EQ(func_.terminator(2).opcode, IROpcode::RETURN);
+
+    EXPECT_THROW(func_.reorder_blocks({ 1, 0, 2 }), std::runtime_error);
+    EXPECT_THROW(func_.reorder_blocks({ 0, 1, 1 }), std::runtime_error);
+}
+
+} // namespace minic
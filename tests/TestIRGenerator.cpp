@@ -99,17 +99,17 @@ protected:
     // Helper to get instruction count in a block
     size_t CountInstructions(const minic::BasicBlock* block)
     {
-        return block ? block->instructions.size() : 0;
+        return block ? block->size : 0;
     }
 
     // Helper to check if instruction exists in block
-    bool HasInstruction(const minic::BasicBlock* block, minic::IROpcode op, const std::string& res = "", const std::string& op1 = "", const std::string& op2 = "")
+    bool HasInstruction(const minic::IRFunction* func, const minic::BasicBlock* block, minic::IROpcode op, const std::string& res = "", const std::string& op1 = "", const std::string& op2 = "")
     {
         if (!block)
             return false;
-        for (const auto& instr : block->instructions)
+        for (const auto& instr : func->block_instructions(*block))
         {
-            if (instr.opcode == op && (res.empty() || instr.result == res) && (op1.empty() || instr.operand1 == op1) && (op2.empty() || instr.operand2 == op2))
+            if (instr.opcode == op && (res.empty() || func->operand_name(instr.result) == res) && (op1.empty() || func->operand_name(instr.operand1) == op1) && (op2.empty() || func->operand_name(instr.operand2) == op2))
             {
                 return true;
             }
@@ -122,9 +122,9 @@ protected:
     {
         for (const auto& block : func->blocks)
         {
-            if (block->label.find(prefix) == 0)
+            if (block.label.find(prefix) == 0)
             {
-                return block.get();
+                return &block;
             }
         }
         return nullptr;
@@ -147,12 +147,10 @@ TEST_F(IRGeneratorTest, DeclWithInit)
 
     ASSERT_EQ(ir->functions.size(), 1);
     ASSERT_EQ(ir->functions[0]->blocks.size(), 1);
-    const auto* entry = ir->functions[0]->blocks[0].get();
-    ASSERT_EQ(CountInstructions(entry), 4); // ASSIGN t0=5, ASSIGN t1=3, ADD t2=t0+t1, ASSIGN x=t2
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ASSIGN, "", "5"));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ASSIGN, "", "3"));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ADD));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ASSIGN, "x"));
+    const auto* entry = &ir->functions[0]->blocks[0];
+    ASSERT_EQ(CountInstructions(entry), 2); // 5 + 3 folds: ASSIGN x=8, RETURN
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::ASSIGN, "x", "8"));
+    EXPECT_FALSE(HasInstruction(ir->functions[0].get(), entry, IROpcode::ADD));
 }
 
 TEST_F(IRGeneratorTest, DeclNoInit)
@@ -168,8 +166,9 @@ TEST_F(IRGeneratorTest, DeclNoInit)
     auto ast = minic::BuildProgram(std::move(funcs));
     auto ir = generator_.generate(*ast);
 
-    const auto* entry = ir->functions[0]->blocks[0].get();
-    EXPECT_EQ(CountInstructions(entry), 0);
+    const auto* entry = &ir->functions[0]->blocks[0];
+    EXPECT_EQ(CountInstructions(entry), 1); // Implicit RETURN
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::RETURN));
 }
 
 TEST_F(IRGeneratorTest, AssignComplexExpr)
@@ -190,12 +189,12 @@ TEST_F(IRGeneratorTest, AssignComplexExpr)
     auto ast = minic::BuildProgram(std::move(funcs));
     auto ir = generator_.generate(*ast);
 
-    const auto* entry = ir->functions[0]->blocks[0].get();
-    EXPECT_GE(CountInstructions(entry), 6); // NEG, DIV, MUL, assigns
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::NEG));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::DIV));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::MUL));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ASSIGN, "x"));
+    const auto* entry = &ir->functions[0]->blocks[0];
+    EXPECT_EQ(CountInstructions(entry), 4); // NEG, MUL, ASSIGN x, RETURN; 2 / 4 folds to 0
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::NEG));
+    EXPECT_FALSE(HasInstruction(ir->functions[0].get(), entry, IROpcode::DIV));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::MUL, "", "", "0"));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::ASSIGN, "x"));
 }
 
 TEST_F(IRGeneratorTest, ReturnIntLiteral)
@@ -211,10 +210,9 @@ TEST_F(IRGeneratorTest, ReturnIntLiteral)
     auto ast = minic::BuildProgram(std::move(funcs));
     auto ir = generator_.generate(*ast);
 
-    const auto* entry = ir->functions[0]->blocks[0].get();
-    EXPECT_EQ(CountInstructions(entry), 2);
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ASSIGN, "", "42"));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::RETURN));
+    const auto* entry = &ir->functions[0]->blocks[0];
+    EXPECT_EQ(CountInstructions(entry), 1);
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::RETURN, "", "42"));
 }
 
 TEST_F(IRGeneratorTest, ReturnVoid)
@@ -230,9 +228,9 @@ TEST_F(IRGeneratorTest, ReturnVoid)
     auto ast = minic::BuildProgram(std::move(funcs));
     auto ir = generator_.generate(*ast);
 
-    const auto* entry = ir->functions[0]->blocks[0].get();
+    const auto* entry = &ir->functions[0]->blocks[0];
     EXPECT_EQ(CountInstructions(entry), 1);
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::RETURN));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::RETURN));
 }
 
 TEST_F(IRGeneratorTest, IfWithBranches)
@@ -259,22 +257,21 @@ TEST_F(IRGeneratorTest, IfWithBranches)
     auto ir = generator_.generate(*ast);
 
     EXPECT_EQ(ir->functions[0]->blocks.size(), 4);
-    const auto* entry = ir->functions[0]->blocks[0].get();
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::GT));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::JUMPIFNOT));
+    const auto* entry = &ir->functions[0]->blocks[0];
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::GT));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::JUMPIFNOT));
 
     const auto* then_block = FindBlockByLabelPrefix(ir->functions[0].get(), "if_then");
-    EXPECT_TRUE(HasInstruction(then_block, IROpcode::ASSIGN, "", "1"));
-    EXPECT_TRUE(HasInstruction(then_block, IROpcode::ASSIGN, "y"));
-    EXPECT_TRUE(HasInstruction(then_block, IROpcode::JUMP));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), then_block, IROpcode::ASSIGN, "y", "1"));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), then_block, IROpcode::JUMP));
 
     const auto* else_block = FindBlockByLabelPrefix(ir->functions[0].get(), "if_else");
-    EXPECT_TRUE(HasInstruction(else_block, IROpcode::ASSIGN, "", "0"));
-    EXPECT_TRUE(HasInstruction(else_block, IROpcode::ASSIGN, "y"));
-    EXPECT_TRUE(HasInstruction(else_block, IROpcode::JUMP));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), else_block, IROpcode::ASSIGN, "y", "0"));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), else_block, IROpcode::JUMP));
 
     const auto* end_block = FindBlockByLabelPrefix(ir->functions[0].get(), "if_end");
-    EXPECT_EQ(CountInstructions(end_block), 0);
+    EXPECT_EQ(CountInstructions(end_block), 1);
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), end_block, IROpcode::RETURN));
 }
 
 TEST_F(IRGeneratorTest, IfNoElse)
@@ -321,20 +318,83 @@ TEST_F(IRGeneratorTest, WhileWithBody)
     auto ir = generator_.generate(*ast);
 
     EXPECT_EQ(ir->functions[0]->blocks.size(), 4);
-    const auto* entry = ir->functions[0]->blocks[0].get();
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::JUMP));
+    const auto* entry = &ir->functions[0]->blocks[0];
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::JUMP));
 
     const auto* cond_block = FindBlockByLabelPrefix(ir->functions[0].get(), "while_cond");
-    EXPECT_TRUE(HasInstruction(cond_block, IROpcode::LT));
-    EXPECT_TRUE(HasInstruction(cond_block, IROpcode::JUMPIFNOT));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), cond_block, IROpcode::LT));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), cond_block, IROpcode::JUMPIFNOT));
 
     const auto* body_block = FindBlockByLabelPrefix(ir->functions[0].get(), "while_body");
-    EXPECT_TRUE(HasInstruction(body_block, IROpcode::ADD));
-    EXPECT_TRUE(HasInstruction(body_block, IROpcode::ASSIGN, "i"));
-    EXPECT_TRUE(HasInstruction(body_block, IROpcode::JUMP));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), body_block, IROpcode::ADD));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), body_block, IROpcode::ASSIGN, "i"));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), body_block, IROpcode::JUMP));
 
     const auto* end_block = FindBlockByLabelPrefix(ir->functions[0].get(), "while_end");
-    EXPECT_EQ(CountInstructions(end_block), 0);
+    EXPECT_EQ(CountInstructions(end_block), 1);
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), end_block, IROpcode::RETURN));
+}
+
+TEST_F(IRGeneratorTest, OperandsAreTyped)
+{
+    auto ast = ParseSource("int main() {\n"
+                           "    int i = 0;\n"
+                           "    while (i < 10) {\n"
+                           "        i = i + 1;\n"
+                           "    }\n"
+                           "    return i;\n"
+                           "}\n");
+    auto ir = generator_.generate(*ast);
+    const auto* func = ir->functions[0].get();
+
+    auto entry = func->block_instructions(0);
+    EXPECT_TRUE(entry[0].result.is_var());
+    EXPECT_EQ(func->operand_name(entry[0].result), "i");
+    EXPECT_TRUE(entry[0].operand1.is_imm());
+    const auto* body = FindBlockByLabelPrefix(func, "while_body");
+    EXPECT_TRUE(func->block_instructions(*body)[0].result.is_temp());
+
+    // Jump targets are block operands, including the back-edge of the loop.
+    EXPECT_EQ(entry.back().opcode, IROpcode::JUMP);
+    ASSERT_TRUE(entry.back().operand1.is_block());
+    EXPECT_EQ(func->operand_name(entry.back().operand1), "while_cond_1");
+    const auto* body_block = FindBlockByLabelPrefix(func, "while_body");
+    EXPECT_EQ(func->block_instructions(*body_block).back().operand1, entry.back().operand1);
+    const auto* cond_block = FindBlockByLabelPrefix(func, "while_cond");
+    ASSERT_TRUE(func->block_instructions(*cond_block).back().operand2.is_block());
+    EXPECT_EQ(func->operand_name(func->block_instructions(*cond_block).back().operand2), "while_end_3");
+}
+
+TEST_F(IRGeneratorTest, EveryBlockEndsInOneTerminator)
+{
+    auto ast = ParseSource("int main() {\n"
+                           "    int x = 5;\n"
+                           "    if (x > 0) {\n"
+                           "        return 1;\n"
+                           "        x = 2;\n"
+                           "    } else {\n"
+                           "        while (x < 10) {\n"
+                           "            x = x + 1;\n"
+                           "        }\n"
+                           "    }\n"
+                           "}\n");
+    auto ir = generator_.generate(*ast);
+    const auto* func = ir->functions[0].get();
+    EXPECT_NO_THROW(func->verify());
+
+    // Both arms of the branch are explicit
+    const auto& branch = func->terminator(0);
+    EXPECT_EQ(branch.opcode, IROpcode::JUMPIFNOT);
+    EXPECT_EQ(func->operand_name(branch.result), "if_then_1");
+    EXPECT_EQ(func->operand_name(branch.operand2), "if_else_2");
+
+    // The assignment after the return is dropped, and so is the jump to if_end
+    const auto* then_block = FindBlockByLabelPrefix(func, "if_then");
+    EXPECT_EQ(CountInstructions(then_block), 1);
+    EXPECT_EQ(func->block_instructions(*then_block).back().opcode, IROpcode::RETURN);
+
+    const auto* cond_block = FindBlockByLabelPrefix(func, "while_cond");
+    EXPECT_EQ(func->operand_name(func->block_instructions(*cond_block).back().result), "while_body_5");
 }
 
 TEST_F(IRGeneratorTest, WhileNoBody)
@@ -373,40 +433,40 @@ TEST_F(IRGeneratorTest, WhileFalseCond)
     auto ir = generator_.generate(*ast);
 
     const auto* cond_block = FindBlockByLabelPrefix(ir->functions[0].get(), "while_cond");
-    EXPECT_TRUE(HasInstruction(cond_block, IROpcode::ASSIGN, "", "0"));
-    EXPECT_TRUE(HasInstruction(cond_block, IROpcode::JUMPIFNOT));
+    EXPECT_EQ(CountInstructions(cond_block), 1);
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), cond_block, IROpcode::JUMPIFNOT, "", "0"));
 }
 
 TEST_F(IRGeneratorTest, UnaryOps)
 {
     // Unary minus
-    auto unary = minic::BuildUnary(TokenType::OP_MINUS, minic::BuildIntLit(10));
+    auto unary = minic::BuildUnary(TokenType::OP_MINUS, minic::BuildId("x"));
     auto assign = minic::BuildAssign("x", std::move(unary));
     std::vector<std::unique_ptr<minic::Stmt>> body1;
+    body1.push_back(minic::BuildVarDecl(TokenType::KEYWORD_INT, "x"));
     body1.push_back(std::move(assign));
     auto func1 = minic::BuildFunction("main", TokenType::KEYWORD_VOID, {}, std::move(body1));
     std::vector<std::unique_ptr<minic::Function>> funcs1;
     funcs1.push_back(std::move(func1));
     auto ir1 = generator_.generate(*minic::BuildProgram(std::move(funcs1)));
-    const auto* entry1 = ir1->functions[0]->blocks[0].get();
-    EXPECT_TRUE(HasInstruction(entry1, IROpcode::ASSIGN, "", "10"));
-    EXPECT_TRUE(HasInstruction(entry1, IROpcode::NEG));
-    EXPECT_TRUE(HasInstruction(entry1, IROpcode::ASSIGN, "x"));
+    const auto* entry1 = &ir1->functions[0]->blocks[0];
+    EXPECT_TRUE(HasInstruction(ir1->functions[0].get(), entry1, IROpcode::NEG, "", "x"));
+    EXPECT_TRUE(HasInstruction(ir1->functions[0].get(), entry1, IROpcode::ASSIGN, "x"));
 
     // Unary not
     generator_ = minic::PublicIRGenerator(); // reset
-    auto unary_not = minic::BuildUnary(TokenType::OP_NOT, minic::BuildIntLit(0));
+    auto unary_not = minic::BuildUnary(TokenType::OP_NOT, minic::BuildId("y"));
     auto ret = minic::BuildReturn(std::move(unary_not));
     std::vector<std::unique_ptr<minic::Stmt>> body2;
+    body2.push_back(minic::BuildVarDecl(TokenType::KEYWORD_INT, "y"));
     body2.push_back(std::move(ret));
     auto func2 = minic::BuildFunction("func", TokenType::KEYWORD_INT, {}, std::move(body2));
     std::vector<std::unique_ptr<minic::Function>> funcs2;
     funcs2.push_back(std::move(func2));
     auto ir2 = generator_.generate(*minic::BuildProgram(std::move(funcs2)));
-    const auto* entry2 = ir2->functions[0]->blocks[0].get();
-    EXPECT_TRUE(HasInstruction(entry2, IROpcode::ASSIGN, "", "0"));
-    EXPECT_TRUE(HasInstruction(entry2, IROpcode::NOT));
-    EXPECT_TRUE(HasInstruction(entry2, IROpcode::RETURN));
+    const auto* entry2 = &ir2->functions[0]->blocks[0];
+    EXPECT_TRUE(HasInstruction(ir2->functions[0].get(), entry2, IROpcode::NOT, "", "y"));
+    EXPECT_TRUE(HasInstruction(ir2->functions[0].get(), entry2, IROpcode::RETURN));
 }
 
 TEST_F(IRGeneratorTest, StringAssign)
@@ -422,9 +482,11 @@ TEST_F(IRGeneratorTest, StringAssign)
     auto ast = minic::BuildProgram(std::move(funcs));
     auto ir = generator_.generate(*ast);
 
-    const auto* entry = ir->functions[0]->blocks[0].get();
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ASSIGN, "", "hello"));
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ASSIGN, "s"));
+    const auto* entry = &ir->functions[0]->blocks[0];
+    ASSERT_EQ(ir->functions[0]->strings.size(), 1);
+    EXPECT_EQ(ir->functions[0]->strings[0], "hello");
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::ASSIGN, "", "str0"));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::ASSIGN, "s"));
 }
 
 TEST_F(IRGeneratorTest, ParamUsageAndVarMapParam)
@@ -443,8 +505,8 @@ TEST_F(IRGeneratorTest, ParamUsageAndVarMapParam)
     auto ast = minic::BuildProgram(std::move(funcs));
     auto ir = generator_.generate(*ast);
 
-    const auto* entry = ir->functions[0]->blocks[0].get();
-    EXPECT_TRUE(HasInstruction(entry, IROpcode::ASSIGN, "b", "a"));
+    const auto* entry = &ir->functions[0]->blocks[0];
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), entry, IROpcode::ASSIGN, "b", "a"));
 
     {
         Parameter p(TokenType::KEYWORD_INT, "p");
@@ -454,7 +516,8 @@ TEST_F(IRGeneratorTest, ParamUsageAndVarMapParam)
 
         generator_.ir_program_ = std::make_unique<minic::IRProgram>();
         generator_.visit(*f);
-        EXPECT_EQ(generator_.var_map_["p"], "p");
+        EXPECT_EQ(generator_.var_map_["p"], IROperand::var(0));
+        EXPECT_EQ(generator_.current_function_->variables[0], "p");
     }
 }
 
@@ -466,13 +529,13 @@ TEST_F(IRGeneratorTest, EmptyFunctionAndFunctionNoBody)
     auto ast = minic::BuildProgram(std::move(funcs));
     auto ir = generator_.generate(*ast);
     EXPECT_EQ(ir->functions[0]->blocks.size(), 1);
-    EXPECT_EQ(CountInstructions(ir->functions[0]->blocks[0].get()), 0);
+    EXPECT_EQ(CountInstructions(&ir->functions[0]->blocks[0]), 1);
 
     auto f2 = minic::BuildFunction("no_body", TokenType::KEYWORD_VOID, {}, {});
     generator_.ir_program_ = std::make_unique<minic::IRProgram>();
     generator_.visit(*f2);
     EXPECT_EQ(generator_.current_function_->blocks.size(), 1);
-    EXPECT_EQ(CountInstructions(generator_.current_function_->blocks[0].get()), 0);
+    EXPECT_EQ(CountInstructions(&generator_.current_function_->blocks[0]), 1);
 }
 
 TEST_F(IRGeneratorTest, NestedIfWhile)
@@ -507,9 +570,8 @@ TEST_F(IRGeneratorTest, ErrorCases)
 {
     generator_.ir_program_ = std::make_unique<minic::IRProgram>();
     auto irf = std::make_unique<minic::IRFunction>("err_test", TokenType::KEYWORD_VOID, std::vector<minic::Parameter> {});
-    irf->blocks.push_back(std::make_unique<minic::BasicBlock>("entry"));
     generator_.current_function_ = irf.get();
-    generator_.current_block_ = irf->blocks[0].get();
+    generator_.current_block_ = irf->add_block("entry");
     generator_.ir_program_->functions.push_back(std::move(irf));
 
     class UnknownStmt : public minic::Stmt
@@ -531,15 +593,15 @@ TEST_F(IRGeneratorTest, ErrorCases)
 TEST_F(IRGeneratorTest, TempLabelAndCounters)
 {
     generator_.temp_counter_ = 0;
-    EXPECT_EQ(generator_.new_temp(), "t0");
-    EXPECT_EQ(generator_.new_temp(), "t1");
+    EXPECT_EQ(generator_.new_temp(), IROperand::temp(0));
+    EXPECT_EQ(generator_.new_temp(), IROperand::temp(1));
 
     generator_.label_counter_ = 0;
     EXPECT_EQ(generator_.new_label("test"), "test_0");
     EXPECT_EQ(generator_.new_label("test"), "test_1");
 
     generator_.temp_counter_ = 5;
-    EXPECT_EQ(generator_.new_temp(), "t5");
+    EXPECT_EQ(generator_.new_temp(), IROperand::temp(5));
     EXPECT_EQ(generator_.temp_counter_, 6);
 
     generator_.label_counter_ = 3;
@@ -549,38 +611,42 @@ TEST_F(IRGeneratorTest, TempLabelAndCounters)
 
 TEST_F(IRGeneratorTest, EmitInstructionAndVariations)
 {
-    auto block = std::make_unique<minic::BasicBlock>("test");
-    generator_.current_block_ = block.get();
-    generator_.emit(minic::IROpcode::ADD, "t2", "t0", "t1");
-    EXPECT_EQ(CountInstructions(block.get()), 1);
-    EXPECT_EQ(block->instructions[0].opcode, minic::IROpcode::ADD);
-    EXPECT_EQ(block->instructions[0].result, "t2");
-    EXPECT_EQ(block->instructions[0].operand1, "t0");
-    EXPECT_EQ(block->instructions[0].operand2, "t1");
+    auto func = std::make_unique<minic::IRFunction>("emit_test", TokenType::KEYWORD_VOID, std::vector<minic::Parameter> {});
+    generator_.current_function_ = func.get();
+    generator_.current_block_ = func->add_block("test");
+    auto instructions = [&]() { return func->block_instructions(generator_.current_block_); };
+    generator_.emit(minic::IROpcode::ADD, IROperand::temp(2), IROperand::temp(0), IROperand::temp(1));
+    EXPECT_EQ(CountInstructions(&func->blocks[0]), 1);
+    EXPECT_EQ(instructions()[0].opcode, minic::IROpcode::ADD);
+    EXPECT_EQ(instructions()[0].result, IROperand::temp(2));
+    EXPECT_EQ(instructions()[0].operand1, IROperand::temp(0));
+    EXPECT_EQ(instructions()[0].operand2, IROperand::temp(1));
 
     // Full
-    generator_.emit(minic::IROpcode::ADD, "res", "op1", "op2");
-    EXPECT_EQ(block->instructions.back().result, "res");
-
-    // No res
-    generator_.emit(minic::IROpcode::JUMP, "", "label");
-    EXPECT_EQ(block->instructions.back().operand1, "label");
-    EXPECT_TRUE(block->instructions.back().result.empty());
+    generator_.emit(minic::IROpcode::ADD, IROperand::var(0), IROperand::var(1), IROperand::imm(7));
+    EXPECT_EQ(instructions().back().result, IROperand::var(0));
+    EXPECT_TRUE(instructions().back().operand2.is_imm());
+    EXPECT_EQ(instructions().back().operand2.value, 7);
 
     // No op2
-    generator_.emit(minic::IROpcode::NEG, "res", "op1");
-    EXPECT_TRUE(block->instructions.back().operand2.empty());
+    generator_.emit(minic::IROpcode::NEG, IROperand::temp(3), IROperand::temp(2));
+    EXPECT_TRUE(instructions().back().operand2.empty());
+
+    // No res
+    generator_.emit(minic::IROpcode::JUMP, {}, IROperand::block(0));
+    EXPECT_EQ(instructions().back().operand1, IROperand::block(0));
+    EXPECT_TRUE(instructions().back().result.empty());
 
-    // No op1/op2
+    // Nothing follows a terminator in the same block
     generator_.emit(minic::IROpcode::RETURN);
-    EXPECT_TRUE(block->instructions.back().operand1.empty());
-    EXPECT_TRUE(block->instructions.back().operand2.empty());
+    EXPECT_EQ(instructions().size(), 4);
+    EXPECT_EQ(instructions().back().opcode, minic::IROpcode::JUMP);
 }
 
 TEST_F(IRGeneratorTest, VarMapAndIRProgram)
 {
-    generator_.var_map_["var"] = "t10";
-    EXPECT_EQ(generator_.var_map_["var"], "t10");
+    generator_.var_map_["var"] = IROperand::temp(10);
+    EXPECT_EQ(generator_.var_map_["var"], IROperand::temp(10));
 
     generator_.ir_program_ = std::make_unique<minic::IRProgram>();
     EXPECT_TRUE(generator_.ir_program_ != nullptr);
@@ -619,9 +685,9 @@ TEST_F(IRGeneratorTest, FullProgramViaParser)
     EXPECT_EQ(ir->functions.size(), 1);
     EXPECT_GE(ir->functions[0]->blocks.size(), 4);
     const auto* then_block = FindBlockByLabelPrefix(ir->functions[0].get(), "if_then");
-    EXPECT_TRUE(HasInstruction(then_block, IROpcode::NEG));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), then_block, IROpcode::NEG));
     const auto* else_block = FindBlockByLabelPrefix(ir->functions[0].get(), "if_else");
-    EXPECT_TRUE(HasInstruction(else_block, IROpcode::NOT));
+    EXPECT_TRUE(HasInstruction(ir->functions[0].get(), else_block, IROpcode::NOT));
 }
 
 TEST_F(IRGeneratorTest, AllArithmeticOps)
@@ -640,19 +706,20 @@ TEST_F(IRGeneratorTest, AllArithmeticOps)
 
     generator_.ir_program_ = std::make_unique<minic::IRProgram>();
     auto irf = std::make_unique<minic::IRFunction>("arith_test", TokenType::KEYWORD_VOID, std::vector<minic::Parameter> {});
-    irf->blocks.push_back(std::make_unique<minic::BasicBlock>("entry"));
     generator_.current_function_ = irf.get();
-    generator_.current_block_ = irf->blocks[0].get();
+    generator_.current_block_ = irf->add_block("entry");
+    generator_.var_map_["a"] = irf->variable("a");
     generator_.ir_program_->functions.push_back(std::move(irf));
 
     generator_.temp_counter_ = 0;
 
     for (const auto& tc : cases)
     {
-        auto bin = minic::BuildBinary(minic::BuildIntLit(10), tc.token_op, minic::BuildIntLit(2));
+        auto bin = minic::BuildBinary(minic::BuildId("a"), tc.token_op, minic::BuildIntLit(2));
         generator_.generate_expr(*bin);
+        EXPECT_EQ(generator_.current_function_->block_instructions(0).back().opcode, tc.ir_op);
     }
-    EXPECT_GE(generator_.temp_counter_, cases.size() * 3);
+    EXPECT_EQ(generator_.temp_counter_, cases.size());
 }
 
 TEST_F(IRGeneratorTest, AllComparisonOps)
@@ -673,19 +740,20 @@ TEST_F(IRGeneratorTest, AllComparisonOps)
 
     generator_.ir_program_ = std::make_unique<minic::IRProgram>();
     auto irf = std::make_unique<minic::IRFunction>("cmp_test", TokenType::KEYWORD_VOID, std::vector<minic::Parameter> {});
-    irf->blocks.push_back(std::make_unique<minic::BasicBlock>("entry"));
     generator_.current_function_ = irf.get();
-    generator_.current_block_ = irf->blocks[0].get();
+    generator_.current_block_ = irf->add_block("entry");
+    generator_.var_map_["a"] = irf->variable("a");
     generator_.ir_program_->functions.push_back(std::move(irf));
 
     generator_.temp_counter_ = 0;
 
     for (const auto& tc : cases)
     {
-        auto bin = minic::BuildBinary(minic::BuildIntLit(10), tc.token_op, minic::BuildIntLit(2));
+        auto bin = minic::BuildBinary(minic::BuildId("a"), tc.token_op, minic::BuildIntLit(2));
         generator_.generate_expr(*bin);
+        EXPECT_EQ(generator_.current_function_->block_instructions(0).back().opcode, tc.ir_op);
     }
-    EXPECT_GE(generator_.temp_counter_, cases.size() * 3);
+    EXPECT_EQ(generator_.temp_counter_, cases.size());
 }
 
 // Id not mapped error
@@ -699,9 +767,8 @@ TEST_F(IRGeneratorTest, MultipleEmitsAndNestedExpr)
 {
     generator_.ir_program_ = std::make_unique<minic::IRProgram>();
     auto irf = std::make_unique<minic::IRFunction>("nested_test", TokenType::KEYWORD_VOID, std::vector<minic::Parameter> {});
-    irf->blocks.push_back(std::make_unique<minic::BasicBlock>("entry"));
     generator_.current_function_ = irf.get();
-    generator_.current_block_ = irf->blocks[0].get();
+    generator_.current_block_ = irf->add_block("entry");
     generator_.ir_program_->functions.push_back(std::move(irf));
 
     generator_.temp_counter_ = 0;
@@ -710,8 +777,39 @@ TEST_F(IRGeneratorTest, MultipleEmitsAndNestedExpr)
         minic::BuildBinary(minic::BuildIntLit(1), TokenType::OP_PLUS, minic::BuildIntLit(2)),
         TokenType::OP_MULTIPLY,
         minic::BuildIntLit(3));
-    generator_.generate_expr(*nested);
-    EXPECT_EQ(generator_.temp_counter_, 5); // ASSIGNs for 1,2,3 + ADD + MUL
+    EXPECT_EQ(generator_.generate_expr(*nested), IROperand::imm(9));
+    EXPECT_EQ(generator_.temp_counter_, 0); // (1 + 2) * 3 folds completely
+
+    generator_.var_map_["v"] = generator_.current_function_->variable("v");
+    auto partly = minic::BuildBinary(
+        minic::BuildId("v"),
+        TokenType::OP_MULTIPLY,
+        minic::BuildBinary(minic::BuildIntLit(1), TokenType::OP_PLUS, minic::BuildIntLit(2)));
+    generator_.generate_expr(*partly);
+    EXPECT_EQ(generator_.temp_counter_, 1); // MUL v, 3
+    EXPECT_EQ(generator_.current_function_->block_instructions(0).back().operand2, IROperand::imm(3));
+}
+
+TEST_F(IRGeneratorTest, ConstantFoldingUsesTargetSemantics)
+{
+    generator_.ir_program_ = std::make_unique<minic::IRProgram>();
+    auto irf = std::make_unique<minic::IRFunction>("fold_test", TokenType::KEYWORD_VOID, std::vector<minic::Parameter> {});
+    generator_.current_function_ = irf.get();
+    generator_.current_block_ = irf->add_block("entry");
+    generator_.ir_program_->functions.push_back(std::move(irf));
+
+    auto expr = [&](std::unique_ptr<minic::Expr> e) { return generator_.generate_expr(*e); };
+    EXPECT_EQ(expr(minic::BuildBinary(minic::BuildIntLit(-7), TokenType::OP_DIVIDE, minic::BuildIntLit(2))), IROperand::imm(-3));
+    EXPECT_EQ(expr(minic::BuildBinary(minic::BuildIntLit(3), TokenType::OP_LESS_EQ, minic::BuildIntLit(3))), IROperand::imm(1));
+    EXPECT_EQ(expr(minic::BuildUnary(TokenType::OP_NOT, minic::BuildIntLit(5))), IROperand::imm(0));
+    EXPECT_EQ(generator_.temp_counter_, 0);
+
+    // Division by zero traps at run time, and a result outside imm32 is left to the backend.
+    IROperand div = expr(minic::BuildBinary(minic::BuildIntLit(1), TokenType::OP_DIVIDE, minic::BuildIntLit(0)));
+    EXPECT_TRUE(div.is_temp());
+    IROperand big = expr(minic::BuildBinary(minic::BuildIntLit(2000000000), TokenType::OP_PLUS, minic::BuildIntLit(2000000000)));
+    EXPECT_TRUE(big.is_temp());
+    EXPECT_EQ(generator_.temp_counter_, 2);
 }
 
 TEST_F(IRGeneratorTest, ExprDiscardAndVisit)
@@ -720,25 +818,25 @@ TEST_F(IRGeneratorTest, ExprDiscardAndVisit)
 
     generator_.ir_program_ = std::make_unique<minic::IRProgram>();
     auto irf = std::make_unique<minic::IRFunction>("expr_test", TokenType::KEYWORD_VOID, std::vector<minic::Parameter> {});
-    irf->blocks.push_back(std::make_unique<minic::BasicBlock>("entry"));
     generator_.current_function_ = irf.get();
-    generator_.current_block_ = irf->blocks[0].get();
+    generator_.current_block_ = irf->add_block("entry");
     generator_.ir_program_->functions.push_back(std::move(irf));
 
     int prev_temp = generator_.temp_counter_;
     generator_.visit(*expr);
-    EXPECT_EQ(generator_.temp_counter_, prev_temp + 1);
+    EXPECT_EQ(generator_.temp_counter_, prev_temp); // A literal needs no temp
 }
 
 TEST_F(IRGeneratorTest, PrivateCurrentPointers)
 {
-    auto block = std::make_unique<minic::BasicBlock>("private");
-    generator_.current_block_ = block.get();
-    EXPECT_EQ(generator_.current_block_->label, "private");
-
     auto func = std::make_unique<minic::IRFunction>("test", TokenType::KEYWORD_VOID, std::vector<minic::Parameter> {});
     generator_.current_function_ = func.get();
     EXPECT_EQ(generator_.current_function_->name, "test");
+
+    func->add_block("first");
+    generator_.current_block_ = func->add_block("private");
+    EXPECT_EQ(generator_.current_block_, 1);
+    EXPECT_EQ(generator_.current_function_->blocks[generator_.current_block_].label, "private");
 }
 
 TEST_F(IRGeneratorTest, GenerateIRForFullProgram)
@@ -0,0 +1,79 @@
+#include "TestUtils.hpp"
+#include "minic/IRInterpreter.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class IRInterpreterTest : public IRTest
+{
+};
+
+TEST_F(IRInterpreterTest, RunsLoopsAndCountsSteps)
+{
+    const auto& func = Generate("int main(int n) {\n"
+                                "    int f = 1;\n"
+                                "    while (n > 1) { f = f * n; n = n - 1; }\n"
+                                "    return f;\n"
+                                "}\n");
+    IRInterpreter interp;
+    auto small = interp.run(func, { 1 });
+    auto large = interp.run(func, { 5 });
+    EXPECT_EQ(small.value, 1);
+    EXPECT_EQ(large.value, 120);
+    EXPECT_GT(large.steps, small.steps);
+}
+
+TEST_F(IRInterpreterTest, ArithmeticMatchesTheTarget)
+{
+    const auto& func = Generate("int main(int a, int b) {\n"
+                                "    return -a / b + !a * 100 + (a <= b);\n"
+                                "}\n");
+    IRInterpreter interp;
+    EXPECT_EQ(interp.run(func, { 7, 2 }).value, -3);
+    EXPECT_EQ(interp.run(func, { 0, 5 }).value, 101);
+    EXPECT_THROW(interp.run(func, { 1, 0 }), std::runtime_error);
+    EXPECT_THROW(interp.run(func, { 1 }), std::runtime_error);
+}
+
+TEST_F(IRInterpreterTest, CountsCycles)
+{
+    const auto& func = Generate("int main(int a) {\n"
+                                "    return a / 7 + a * 5 + a * 6;\n"
+                                "}\n");
+    // idiv, lea, imul, two adds and the return.
+    auto result = IRInterpreter().run(func, { 14 });
+    EXPECT_EQ(result.value, 2 + 70 + 84);
+    EXPECT_EQ(result.cycles, 40 + 1 + 3 + 1 + 1 + 1);
+}
+
+TEST_F(IRInterpreterTest, CountsBranchesAndSelects)
+{
+    const auto& func = Generate("int main(int n) {\n"
+                                "    while (n > 1) { n = n - 1; }\n"
+                                "    return n;\n"
+                                "}\n");
+    EXPECT_EQ(IRInterpreter().run(func, { 4 }).branches, 4);
+
+    IRFunction select("pick", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "c") });
+    BlockId entry = select.add_block("entry");
+    IROperand r = select.new_temp();
+    select.append(entry, IRInstruction(IROpcode::ASSIGN, r, IROperand::imm(5)));
+    select.append(entry, IRInstruction(IROpcode::SELECT, r, select.variable("c"), IROperand::imm(9)));
+    select.append(entry, IRInstruction(IROpcode::RETURN, {}, r));
+    EXPECT_EQ(IRInterpreter().run(select, { 0 }).value, 5);
+    EXPECT_EQ(IRInterpreter().run(select, { 3 }).value, 9);
+    EXPECT_EQ(IRInterpreter().run(select, { 3 }).branches, 0);
+}
+
+TEST_F(IRInterpreterTest, StepLimit)
+{
+    const auto& func = Generate("int main() {\n"
+                                "    while (1) { }\n"
+                                "    return 0;\n"
+                                "}\n");
+    IRInterpreter interp(1000);
+    EXPECT_THROW(interp.run(func, {}), std::runtime_error);
+}
+
+} // namespace minic
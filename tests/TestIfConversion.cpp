@@ -0,0 +1,154 @@
+#include "TestUtils.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/DCE.hpp"
+#include "minic/IfConversion.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace minic
+{
+
+class IfConversionTest : public IRTest
+{
+protected:
+    // Cleaned up and out of SSA form, as the compiler hands it to the pass.
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        CopyPropagation().run(func);
+        DeadCodeElimination().run(func);
+        SSADestruction().run(func);
+        return func;
+    }
+
+    // Convert and check every input; returns the summed results before and after.
+    RunTotals Convert(IRFunction& func, const Inputs& inputs)
+    {
+        return ExpectPreserved(func, inputs, [](IRFunction& f) {
+            EXPECT_TRUE(IfConversion().run(f));
+            f.compact();
+        });
+    }
+
+    Inputs Pairs()
+    {
+        Inputs inputs;
+        for (std::int64_t a = -3; a <= 3; ++a)
+        {
+            for (std::int64_t b = -3; b <= 3; ++b)
+                inputs.push_back({ a, b });
+        }
+        return inputs;
+    }
+};
+
+TEST_F(IfConversionTest, DiamondBecomesSelect)
+{
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int r = 0;\n"
+                                "    if (a > b) { r = a - b; } else { r = b * 2; }\n"
+                                "    return r;\n"
+                                "}\n");
+    Convert(func, Pairs());
+    EXPECT_EQ(CountBranches(func), 0);
+    EXPECT_EQ(Count(func, IROpcode::SELECT), 1);
+    EXPECT_EQ(func.blocks.size(), 1);
+}
+
+TEST_F(IfConversionTest, IfWithoutElse)
+{
+    // The old value survives on the side that skips the assignment.
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int r = b;\n"
+                                "    if (a < 0) { r = a + 1; }\n"
+                                "    return r * 3;\n"
+                                "}\n");
+    Convert(func, Pairs());
+    EXPECT_EQ(CountBranches(func), 0);
+}
+
+TEST_F(IfConversionTest, NestedDiamondsConvertInsideOut)
+{
+    IRFunction& func = Generate("int main(int x, int hi) {\n"
+                                "    int r = 0;\n"
+                                "    if (x < 0) { r = 0; } else {\n"
+                                "        if (x > hi) { r = hi; } else { r = x; }\n"
+                                "    }\n"
+                                "    return r;\n"
+                                "}\n");
+    Convert(func, Pairs());
+    EXPECT_EQ(CountBranches(func), 0);
+    EXPECT_EQ(Count(func, IROpcode::SELECT), 2);
+}
+
+TEST_F(IfConversionTest, KeepsArmsThatMayTrap)
+{
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int r = 0;\n"
+                                "    if (b != 0) { r = a / b; }\n"
+                                "    return r;\n"
+                                "}\n");
+    EXPECT_FALSE(IfConversion().run(func));
+}
+
+TEST_F(IfConversionTest, KeepsBranchWhenArmsCostMore)
+{
+    // A division costs more than a mispredicted branch, and with no penalty
+    // even a single copy on each side is not worth executing both.
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int r = 0;\n"
+                                "    if (a > b) { r = a / 7; } else { r = b; }\n"
+                                "    return r;\n"
+                                "}\n");
+    EXPECT_FALSE(IfConversion().run(func));
+    IRFunction& cheap = Generate("int main(int a, int b) {\n"
+                                 "    int r = 0;\n"
+                                 "    if (a > b) { r = a; } else { r = b; }\n"
+                                 "    return r;\n"
+                                 "}\n");
+    EXPECT_FALSE(IfConversion(0).run(cheap));
+    EXPECT_TRUE(IfConversion().run(cheap));
+}
+
+TEST_F(IfConversionTest, SelectKeepsItsOldValueAlive)
+{
+    // The copy of the else value into r is what the SELECT keeps when a >= b.
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int x = 0;\n"
+                                "    if (a < b) { x = a; } else { x = b; }\n"
+                                "    return x;\n"
+                                "}\n");
+    Inputs inputs = Pairs();
+    inputs.push_back({ std::numeric_limits<std::int64_t>::max(), 3 });
+    ExpectPreserved(func, inputs, [](IRFunction& f) {
+        EXPECT_TRUE(IfConversion().run(f));
+        DeadCodeElimination().run(f);
+    });
+    EXPECT_EQ(Count(func, IROpcode::SELECT), 1);
+    EXPECT_THROW(SSAConstruction().run(func), std::runtime_error);
+}
+
+TEST_F(IfConversionTest, BenchRunningMaximum)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int m = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int x = i * 37 - (i / 8) * 290;\n"
+                                "        if (x > m) { m = x; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return m;\n"
+                                "}\n");
+    auto [before, after] = Convert(func, { { 1000 } });
+    // Only the loop test is left to predict.
+    std::cout << "[ bench    ] running maximum, n = 1000: " << before.branches << " -> " << after.branches << " branches, "
+              << before.cycles << " -> " << after.cycles << " cycles\n";
+    EXPECT_EQ(after.branches + 1000, before.branches);
+}
+
+} // namespace minic
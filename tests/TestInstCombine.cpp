@@ -0,0 +1,198 @@
+#include "TestUtils.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/InstCombine.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class InstCombineTest : public IRTest
+{
+protected:
+    // Generate IR in SSA form and combine it.
+    IRFunction& Combine(const std::string& source)
+    {
+        IRFunction& func = Generate(source);
+        SSAConstruction().run(func);
+        InstCombine().run(func);
+        func.verify();
+        return func;
+    }
+
+    const IRInstruction* Find(const IRFunction& func, IROpcode op)
+    {
+        for (const auto& block : func.blocks)
+        {
+            for (const auto& instr : func.block_instructions(block))
+            {
+                if (instr.opcode == op)
+                    return &instr;
+            }
+        }
+        return nullptr;
+    }
+
+    // The instruction defining a temp.
+    const IRInstruction* Def(const IRFunction& func, const IROperand& temp)
+    {
+        for (const auto& block : func.blocks)
+        {
+            for (const auto& instr : func.block_instructions(block))
+            {
+                if (!instr.is_terminator() && instr.result == temp)
+                    return &instr;
+            }
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(InstCombineTest, FoldsConstantsThroughTemps)
+{
+    IRFunction& func = Combine("int main() {\n"
+                               "    int x = 4;\n"
+                               "    int y = x * 3;\n"
+                               "    return y + 1;\n"
+                               "}\n");
+    EXPECT_EQ(Count(func, IROpcode::MUL), 0);
+    EXPECT_EQ(Count(func, IROpcode::ADD), 0);
+    EXPECT_EQ(func.terminator(0).operand1, IROperand::imm(13));
+}
+
+TEST_F(InstCombineTest, AlgebraicIdentities)
+{
+    IRFunction& func = Combine("int main(int a) {\n"
+                               "    int x = a * 1 + 0;\n"
+                               "    int y = a - a;\n"
+                               "    int z = (a == a) + 0 - a;\n"
+                               "    return x * 0 + y + z;\n"
+                               "}\n");
+    EXPECT_EQ(Count(func, IROpcode::MUL), 0);
+    EXPECT_EQ(Count(func, IROpcode::EQ), 0);
+    // Only 1 - a survives.
+    EXPECT_EQ(Count(func, IROpcode::ADD) + Count(func, IROpcode::NEG), 0);
+    EXPECT_EQ(Count(func, IROpcode::SUB), 1);
+    EXPECT_EQ(IRInterpreter().run(func, { 5 }).value, -4);
+}
+
+TEST_F(InstCombineTest, ReassociatesConstantChains)
+{
+    IRFunction& func = Combine("int main(int a) {\n"
+                               "    return ((a + 2) - 7) * 3 * 4;\n"
+                               "}\n");
+    // The returned value is (a + -5) * 12; the intermediate steps are left dead.
+    const IRInstruction* mul = Def(func, func.terminator(0).operand1);
+    ASSERT_NE(mul, nullptr);
+    EXPECT_EQ(mul->opcode, IROpcode::MUL);
+    EXPECT_EQ(mul->operand2, IROperand::imm(12));
+    const IRInstruction* add = Def(func, mul->operand1);
+    ASSERT_NE(add, nullptr);
+    EXPECT_EQ(add->opcode, IROpcode::ADD);
+    EXPECT_EQ(add->operand1, IROperand::var(0));
+    EXPECT_EQ(add->operand2, IROperand::imm(-5));
+    EXPECT_EQ(Count(func, IROpcode::SUB), 0);
+    EXPECT_EQ(IRInterpreter().run(func, { 10 }).value, 60);
+}
+
+TEST_F(InstCombineTest, CanonicalizesImmediatesToTheRight)
+{
+    IRFunction& func = Combine("int main(int a) {\n"
+                               "    return (3 < a) + 5 * a;\n"
+                               "}\n");
+    const IRInstruction* cmp = Find(func, IROpcode::GT);
+    ASSERT_NE(cmp, nullptr);
+    EXPECT_EQ(cmp->operand1, IROperand::var(0));
+    EXPECT_EQ(cmp->operand2, IROperand::imm(3));
+    EXPECT_EQ(Find(func, IROpcode::MUL)->operand2, IROperand::imm(5));
+    EXPECT_EQ(Count(func, IROpcode::LT), 0);
+}
+
+TEST_F(InstCombineTest, NegatedConditionsFold)
+{
+    IRFunction& func = Combine("int main(int a) {\n"
+                               "    if (!(a < 3)) { return -(-a); }\n"
+                               "    return 2;\n"
+                               "}\n");
+    EXPECT_EQ(Count(func, IROpcode::NOT), 0);
+    EXPECT_EQ(Count(func, IROpcode::GE), 1);
+    BlockId then_block = func.terminator(0).result.value;
+    const IRInstruction* ret = Def(func, func.terminator(then_block).operand1);
+    ASSERT_NE(ret, nullptr);
+    EXPECT_EQ(ret->opcode, IROpcode::ASSIGN);
+    EXPECT_EQ(ret->operand1, IROperand::var(0));
+    IRInterpreter interp;
+    EXPECT_EQ(interp.run(func, { 1 }).value, 2);
+    EXPECT_EQ(interp.run(func, { 7 }).value, 7);
+}
+
+TEST_F(InstCombineTest, ConstantBranchBecomesJump)
+{
+    IRFunction& func = Combine("int main(int a) {\n"
+                               "    int x = a;\n"
+                               "    int c = 2;\n"
+                               "    if (c > 1) { x = 10; } else { x = 20; }\n"
+                               "    return x;\n"
+                               "}\n");
+    EXPECT_EQ(func.terminator(0).opcode, IROpcode::JUMP);
+    EXPECT_EQ(func.operand_name(func.terminator(0).operand1).find("if_then"), 0);
+    EXPECT_EQ(IRInterpreter().run(func, { 0 }).value, 10);
+}
+
+TEST_F(InstCombineTest, FoldedBranchDropsPhiEntry)
+{
+    IRFunction func("main", TokenType::KEYWORD_INT, {});
+    BlockId entry = func.add_block("entry");
+    BlockId other = func.add_block("other");
+    BlockId join = func.add_block("join");
+    IROperand value = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::JUMPIF, IROperand::block(other), IROperand::imm(0), IROperand::block(join)));
+    func.append(other, IRInstruction(IROpcode::JUMP, {}, IROperand::block(join)));
+    func.blocks[join].phis.push_back({ value, { { entry, IROperand::imm(1) }, { other, IROperand::imm(2) } } });
+    func.append(join, IRInstruction(IROpcode::RETURN, {}, value));
+
+    EXPECT_TRUE(InstCombine().run(func));
+    EXPECT_EQ(func.terminator(entry).opcode, IROpcode::JUMP);
+    EXPECT_EQ(func.terminator(entry).operand1, IROperand::block(other));
+    ASSERT_EQ(func.blocks[join].phis[0].incoming.size(), 1);
+    EXPECT_EQ(func.blocks[join].phis[0].incoming[0].block, other);
+    EXPECT_EQ(IRInterpreter().run(func, {}).value, 2);
+}
+
+TEST_F(InstCombineTest, TrappingDivisionIsKept)
+{
+    IRFunction& func = Combine("int main(int a) {\n"
+                               "    int z = 0;\n"
+                               "    return a / z + a / 1;\n"
+                               "}\n");
+    EXPECT_EQ(Count(func, IROpcode::DIV), 1);
+    EXPECT_THROW(IRInterpreter().run(func, { 4 }), std::runtime_error);
+}
+
+TEST_F(InstCombineTest, PreservesResultsOutsideSSA)
+{
+    // The pass also runs on IR straight from the generator, where variables are still written.
+    const std::string source = "int main(int n) {\n"
+                               "    int s = 0;\n"
+                               "    int k = 3;\n"
+                               "    while (n > 0) {\n"
+                               "        s = s + (k * 2 - 6) + n * 1;\n"
+                               "        k = k + 1;\n"
+                               "        n = n - 1;\n"
+                               "    }\n"
+                               "    return s - 0;\n"
+                               "}\n";
+    IRFunction& func = Generate(source);
+
+    IRInterpreter interp;
+    auto before = interp.run(func, { 6 });
+    InstCombine().run(func);
+    func.verify();
+    auto after = interp.run(func, { 6 });
+    EXPECT_EQ(after.value, before.value);
+    EXPECT_LE(after.steps, before.steps);
+    // k is written in the loop, so k * 2 - 6 must not be folded.
+    EXPECT_EQ(Count(func, IROpcode::MUL), 1);
+}
+
+} // namespace minic
@@ -0,0 +1,135 @@
+#include "TestUtils.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/DCE.hpp"
+#include "minic/JumpThreading.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+namespace minic
+{
+
+class JumpThreadingTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        return func;
+    }
+
+    // Thread, clean up and check every input; returns the summed step counts
+    // out of SSA before and after.
+    std::pair<std::uint64_t, std::uint64_t> Thread(IRFunction& func, JumpThreading pass, const Inputs& inputs)
+    {
+        auto [before, after] = ExpectPreservedInSSA(func, inputs, [&](IRFunction& f) {
+            EXPECT_TRUE(pass.run(f));
+            f.verify();
+            CopyPropagation().run(f);
+            DeadCodeElimination().run(f);
+            f.compact();
+        });
+        return { before.steps, after.steps };
+    }
+
+    Inputs Range(std::int64_t from, std::int64_t to)
+    {
+        Inputs inputs;
+        for (std::int64_t x = from; x <= to; ++x)
+            inputs.push_back({ x });
+        return inputs;
+    }
+};
+
+TEST_F(JumpThreadingTest, ThreadsFlagSetByPredecessor)
+{
+    IRFunction& func = Generate("int main(int x) {\n"
+                                "    int flag = 0;\n"
+                                "    int r = x;\n"
+                                "    if (x > 3) { flag = 1; r = r * 2; }\n"
+                                "    if (flag) { r = r + 10; } else { r = r - 1; }\n"
+                                "    return r;\n"
+                                "}\n");
+    Thread(func, JumpThreading(), Range(0, 7));
+    // The test of the flag is gone from both paths.
+    EXPECT_EQ(CountBranches(func), 1);
+}
+
+TEST_F(JumpThreadingTest, ThreadsRepeatedComparison)
+{
+    IRFunction& func = Generate("int main(int x) {\n"
+                                "    int a = 0;\n"
+                                "    if (x > 0) { a = x * 3; } else { a = 5; }\n"
+                                "    int r = 0;\n"
+                                "    if (x > 0) { r = a + 1; } else { r = a - 1; }\n"
+                                "    return r;\n"
+                                "}\n");
+    Thread(func, JumpThreading(), Range(-3, 3));
+    EXPECT_EQ(CountBranches(func), 1);
+}
+
+TEST_F(JumpThreadingTest, ThreadsImpliedComparison)
+{
+    // x >= 5 is false wherever x < 5 held, and true on the other side.
+    IRFunction& func = Generate("int main(int x, int y) {\n"
+                                "    int r = y;\n"
+                                "    if (x < 5) { r = r + 1; }\n"
+                                "    if (x >= 5) { r = r * 3; } else { r = r - 7; }\n"
+                                "    if (5 > x) { r = r + 100; }\n"
+                                "    return r;\n"
+                                "}\n");
+    Inputs inputs;
+    for (std::int64_t x = 2; x <= 8; ++x)
+        inputs.push_back({ x, x * 11 });
+    Thread(func, JumpThreading(), inputs);
+    EXPECT_EQ(CountBranches(func), 1);
+}
+
+TEST_F(JumpThreadingTest, KeepsUnknownConditions)
+{
+    IRFunction& func = Generate("int main(int x, int y) {\n"
+                                "    int r = 0;\n"
+                                "    if (x > 0) { r = 1; }\n"
+                                "    if (y > 0) { r = r + 2; }\n"
+                                "    if (x > 1) { r = r + 4; }\n"
+                                "    return r;\n"
+                                "}\n");
+    size_t branches = CountBranches(func);
+    EXPECT_FALSE(JumpThreading().run(func));
+    EXPECT_EQ(CountBranches(func), branches);
+}
+
+TEST_F(JumpThreadingTest, RespectsBudget)
+{
+    IRFunction& func = Generate("int main(int x) {\n"
+                                "    int flag = 0;\n"
+                                "    if (x > 3) { flag = 1; }\n"
+                                "    if (flag) { x = x + 10; }\n"
+                                "    return x;\n"
+                                "}\n");
+    size_t branches = CountBranches(func);
+    EXPECT_FALSE(JumpThreading(0).run(func));
+    EXPECT_EQ(CountBranches(func), branches);
+}
+
+TEST_F(JumpThreadingTest, BenchFlagInLoop)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int big = 0;\n"
+                                "        if (i > 500) { big = 1; }\n"
+                                "        if (big) { s = s + i; } else { s = s - 1; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    auto [before, after] = Thread(func, JumpThreading(), { { 0 }, { 1000 } });
+    // Each iteration jumps past the test of the flag.
+    std::cout << "[ bench    ] flag tested in loop, n = 1000: " << before << " -> " << after << " steps\n";
+    EXPECT_LT(after + 900, before);
+}
+
+} // namespace minic
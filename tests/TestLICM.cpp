@@ -0,0 +1,89 @@
+#include "TestUtils.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/LICM.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class LICMTest : public IRTest
+{
+protected:
+    // Run LICM and check results; returns the step counts before and after.
+    std::pair<std::uint64_t, std::uint64_t> Hoist(IRFunction& func, const std::vector<std::int64_t>& args)
+    {
+        auto [before, after] = ExpectPreserved(func, { args }, [](IRFunction& f) { EXPECT_TRUE(LICM().run(f)); });
+        return { before.steps, after.steps };
+    }
+};
+
+TEST_F(LICMTest, HoistsInvariantBoundComputation)
+{
+    IRFunction& func = Generate("int main(int n, int k) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n * k + 1) { s = s + k * 3; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    auto [before, after] = Hoist(func, { 5, 2 });
+    EXPECT_EQ(CountInLoops(func, IROpcode::MUL), 0);
+    // The add to s and the increment of i stay in the loop.
+    EXPECT_EQ(CountInLoops(func, IROpcode::ADD), 2);
+    EXPECT_LT(after, before);
+}
+
+TEST_F(LICMTest, HoistsOutOfNestedLoops)
+{
+    IRFunction& func = Generate("int main(int n, int a) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int j = 0;\n"
+                                "        while (j < n) { s = s + (a * a - 1); j = j + 1; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    Hoist(func, { 4, 3 });
+    EXPECT_EQ(CountInLoops(func, IROpcode::MUL), 0);
+    EXPECT_EQ(CountInLoops(func, IROpcode::SUB), 0);
+}
+
+TEST_F(LICMTest, KeepsVariantAndTrappingInstructions)
+{
+    IRFunction& func = Generate("int main(int n, int d) {\n"
+                                "    int s = 0;\n"
+                                "    while (n > 0) { s = s + 100 / d + n * 2; n = n - 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    IRInterpreter interp;
+    std::int64_t expected = interp.run(func, { 3, 5 }).value;
+    LICM().run(func);
+    func.verify();
+    // 100 / d could trap, and n * 2 changes every iteration.
+    EXPECT_EQ(CountInLoops(func, IROpcode::DIV), 1);
+    EXPECT_EQ(CountInLoops(func, IROpcode::MUL), 1);
+    EXPECT_EQ(interp.run(func, { 3, 5 }).value, expected);
+    // The loop does not run, so the division must not either.
+    EXPECT_EQ(interp.run(func, { 0, 0 }).value, 0);
+}
+
+TEST_F(LICMTest, WorksOutsideSSA)
+{
+    // Straight from the generator: k is never written in the loop, s and i are.
+    IRFunction& func = Generate("int main(int n, int k) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + (k + 4) * i; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    Hoist(func, { 6, 1 });
+    EXPECT_EQ(CountInLoops(func, IROpcode::ADD), 2);
+    EXPECT_EQ(CountInLoops(func, IROpcode::MUL), 1);
+}
+
+} // namespace minic
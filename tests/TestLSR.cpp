@@ -0,0 +1,104 @@
+#include "TestUtils.hpp"
+#include "minic/LSR.hpp"
+#include "minic/Loops.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class LSRTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        return func;
+    }
+
+    // Run the pass and check the function still computes the same values.
+    void Reduce(IRFunction& func, const Inputs& inputs)
+    {
+        ExpectPreserved(func, inputs, [](IRFunction& f) { EXPECT_TRUE(LoopStrengthReduction().run(f)); });
+    }
+
+    size_t CountHeaderPhis(const IRFunction& func)
+    {
+        ControlFlowGraph cfg(func);
+        LoopInfo info(cfg);
+        return func.blocks[info.loops()[0].header].phis.size();
+    }
+};
+
+TEST_F(LSRTest, FindsBasicInductionVariables)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 2;\n"
+                                "    while (i < n) { s = s + i; i = i + 3; }\n"
+                                "    return s;\n"
+                                "}\n");
+    ensure_preheaders(func);
+    ControlFlowGraph cfg(func);
+    LoopInfo info(cfg);
+    auto ivs = find_induction_variables(func, cfg, info.loops()[0]);
+    // s grows by a varying amount, so only i qualifies.
+    ASSERT_EQ(ivs.size(), 1);
+    EXPECT_EQ(ivs[0].init, IROperand::imm(2));
+    EXPECT_EQ(ivs[0].step, 3);
+}
+
+TEST_F(LSRTest, ReducesMultiplicationByConstant)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i * 12; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    Reduce(func, { { 0 }, { 1 }, { 10 } });
+    EXPECT_EQ(CountInLoops(func, IROpcode::MUL), 0);
+}
+
+TEST_F(LSRTest, ReducesMultiplicationByInvariant)
+{
+    IRFunction& func = Generate("int main(int n, int k) {\n"
+                                "    int s = 0;\n"
+                                "    int i = n;\n"
+                                "    while (i > 0) { s = s + k * i + i * k; i = i - 2; }\n"
+                                "    return s;\n"
+                                "}\n");
+    Reduce(func, { { 0, 3 }, { 7, 3 }, { 8, -5 } });
+    EXPECT_EQ(CountInLoops(func, IROpcode::MUL), 0);
+    // Both products share one reduced variable: i, s and k * i.
+    EXPECT_EQ(CountHeaderPhis(func), 3);
+}
+
+TEST_F(LSRTest, EliminatesLockstepCounter)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    int j = 5;\n"
+                                "    while (i < n) { s = s + j; i = i + 1; j = j + 1; }\n"
+                                "    return s + j;\n"
+                                "}\n");
+    EXPECT_EQ(CountHeaderPhis(func), 3);
+    Reduce(func, { { 0 }, { 4 } });
+    EXPECT_EQ(CountHeaderPhis(func), 2);
+}
+
+TEST_F(LSRTest, KeepsNonAffineProducts)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i * i + s * 2; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    EXPECT_FALSE(LoopStrengthReduction().run(func));
+    EXPECT_EQ(CountInLoops(func, IROpcode::MUL), 2);
+}
+
+} // namespace minic
@@ -0,0 +1,145 @@
+#include "TestUtils.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/DCE.hpp"
+#include "minic/LoopFusion.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+namespace minic
+{
+
+class LoopFusionTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        return func;
+    }
+
+    // Fuse, clean up and check every input; returns the summed step counts out
+    // of SSA before and after.
+    std::pair<std::uint64_t, std::uint64_t> Fuse(IRFunction& func, const Inputs& inputs)
+    {
+        auto [before, after] = ExpectPreservedInSSA(func, inputs, [](IRFunction& f) {
+            EXPECT_TRUE(LoopFusion().run(f));
+            f.verify();
+            CopyPropagation().run(f);
+            DeadCodeElimination().run(f);
+            f.compact();
+        });
+        return { before.steps, after.steps };
+    }
+
+    Inputs Counts(std::int64_t from, std::int64_t to)
+    {
+        Inputs inputs;
+        for (std::int64_t n = from; n <= to; ++n)
+            inputs.push_back({ n, 3 });
+        return inputs;
+    }
+};
+
+TEST_F(LoopFusionTest, FusesLoopsOverSameBounds)
+{
+    IRFunction& func = Generate("int main(int n, int a) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i * a; i = i + 1; }\n"
+                                "    int t = 1;\n"
+                                "    int j = 0;\n"
+                                "    while (j < n) { if (j > 2) { t = t * 2; } j = j + 1; }\n"
+                                "    return s * 1000 + t + i * j;\n"
+                                "}\n");
+    Fuse(func, Counts(-2, 8));
+    EXPECT_EQ(CountLoops(func), 1);
+}
+
+TEST_F(LoopFusionTest, MovesCodeBetweenLoops)
+{
+    IRFunction& func = Generate("int main(int n, int a) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i; i = i + 1; }\n"
+                                "    int k = a * 7;\n"
+                                "    int t = 0;\n"
+                                "    int j = 0;\n"
+                                "    while (j < n) { t = t + k; j = j + 1; }\n"
+                                "    return s - t;\n"
+                                "}\n");
+    Fuse(func, Counts(-1, 5));
+    EXPECT_EQ(CountLoops(func), 1);
+}
+
+TEST_F(LoopFusionTest, FusesChainOfLoops)
+{
+    IRFunction& func = Generate("int main(int n, int a) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i; i = i + 1; }\n"
+                                "    int t = 0;\n"
+                                "    i = 0;\n"
+                                "    while (i < n) { t = t - a; i = i + 1; }\n"
+                                "    int u = 1;\n"
+                                "    i = 0;\n"
+                                "    while (i < n) { u = u * 3; i = i + 1; }\n"
+                                "    return s + t * 100 + u * 10000;\n"
+                                "}\n");
+    Fuse(func, Counts(0, 6));
+    EXPECT_EQ(CountLoops(func), 1);
+}
+
+TEST_F(LoopFusionTest, KeepsDependentLoops)
+{
+    // The second loop reads the first one's result.
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i; i = i + 1; }\n"
+                                "    int t = 0;\n"
+                                "    int j = 0;\n"
+                                "    while (j < n) { t = t + s; j = j + 1; }\n"
+                                "    return t;\n"
+                                "}\n");
+    EXPECT_FALSE(LoopFusion().run(func));
+    EXPECT_EQ(CountLoops(func), 2);
+}
+
+TEST_F(LoopFusionTest, KeepsLoopsWithDifferentTripCounts)
+{
+    IRFunction& func = Generate("int main(int n, int m) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i; i = i + 1; }\n"
+                                "    int t = 0;\n"
+                                "    int j = 0;\n"
+                                "    while (j < m) { t = t + j; j = j + 1; }\n"
+                                "    int u = 0;\n"
+                                "    int k = 1;\n"
+                                "    while (k < m) { u = u + k; k = k + 1; }\n"
+                                "    return s + t + u;\n"
+                                "}\n");
+    EXPECT_FALSE(LoopFusion().run(func));
+    EXPECT_EQ(CountLoops(func), 3);
+}
+
+TEST_F(LoopFusionTest, BenchTwoLoopsOverSameBound)
+{
+    IRFunction& func = Generate("int main(int n, int a) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i * a; i = i + 1; }\n"
+                                "    int t = 0;\n"
+                                "    int j = 0;\n"
+                                "    while (j < n) { t = t + j; j = j + 1; }\n"
+                                "    return s - t;\n"
+                                "}\n");
+    auto [before, after] = Fuse(func, { { 1000, 3 } });
+    // One branch and back jump per iteration instead of two.
+    std::cout << "[ bench    ] two loops, n = 1000: " << before << " -> " << after << " steps\n";
+    EXPECT_LT(after + 1500, before);
+}
+
+} // namespace minic
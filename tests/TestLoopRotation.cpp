@@ -0,0 +1,142 @@
+#include "TestUtils.hpp"
+#include "minic/GVN.hpp"
+#include "minic/LoopRotation.hpp"
+#include "minic/Loops.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+namespace minic
+{
+
+class LoopRotationTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        return func;
+    }
+
+    // Rotate and check every input in SSA form and after SSADestruction; returns
+    // the summed step counts out of SSA without and with rotation.
+    std::pair<std::uint64_t, std::uint64_t> Rotate(IRFunction& func, LoopRotation pass, const Inputs& inputs)
+    {
+        auto [before, after] = ExpectPreservedInSSA(func, inputs, [&](IRFunction& f) {
+            EXPECT_TRUE(pass.run(f));
+            f.verify();
+            ExpectRotated(f);
+        });
+        return { before.steps, after.steps };
+    }
+
+    // Every loop is left from its latch, which branches back to the header.
+    void ExpectRotated(const IRFunction& func)
+    {
+        ControlFlowGraph cfg(func);
+        LoopInfo loops(cfg);
+        for (const auto& loop : loops.loops())
+        {
+            ASSERT_EQ(loop.latches.size(), 1);
+            const IRInstruction& back = func.terminator(loop.latches[0]);
+            EXPECT_EQ(back.opcode, IROpcode::JUMPIF);
+            EXPECT_EQ(back.operand2, IROperand::block(loop.header));
+        }
+    }
+};
+
+TEST_F(LoopRotationTest, RotatesCountingLoop)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i; i = i + 1; }\n"
+                                "    return s + i;\n"
+                                "}\n");
+    Inputs inputs;
+    for (std::int64_t n = -2; n <= 6; ++n)
+        inputs.push_back({ n });
+    Rotate(func, LoopRotation(), inputs);
+    EXPECT_EQ(CountLoops(func), 1);
+    // The entry now decides whether the loop runs at all.
+    EXPECT_NE(func.terminator(0).opcode, IROpcode::JUMP);
+}
+
+TEST_F(LoopRotationTest, HeaderValuesReachBodyAndExit)
+{
+    // After GVN the body and the return reuse the header's i * 3.
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i * 3 < n) { s = s + i * 3; i = i + 1; }\n"
+                                "    return s * 100 + i * 3;\n"
+                                "}\n");
+    GVN().run(func);
+    Inputs inputs;
+    for (std::int64_t n = -1; n <= 10; ++n)
+        inputs.push_back({ n });
+    Rotate(func, LoopRotation(), inputs);
+}
+
+TEST_F(LoopRotationTest, SwappedValues)
+{
+    // a and b swap every iteration: the latch feeds each phi the other one.
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int a = 1;\n"
+                                "    int b = 2;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { int t = a; a = b; b = t; i = i + 1; }\n"
+                                "    return a * 10 + b;\n"
+                                "}\n");
+    Rotate(func, LoopRotation(), { { 0 }, { 1 }, { 2 }, { 7 } });
+}
+
+TEST_F(LoopRotationTest, RotatesNestedLoops)
+{
+    IRFunction& func = Generate("int main(int n, int m) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int j = i;\n"
+                                "        while (j < m) { if (j > 2) { s = s + j; } else { s = s - i; } j = j + 1; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    Inputs inputs;
+    for (std::int64_t n = 0; n <= 4; ++n)
+    {
+        for (std::int64_t m = -1; m <= 5; ++m)
+            inputs.push_back({ n, m });
+    }
+    Rotate(func, LoopRotation(), inputs);
+    EXPECT_EQ(CountLoops(func), 2);
+}
+
+TEST_F(LoopRotationTest, SkipsLargeHeaders)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int i = 0;\n"
+                                "    while (i * i < n) { i = i + 1; }\n"
+                                "    return i;\n"
+                                "}\n");
+    EXPECT_FALSE(LoopRotation(1).run(func));
+    EXPECT_EQ(func.terminator(0).opcode, IROpcode::JUMP);
+}
+
+TEST_F(LoopRotationTest, BenchTightCountingLoop)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i * 3; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    auto [before, after] = Rotate(func, LoopRotation(), { { 1000 } });
+    // One branch per iteration instead of a test at the top and a jump back.
+    std::cout << "[ bench    ] counting loop, n = 1000: " << before << " -> " << after << " steps\n";
+    EXPECT_LT(after, before - 900);
+}
+
+} // namespace minic
@@ -0,0 +1,142 @@
+#include "TestUtils.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/DCE.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/LoopUnroll.hpp"
+#include "minic/SCCP.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <limits>
+
+namespace minic
+{
+
+class LoopUnrollTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        return func;
+    }
+
+    // Unroll, clean up and check every input; returns the summed step counts before and after.
+    std::pair<std::uint64_t, std::uint64_t> Unroll(IRFunction& func, LoopUnroll pass, const Inputs& inputs)
+    {
+        auto [before, after] = ExpectPreserved(func, inputs, [&](IRFunction& f) {
+            EXPECT_TRUE(pass.run(f));
+            f.verify();
+            CopyPropagation().run(f);
+            DeadCodeElimination().run(f);
+            f.compact();
+        });
+        return { before.steps, after.steps };
+    }
+};
+
+TEST_F(LoopUnrollTest, FullyUnrollsConstantTripCount)
+{
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < 5) { s = s * a + i; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    Unroll(func, LoopUnroll(), { { 0 }, { 3 }, { -7 } });
+    EXPECT_EQ(CountLoops(func), 0);
+}
+
+TEST_F(LoopUnrollTest, UnrollsWithRemainderLoop)
+{
+    IRFunction& func = Generate("int main(int n, int a) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s * a + i; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    // Trip counts on both sides of multiples of the factor.
+    Inputs inputs;
+    for (std::int64_t n = -1; n <= 10; ++n)
+        inputs.push_back({ n, 3 });
+    Unroll(func, LoopUnroll(4), inputs);
+    // The unrolled loop plus the original as remainder.
+    EXPECT_EQ(CountLoops(func), 2);
+}
+
+TEST_F(LoopUnrollTest, GuardsBoundNearOverflow)
+{
+    // With n close to the minimum, n - 3 * step would wrap; the original loop must handle it.
+    IRFunction& func = Generate("int main(int n, int start) {\n"
+                                "    int s = 0;\n"
+                                "    int i = start;\n"
+                                "    while (i > n) { s = s + i; i = i - 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    std::int64_t min = std::numeric_limits<std::int64_t>::min();
+    Unroll(func, LoopUnroll(4), { { 0, 9 }, { 5, 5 }, { -3, 2 }, { min, min + 2 }, { min + 1, min + 7 } });
+}
+
+TEST_F(LoopUnrollTest, GuardsWithBoundSolvedInLoop)
+{
+    // `b = b;` turns the bound into a header phi; the guard must read its value from before the loop.
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    if ((-8)) {\n"
+                                "        int i3 = 1;\n"
+                                "        while (i3 <= b) { b = b; i3 = i3 + 3; }\n"
+                                "    }\n"
+                                "}\n");
+    EXPECT_TRUE(LoopUnroll().run(func));
+    // SCCP deleted both targets of a guard reading an undefined value.
+    SCCP().run(func);
+    func.verify();
+    IRInterpreter interp;
+    for (std::int64_t b : { -1, 1, 9, 40 })
+        EXPECT_EQ(interp.run(func, { 0, b }).value, 0) << "b = " << b;
+}
+
+TEST_F(LoopUnrollTest, UnrollsBodiesWithBranches)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 1;\n"
+                                "    while (i <= n) {\n"
+                                "        if (i > 3) { s = s + i; } else { s = s - 1; }\n"
+                                "        i = i + 2;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    Inputs inputs;
+    for (std::int64_t n = 0; n <= 20; ++n)
+        inputs.push_back({ n });
+    Unroll(func, LoopUnroll(3, 200), inputs);
+}
+
+TEST_F(LoopUnrollTest, RespectsBudget)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i * i; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    EXPECT_FALSE(LoopUnroll(8, 6).run(func));
+    EXPECT_EQ(CountLoops(func), 1);
+}
+
+TEST_F(LoopUnrollTest, BenchTightCountingLoop)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i * 3; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    auto [before, after] = Unroll(func, LoopUnroll(4), { { 1000 } });
+    // Per iteration the compare, the branch and the back jump are mostly gone.
+    std::cout << "[ bench    ] counting loop, n = 1000: " << before << " -> " << after << " steps\n";
+    EXPECT_LT(after * 10, before * 7);
+}
+
+} // namespace minic
@@ -0,0 +1,118 @@
+#include "TestUtils.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/Loops.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class LoopsTest : public IRTest
+{
+};
+
+TEST_F(LoopsTest, FindsNestedWhileLoops)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int j = 0;\n"
+                                "        while (j < i) { s = s + j; j = j + 1; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    ControlFlowGraph cfg(func);
+    LoopInfo info(cfg);
+    ASSERT_EQ(info.loops().size(), 2);
+
+    const Loop& outer = info.loops()[0];
+    const Loop& inner = info.loops()[1];
+    BlockId outer_cond = FindBlock(func, "while_cond");
+    BlockId inner_cond = FindBlock(func, "while_cond", 1);
+    EXPECT_EQ(outer.header, outer_cond);
+    EXPECT_EQ(inner.header, inner_cond);
+    EXPECT_EQ(outer.parent, -1);
+    EXPECT_EQ(outer.depth, 1);
+    EXPECT_EQ(inner.parent, 0);
+    EXPECT_EQ(inner.depth, 2);
+    EXPECT_TRUE(outer.contains(inner_cond));
+    EXPECT_FALSE(inner.contains(outer_cond));
+    EXPECT_EQ(info.loop_of(inner_cond), 1);
+    EXPECT_EQ(info.loop_of(0), -1);
+
+    ASSERT_EQ(inner.latches.size(), 1);
+    EXPECT_EQ(inner.latches[0], FindBlock(func, "while_body", 1));
+    ASSERT_EQ(inner.exits.size(), 1);
+    // The inner loop's end block is created first, while the outer body is still open.
+    EXPECT_EQ(inner.exits[0], FindBlock(func, "while_end"));
+    ASSERT_EQ(outer.exits.size(), 1);
+    EXPECT_EQ(outer.exits[0], FindBlock(func, "while_end", 1));
+}
+
+TEST_F(LoopsTest, StraightLineCodeHasNoLoops)
+{
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    if (a) { return 1; }\n"
+                                "    return 2;\n"
+                                "}\n");
+    ControlFlowGraph cfg(func);
+    EXPECT_TRUE(LoopInfo(cfg).loops().empty());
+}
+
+TEST_F(LoopsTest, ExistingPreheaderIsReused)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    while (n > 0) { n = n - 1; }\n"
+                                "    return n;\n"
+                                "}\n");
+    ControlFlowGraph cfg(func);
+    LoopInfo info(cfg);
+    size_t blocks = func.blocks.size();
+    EXPECT_EQ(ensure_preheader(func, cfg, info.loops()[0]), 0);
+    EXPECT_EQ(func.blocks.size(), blocks);
+}
+
+TEST_F(LoopsTest, PreheaderMergesEnteringEdges)
+{
+    // The loop is entered from both arms of the if, with different values of x.
+    IRFunction func("main", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "c") });
+    BlockId entry = func.add_block("entry");
+    BlockId left = func.add_block("left");
+    BlockId header = func.add_block("header");
+    BlockId body = func.add_block("body");
+    BlockId exit = func.add_block("exit");
+    IROperand x = func.new_temp();
+    IROperand next = func.new_temp();
+    IROperand cond = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::JUMPIF, IROperand::block(header), IROperand::var(0), IROperand::block(left)));
+    func.append(left, IRInstruction(IROpcode::JUMP, {}, IROperand::block(header)));
+    func.blocks[header].phis.push_back({ x, { { entry, IROperand::imm(10) }, { left, IROperand::imm(20) }, { body, next } } });
+    func.append(header, IRInstruction(IROpcode::LT, cond, x, IROperand::imm(25)));
+    func.append(header, IRInstruction(IROpcode::JUMPIF, IROperand::block(exit), cond, IROperand::block(body)));
+    func.append(body, IRInstruction(IROpcode::ADD, next, x, IROperand::imm(7)));
+    func.append(body, IRInstruction(IROpcode::JUMP, {}, IROperand::block(header)));
+    func.append(exit, IRInstruction(IROpcode::RETURN, {}, x));
+    func.verify();
+    IRInterpreter interp;
+    std::int64_t zero = interp.run(func, { 0 }).value;
+    std::int64_t one = interp.run(func, { 1 }).value;
+
+    ControlFlowGraph cfg(func);
+    LoopInfo info(cfg);
+    BlockId pre = ensure_preheader(func, cfg, info.loops()[0]);
+    func.verify();
+    EXPECT_EQ(pre, 5);
+    EXPECT_EQ(func.terminator(entry).result, IROperand::block(pre));
+    EXPECT_EQ(func.terminator(left).operand1, IROperand::block(pre));
+    ASSERT_EQ(func.blocks[pre].phis.size(), 1);
+    EXPECT_EQ(func.blocks[pre].phis[0].incoming.size(), 2);
+    EXPECT_EQ(func.blocks[header].phis[0].incoming.size(), 2);
+
+    ControlFlowGraph after(func);
+    EXPECT_EQ(after.predecessors(header).size(), 2);
+    EXPECT_EQ(interp.run(func, { 0 }).value, zero);
+    EXPECT_EQ(interp.run(func, { 1 }).value, one);
+}
+
+} // namespace minic
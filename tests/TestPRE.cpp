@@ -0,0 +1,144 @@
+#include "TestUtils.hpp"
+#include "minic/CFG.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/DCE.hpp"
+#include "minic/GVN.hpp"
+#include "minic/PRE.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+namespace minic
+{
+
+class PRETest : public IRTest
+{
+protected:
+    // SSA form with full redundancies already gone, as in the compiler.
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        GVN().run(func);
+        return func;
+    }
+
+    // Eliminate, clean up and check every input; returns the summed cycle
+    // estimates out of SSA (where phis become copies) before and after.
+    std::pair<std::uint64_t, std::uint64_t> Eliminate(IRFunction& func, const Inputs& inputs)
+    {
+        auto [before, after] = ExpectPreservedInSSA(func, inputs, [](IRFunction& f) {
+            EXPECT_TRUE(PartialRedundancyElimination().run(f));
+            f.verify();
+            CopyPropagation().run(f);
+            DeadCodeElimination().run(f);
+            f.compact();
+        });
+        return { before.cycles, after.cycles };
+    }
+
+    Inputs Triples()
+    {
+        Inputs inputs;
+        for (std::int64_t c = -1; c <= 1; ++c)
+        {
+            for (std::int64_t a = -2; a <= 2; ++a)
+                inputs.push_back({ c, a, 7 - a });
+        }
+        return inputs;
+    }
+};
+
+TEST_F(PRETest, MovesIntoOtherArmOfIf)
+{
+    // a * b is computed on the then side and again after the join.
+    IRFunction& func = Generate("int main(int c, int a, int b) {\n"
+                                "    int r = 0;\n"
+                                "    if (c > 0) { r = a * b; } else { r = 1; }\n"
+                                "    return r + a * b;\n"
+                                "}\n");
+    Eliminate(func, Triples());
+    // One multiplication per arm, none in the join.
+    EXPECT_EQ(Count(func, IROpcode::MUL), 2);
+    ControlFlowGraph cfg(func);
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (cfg.predecessors(id).size() > 1)
+        {
+            for (const auto& instr : func.block_instructions(id))
+                EXPECT_NE(instr.opcode, IROpcode::MUL);
+        }
+    }
+}
+
+TEST_F(PRETest, SplitsCriticalEdge)
+{
+    // Without an else branch the missing computation goes on the edge that skips the then side.
+    IRFunction& func = Generate("int main(int c, int a, int b) {\n"
+                                "    int r = 0;\n"
+                                "    if (c) { r = a - b; }\n"
+                                "    int s = a - b;\n"
+                                "    return r * 100 + s;\n"
+                                "}\n");
+    Eliminate(func, Triples());
+    EXPECT_EQ(Count(func, IROpcode::SUB), 2);
+}
+
+TEST_F(PRETest, KeepsComputationsLate)
+{
+    // The product is anticipated in the entry already, but computing it there
+    // would only make its live range longer than placing it in each arm.
+    IRFunction& func = Generate("int main(int c, int a, int b) {\n"
+                                "    int r = 0;\n"
+                                "    if (c > 0) { r = a * b + 1; } else { r = 5; }\n"
+                                "    r = r + a * b;\n"
+                                "    return r;\n"
+                                "}\n");
+    Eliminate(func, Triples());
+    for (const auto& instr : func.block_instructions(0))
+        EXPECT_NE(instr.opcode, IROpcode::MUL);
+}
+
+TEST_F(PRETest, LeavesSingleComputations)
+{
+    IRFunction& func = Generate("int main(int c, int a, int b) {\n"
+                                "    int r = 0;\n"
+                                "    if (c > 0) { r = a * b; } else { r = a + b; }\n"
+                                "    return r;\n"
+                                "}\n");
+    EXPECT_FALSE(PartialRedundancyElimination().run(func));
+}
+
+TEST_F(PRETest, DoesNotHoistOutOfLoops)
+{
+    // The loop may not run at all, so a * b is not computed in front of it.
+    IRFunction& func = Generate("int main(int n, int a, int b) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + a * b; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    EXPECT_FALSE(PartialRedundancyElimination().run(func));
+}
+
+TEST_F(PRETest, BenchRedundancyAfterJoin)
+{
+    IRFunction& func = Generate("int main(int n, int a, int b) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        int x = i + a;\n"
+                                "        if (x > b) { s = s + x / 7; }\n"
+                                "        s = s + x / 7;\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    auto [before, after] = Eliminate(func, { { 1000, 3, 500 } });
+    // Iterations that take the then side divide once instead of twice; the
+    // others pay for a copy merging the quotient.
+    std::cout << "[ bench    ] quotient after join in loop, n = 1000: " << before << " -> " << after << " cycles\n";
+    EXPECT_LT(after + 15000, before);
+}
+
+} // namespace minic
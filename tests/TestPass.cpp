@@ -0,0 +1,73 @@
+#include "minic/Pass.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+namespace
+{
+
+class CountingPass : public IRPass
+{
+public:
+    int runs = 0;
+    std::string name() const override { return "counting"; }
+    bool run(IRFunction&) override
+    {
+        ++runs;
+        return false;
+    }
+};
+
+class BreakingPass : public IRPass
+{
+public:
+    std::string name() const override { return "breaking"; }
+    bool run(IRFunction& func) override
+    {
+        func.set_block_instructions(0, {});
+        return true;
+    }
+};
+
+std::unique_ptr<IRFunction> MakeFunction(const std::string& name)
+{
+    auto func = std::make_unique<IRFunction>(name, TokenType::KEYWORD_INT, std::vector<Parameter> {});
+    BlockId entry = func->add_block("entry");
+    func->append(entry, IRInstruction(IROpcode::RETURN, {}, IROperand::imm(0)));
+    return func;
+}
+
+} // namespace
+
+TEST(PassManagerTest, RunsEveryPassOnEveryFunction)
+{
+    IRProgram program;
+    program.functions.push_back(MakeFunction("f"));
+    program.functions.push_back(MakeFunction("g"));
+
+    auto pass = std::make_unique<CountingPass>();
+    CountingPass* counting = pass.get();
+    PassManager manager;
+    manager.add(std::move(pass));
+    EXPECT_FALSE(manager.run(program));
+    EXPECT_EQ(counting->runs, 2);
+}
+
+TEST(PassManagerTest, ReportsThePassThatBrokeTheIR)
+{
+    auto func = MakeFunction("f");
+    PassManager manager;
+    manager.add(std::make_unique<BreakingPass>());
+    try
+    {
+        manager.run(*func);
+        FAIL() << "expected a verification error";
+    }
+    catch (const std::runtime_error& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("breaking"), std::string::npos);
+    }
+}
+
+} // namespace minic
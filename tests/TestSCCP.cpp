@@ -0,0 +1,162 @@
+#include "TestUtils.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/SCCP.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class SCCPTest : public IRTest
+{
+protected:
+    // Generate IR in SSA form and propagate constants through it.
+    IRFunction& Propagate(const std::string& source)
+    {
+        IRFunction& func = Generate(source);
+        SSAConstruction().run(func);
+        SCCP().run(func);
+        func.verify();
+        return func;
+    }
+};
+
+TEST_F(SCCPTest, FeatureFlagArmIsDeleted)
+{
+    IRFunction& func = Propagate("int main(int a) {\n"
+                                 "    int debug = 0;\n"
+                                 "    int x = a;\n"
+                                 "    if (debug) { x = x * 100; }\n"
+                                 "    return x;\n"
+                                 "}\n");
+    EXPECT_EQ(FindBlock(func, "if_then"), -1);
+    EXPECT_EQ(Count(func, IROpcode::JUMPIFNOT), 0);
+    EXPECT_EQ(Count(func, IROpcode::MUL), 0);
+    EXPECT_EQ(IRInterpreter().run(func, { 3 }).value, 3);
+}
+
+TEST_F(SCCPTest, ConstantsFlowThroughPhis)
+{
+    // Both arms give y the same value, so the merge is still a constant.
+    IRFunction& func = Propagate("int main(int c) {\n"
+                                 "    int x = 3;\n"
+                                 "    int y;\n"
+                                 "    if (c) { y = x + 1; } else { y = 4; }\n"
+                                 "    return y * 2;\n"
+                                 "}\n");
+    EXPECT_EQ(func.terminator(static_cast<BlockId>(func.blocks.size()) - 1).operand1, IROperand::imm(8));
+    for (const auto& block : func.blocks)
+        EXPECT_TRUE(block.phis.empty());
+}
+
+TEST_F(SCCPTest, OptimisticLoopValue)
+{
+    // x only ever holds 1, which a pass that assumes the back edge is unknown cannot see.
+    IRFunction& func = Propagate("int main(int n) {\n"
+                                 "    int x = 1;\n"
+                                 "    int i = 0;\n"
+                                 "    while (i < n) { x = x * 1; i = i + 1; }\n"
+                                 "    return x;\n"
+                                 "}\n");
+    for (const auto& block : func.blocks)
+    {
+        const IRInstruction& term = func.block_instructions(block).back();
+        if (term.opcode == IROpcode::RETURN)
+        {
+            EXPECT_EQ(term.operand1, IROperand::imm(1));
+        }
+    }
+    EXPECT_EQ(IRInterpreter().run(func, { 4 }).value, 1);
+}
+
+TEST_F(SCCPTest, DeadLoopIsDeleted)
+{
+    IRFunction& func = Propagate("int main(int n) {\n"
+                                 "    int k = 2;\n"
+                                 "    while (k < 1) { n = n + 1; }\n"
+                                 "    return n;\n"
+                                 "}\n");
+    EXPECT_EQ(FindBlock(func, "while_body"), -1);
+    EXPECT_EQ(Count(func, IROpcode::ADD), 0);
+    EXPECT_EQ(IRInterpreter().run(func, { 7 }).value, 7);
+}
+
+TEST_F(SCCPTest, DroppedEdgeLeavesPhi)
+{
+    // The entry jumps straight to the join or through other; only the path
+    // through other survives, and the join's phi loses the entry edge.
+    IRFunction func("main", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "a") });
+    BlockId entry = func.add_block("entry");
+    BlockId other = func.add_block("other");
+    BlockId join = func.add_block("join");
+    IROperand flag = func.new_temp();
+    IROperand value = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::ASSIGN, flag, IROperand::imm(1)));
+    func.append(entry, IRInstruction(IROpcode::JUMPIF, IROperand::block(join), flag, IROperand::block(other)));
+    func.append(other, IRInstruction(IROpcode::JUMP, {}, IROperand::block(join)));
+    func.blocks[join].phis.push_back({ value, { { entry, IROperand::imm(5) }, { other, IROperand::var(0) } } });
+    func.append(join, IRInstruction(IROpcode::RETURN, {}, value));
+
+    EXPECT_TRUE(SCCP().run(func));
+    func.verify();
+    ASSERT_EQ(func.blocks.size(), 3);
+    EXPECT_EQ(func.terminator(entry).opcode, IROpcode::JUMP);
+    ASSERT_EQ(func.blocks[join].phis[0].incoming.size(), 1);
+    EXPECT_EQ(func.blocks[join].phis[0].incoming[0].block, other);
+    EXPECT_EQ(IRInterpreter().run(func, { 9 }).value, 9);
+}
+
+TEST_F(SCCPTest, UndefinedConditionKeepsOneTarget)
+{
+    // The flag is only defined in an unreachable block, so it never gets a
+    // value; the branch must still keep a target.
+    IRFunction func("main", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "a") });
+    BlockId entry = func.add_block("entry");
+    BlockId then = func.add_block("then");
+    BlockId other = func.add_block("other");
+    BlockId dead = func.add_block("dead");
+    IROperand flag = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::JUMPIF, IROperand::block(other), flag, IROperand::block(then)));
+    func.append(then, IRInstruction(IROpcode::RETURN, {}, IROperand::imm(1)));
+    func.append(other, IRInstruction(IROpcode::RETURN, {}, IROperand::imm(2)));
+    func.append(dead, IRInstruction(IROpcode::ASSIGN, flag, IROperand::var(0)));
+    func.append(dead, IRInstruction(IROpcode::JUMP, {}, IROperand::block(then)));
+
+    EXPECT_TRUE(SCCP().run(func));
+    func.verify();
+    ASSERT_EQ(func.blocks.size(), 2);
+    EXPECT_EQ(func.terminator(entry).opcode, IROpcode::JUMP);
+    EXPECT_EQ(IRInterpreter().run(func, { 9 }).value, 2);
+}
+
+TEST_F(SCCPTest, TrapsAndUnknownsAreKept)
+{
+    IRFunction& func = Propagate("int main(int a) {\n"
+                                 "    int z = 0;\n"
+                                 "    if (a > 2) { return 10 / z; }\n"
+                                 "    return a;\n"
+                                 "}\n");
+    EXPECT_EQ(Count(func, IROpcode::DIV), 1);
+    EXPECT_EQ(Count(func, IROpcode::JUMPIFNOT), 1);
+    EXPECT_EQ(IRInterpreter().run(func, { 1 }).value, 1);
+    EXPECT_THROW(IRInterpreter().run(func, { 5 }), std::runtime_error);
+    EXPECT_FALSE(SCCP().run(func));
+}
+
+TEST_F(SCCPTest, PreservesResultsOutsideSSA)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    while (n > 0) { s = s + n; n = n - 1; }\n"
+                                "    if (0) { s = 99; }\n"
+                                "    return s;\n"
+                                "}\n");
+    IRInterpreter interp;
+    auto before = interp.run(func, { 5 });
+    EXPECT_TRUE(SCCP().run(func));
+    func.verify();
+    EXPECT_EQ(FindBlock(func, "if_then"), -1);
+    EXPECT_EQ(interp.run(func, { 5 }).value, before.value);
+}
+
+} // namespace minic
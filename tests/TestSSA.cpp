@@ -0,0 +1,301 @@
+#include "TestUtils.hpp"
+#include "minic/CFG.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class SSATest : public IRTest
+{
+protected:
+    // Single definitions, no variable writes, parameters the only variables
+    // read, and one phi entry per predecessor.
+    void ExpectSSA(const IRFunction& func)
+    {
+        ControlFlowGraph cfg(func);
+        std::vector<int> defs(func.temp_count, 0);
+        auto check_use = [&](const IROperand& op) {
+            if (op.is_var())
+            {
+                EXPECT_LT(static_cast<size_t>(op.value), func.parameters.size()) << func.operand_name(op);
+            }
+        };
+        for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        {
+            for (const auto& phi : func.blocks[id].phis)
+            {
+                ASSERT_TRUE(phi.result.is_temp());
+                ++defs[phi.result.value];
+                EXPECT_EQ(phi.incoming.size(), cfg.predecessors(id).size());
+                for (BlockId pred : cfg.predecessors(id))
+                    EXPECT_FALSE(phi.value_from(pred).empty());
+                for (const auto& in : phi.incoming)
+                    check_use(in.value);
+            }
+            for (const auto& instr : func.block_instructions(id))
+            {
+                check_use(instr.operand1);
+                check_use(instr.operand2);
+                if (instr.is_terminator())
+                    continue;
+                EXPECT_FALSE(instr.result.is_var());
+                if (instr.result.is_temp())
+                    ++defs[instr.result.value];
+            }
+        }
+        for (size_t t = 0; t < defs.size(); ++t)
+            EXPECT_LE(defs[t], 1) << "t" << t;
+    }
+
+    // Run the function on every argument list before and after the round trip
+    // through SSA and compare results.
+    void ExpectRoundTrip(const std::string& source, const Inputs& inputs)
+    {
+        IRFunction& func = Generate(source);
+        IRInterpreter interp;
+        std::vector<std::int64_t> expected;
+        for (const auto& args : inputs)
+            expected.push_back(interp.run(func, args).value);
+
+        SSAConstruction().run(func);
+        func.verify();
+        ExpectSSA(func);
+        for (size_t i = 0; i < inputs.size(); ++i)
+            EXPECT_EQ(interp.run(func, inputs[i]).value, expected[i]) << "SSA form, input " << i;
+
+        SSADestruction().run(func);
+        func.verify();
+        EXPECT_EQ(PhiCount(func), 0);
+        for (size_t i = 0; i < inputs.size(); ++i)
+            EXPECT_EQ(interp.run(func, inputs[i]).value, expected[i]) << "after SSA, input " << i;
+    }
+};
+
+TEST_F(SSATest, DiamondGetsOnePhi)
+{
+    IRFunction& func = Generate("int main(int c) {\n"
+                                "    int x = 1;\n"
+                                "    int y = 7;\n"
+                                "    if (c) { x = 2; } else { x = 3; }\n"
+                                "    return x + y;\n"
+                                "}\n");
+    EXPECT_TRUE(SSAConstruction().run(func));
+    func.verify();
+    ExpectSSA(func);
+
+    BlockId end = FindBlock(func, "if_end");
+    ASSERT_EQ(func.blocks[end].phis.size(), 1);
+    const PhiNode& phi = func.blocks[end].phis[0];
+    EXPECT_EQ(phi.incoming.size(), 2);
+    EXPECT_EQ(PhiCount(func), 1);
+
+    // The copies into x and y are gone; the literal temps flow straight into the phi and the add.
+    for (const auto& block : func.blocks)
+    {
+        for (const auto& instr : func.block_instructions(block))
+            EXPECT_FALSE(instr.opcode == IROpcode::ASSIGN && instr.operand1.is_temp());
+    }
+}
+
+TEST_F(SSATest, LoopHeaderPhi)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int i = 0;\n"
+                                "    int s = 0;\n"
+                                "    while (i < n) { s = s + i; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    ExpectSSA(func);
+    BlockId cond = FindBlock(func, "while_cond");
+    EXPECT_EQ(func.blocks[cond].phis.size(), 2);
+    EXPECT_EQ(PhiCount(func), 2);
+
+    IRInterpreter interp;
+    EXPECT_EQ(interp.run(func, { 5 }).value, 10);
+}
+
+TEST_F(SSATest, NoPhiForBlockLocalOrDeadValues)
+{
+    IRFunction& func = Generate("int main(int c) {\n"
+                                "    int t = 0;\n"
+                                "    if (c) { t = 4; t = t * 2; } else { t = 5; }\n"
+                                "    return c;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    ExpectSSA(func);
+    // t is dead after the join, so its phi is pruned.
+    EXPECT_EQ(PhiCount(func), 0);
+}
+
+TEST_F(SSATest, ParametersReadTheirIncomingValue)
+{
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int b = a;\n"
+                                "    a = a + 1;\n"
+                                "    return a * b;\n"
+                                "}\n");
+    SSAConstruction().run(func);
+    ExpectSSA(func);
+    IRInterpreter interp;
+    EXPECT_EQ(interp.run(func, { 6 }).value, 42);
+}
+
+TEST_F(SSATest, UnreachableBlocksAreRemoved)
+{
+    IRFunction& func = Generate("int main() {\n"
+                                "    int x = 1;\n"
+                                "    return x;\n"
+                                "    x = 2;\n"
+                                "    while (x) { x = x - 1; }\n"
+                                "    return x;\n"
+                                "}\n");
+    size_t before = func.blocks.size();
+    SSAConstruction().run(func);
+    func.verify();
+    EXPECT_LT(func.blocks.size(), before);
+    ControlFlowGraph cfg(func);
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+        EXPECT_TRUE(cfg.reachable(id));
+}
+
+TEST_F(SSATest, RoundTripPreservesResults)
+{
+    ExpectRoundTrip("int main(int n) {\n"
+                    "    int i = 0;\n"
+                    "    int s = 0;\n"
+                    "    while (i < n) {\n"
+                    "        if (i > 2) { s = s + i * 2; } else { s = s - 1; }\n"
+                    "        i = i + 1;\n"
+                    "    }\n"
+                    "    return s;\n"
+                    "}\n",
+        { { 0 }, { 1 }, { 3 }, { 10 } });
+
+    ExpectRoundTrip("int main(int a, int b) {\n"
+                    "    int x;\n"
+                    "    if (a < b) { x = a; }\n"
+                    "    return x + b;\n"
+                    "}\n",
+        { { 1, 2 }, { 5, 2 } });
+}
+
+TEST_F(SSATest, SwapInLoopNeedsScratchCopy)
+{
+    // a and b swap every iteration: their phis form a copy cycle.
+    ExpectRoundTrip("int main(int n) {\n"
+                    "    int a = 1;\n"
+                    "    int b = 2;\n"
+                    "    int i = 0;\n"
+                    "    while (i < n) { int t = a; a = b; b = t; i = i + 1; }\n"
+                    "    return a * 10 + b;\n"
+                    "}\n",
+        { { 0 }, { 1 }, { 2 }, { 7 } });
+}
+
+TEST_F(SSATest, DestructionSplitsCriticalEdges)
+{
+    // The entry branches straight to the join, so that edge needs its own block for the copy.
+    IRFunction func("main", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "c") });
+    BlockId entry = func.add_block("entry");
+    BlockId other = func.add_block("other");
+    BlockId join = func.add_block("join");
+    IROperand value = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::JUMPIF, IROperand::block(other), IROperand::var(0), IROperand::block(join)));
+    func.append(other, IRInstruction(IROpcode::JUMP, {}, IROperand::block(join)));
+    func.blocks[join].phis.push_back({ value, { { entry, IROperand::imm(2) }, { other, IROperand::imm(1) } } });
+    func.append(join, IRInstruction(IROpcode::RETURN, {}, value));
+    func.verify();
+
+    EXPECT_TRUE(SSADestruction().run(func));
+    func.verify();
+    ASSERT_EQ(func.blocks.size(), 4);
+    EXPECT_EQ(func.blocks[3].label, "split_3");
+    EXPECT_EQ(func.terminator(entry).operand2, IROperand::block(3));
+    EXPECT_EQ(func.block_instructions(3).size(), 2);
+    EXPECT_EQ(func.block_instructions(other).size(), 2);
+    EXPECT_FALSE(SSADestruction().run(func));
+
+    IRInterpreter interp;
+    EXPECT_EQ(interp.run(func, { 0 }).value, 1);
+    EXPECT_EQ(interp.run(func, { 1 }).value, 2);
+}
+
+TEST_F(SSATest, DestructionKeepsBottomTestedBackEdge)
+{
+    // do { i = i + 1; } while (i < n); return i; -- the copy fits before the branch.
+    IRFunction func("main", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "n") });
+    BlockId entry = func.add_block("entry");
+    BlockId loop = func.add_block("loop");
+    BlockId exit = func.add_block("exit");
+    IROperand i = func.new_temp();
+    IROperand next = func.new_temp();
+    IROperand cond = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::JUMP, {}, IROperand::block(loop)));
+    func.blocks[loop].phis.push_back({ i, { { entry, IROperand::imm(0) }, { loop, next } } });
+    func.append(loop, IRInstruction(IROpcode::ADD, next, i, IROperand::imm(1)));
+    func.append(loop, IRInstruction(IROpcode::LT, cond, next, IROperand::var(0)));
+    func.append(loop, IRInstruction(IROpcode::JUMPIF, IROperand::block(exit), cond, IROperand::block(loop)));
+    func.append(exit, IRInstruction(IROpcode::RETURN, {}, next));
+    func.verify();
+
+    EXPECT_TRUE(SSADestruction().run(func));
+    func.verify();
+    EXPECT_EQ(func.blocks.size(), 3);
+    EXPECT_EQ(func.terminator(loop).operand2, IROperand::block(loop));
+    EXPECT_EQ(func.block_instructions(loop).size(), 4);
+
+    IRInterpreter interp;
+    EXPECT_EQ(interp.run(func, { 0 }).value, 1);
+    EXPECT_EQ(interp.run(func, { 5 }).value, 5);
+}
+
+TEST_F(SSATest, DestructionSplitsBackEdgeReadAfterLoop)
+{
+    // The exit returns the phi itself, so the copy must not run when leaving.
+    IRFunction func("main", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "n") });
+    BlockId entry = func.add_block("entry");
+    BlockId loop = func.add_block("loop");
+    BlockId exit = func.add_block("exit");
+    IROperand i = func.new_temp();
+    IROperand next = func.new_temp();
+    IROperand cond = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::JUMP, {}, IROperand::block(loop)));
+    func.blocks[loop].phis.push_back({ i, { { entry, IROperand::imm(0) }, { loop, next } } });
+    func.append(loop, IRInstruction(IROpcode::ADD, next, i, IROperand::imm(1)));
+    func.append(loop, IRInstruction(IROpcode::LT, cond, next, IROperand::var(0)));
+    func.append(loop, IRInstruction(IROpcode::JUMPIF, IROperand::block(exit), cond, IROperand::block(loop)));
+    func.append(exit, IRInstruction(IROpcode::RETURN, {}, i));
+    func.verify();
+
+    EXPECT_TRUE(SSADestruction().run(func));
+    func.verify();
+    EXPECT_EQ(func.blocks.size(), 4);
+    EXPECT_EQ(func.terminator(loop).operand2, IROperand::block(3));
+
+    IRInterpreter interp;
+    EXPECT_EQ(interp.run(func, { 0 }).value, 0);
+    EXPECT_EQ(interp.run(func, { 5 }).value, 4);
+}
+
+TEST_F(SSATest, ConstructionRepairsDuplicatedDefinitions)
+{
+    // After SSADestruction phi results have several definitions; running
+    // construction again rebuilds proper SSA from them.
+    ExpectRoundTrip("int main(int n) {\n"
+                    "    int s = 0;\n"
+                    "    while (n > 0) { s = s + n; n = n - 1; }\n"
+                    "    return s;\n"
+                    "}\n",
+        { { 4 } });
+    IRFunction& func = *ir_->functions[0];
+    SSAConstruction().run(func);
+    func.verify();
+    ExpectSSA(func);
+    IRInterpreter interp;
+    EXPECT_EQ(interp.run(func, { 4 }).value, 10);
+}
+
+} // namespace minic
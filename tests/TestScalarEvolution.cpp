@@ -0,0 +1,135 @@
+#include "TestUtils.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/SCCP.hpp"
+#include "minic/SSA.hpp"
+#include "minic/ScalarEvolution.hpp"
+#include <gtest/gtest.h>
+
+namespace minic
+{
+
+class ScalarEvolutionTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        ensure_preheaders(func);
+        return func;
+    }
+
+    // Fold and check results for every input; returns the largest step count after folding.
+    std::uint64_t Fold(IRFunction& func, const Inputs& inputs)
+    {
+        ExpectPreserved(func, inputs, [](IRFunction& f) { EXPECT_TRUE(LoopFolding().run(f)); });
+        std::uint64_t steps = 0;
+        for (const auto& args : inputs)
+            steps = std::max(steps, IRInterpreter().run(func, args).steps);
+        return steps;
+    }
+};
+
+TEST_F(ScalarEvolutionTest, ConstantTripCount)
+{
+    IRFunction& func = Generate("int main() {\n"
+                                "    int i = 3;\n"
+                                "    while (i <= 20) { i = i + 4; }\n"
+                                "    return i;\n"
+                                "}\n");
+    ControlFlowGraph cfg(func);
+    LoopInfo info(cfg);
+    ScalarEvolution scev(func, info.loops()[0]);
+    // 3, 7, 11, 15 and 19 pass the test.
+    EXPECT_EQ(scev.trip_count(), IROperand::imm(5));
+}
+
+TEST_F(ScalarEvolutionTest, SeriesHasDegreeTwo)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    ControlFlowGraph cfg(func);
+    LoopInfo info(cfg);
+    const Loop& loop = info.loops()[0];
+    ScalarEvolution scev(func, loop);
+    std::vector<int> degrees;
+    for (const auto& phi : func.blocks[loop.header].phis)
+    {
+        auto rec = scev.recurrence(phi.result);
+        ASSERT_TRUE(rec.has_value());
+        degrees.push_back(rec->degree());
+    }
+    std::sort(degrees.begin(), degrees.end());
+    EXPECT_EQ(degrees, (std::vector<int> { 1, 2 }));
+    // The bound is a parameter, so the count is computed as n - 0.
+    auto trips = scev.trip_count();
+    ASSERT_TRUE(trips.has_value());
+    EXPECT_TRUE(trips->is_var());
+}
+
+TEST_F(ScalarEvolutionTest, FoldsCountingLoop)
+{
+    IRFunction& func = Generate("int main() {\n"
+                                "    int x = 0;\n"
+                                "    while (x < 10) { x = x + 1; }\n"
+                                "    return x;\n"
+                                "}\n");
+    IRInterpreter interp;
+    auto before = interp.run(func, {});
+    auto after = Fold(func, { {} });
+    SCCP().run(func);
+    EXPECT_EQ(CountLoops(func), 0);
+    // The loop is entered, so only the closed form reaches the return.
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (func.terminator(id).opcode == IROpcode::RETURN)
+        {
+            EXPECT_EQ(func.terminator(id).operand1, IROperand::imm(10));
+        }
+    }
+    EXPECT_LT(after, before.steps);
+}
+
+TEST_F(ScalarEvolutionTest, FoldsArithmeticSeries)
+{
+    IRFunction& func = Generate("int main(int n, int k) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i * k + 1; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    auto steps = Fold(func, { { 0, 3 }, { 1, 3 }, { 7, -2 }, { 100000, 3 }, { -5, 1 } });
+    EXPECT_EQ(CountLoops(func), 0);
+    EXPECT_LT(steps, 40);
+}
+
+TEST_F(ScalarEvolutionTest, FoldsCountdown)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 1;\n"
+                                "    while (n > 0) { s = s + 3; n = n - 1; }\n"
+                                "    return s + n;\n"
+                                "}\n");
+    Fold(func, { { 0 }, { 1 }, { 50 }, { -3 } });
+    EXPECT_EQ(CountLoops(func), 0);
+}
+
+TEST_F(ScalarEvolutionTest, KeepsLoopsWithoutClosedForm)
+{
+    // The bound is not affine, the update is conditional, and the loop can return.
+    for (const char* body : { "while (i * i < n) { i = i + 1; }",
+             "while (i < n) { if (i < 3) { s = s + 1; } i = i + 1; }",
+             "while (i < n) { if (s > 100) { return s; } s = s + i; i = i + 1; }",
+             "while (i < n) { s = s * 2; i = i + 1; }" })
+    {
+        IRFunction& func = Generate(std::string("int main(int n) {\n    int s = 0;\n    int i = 0;\n    ") + body + "\n    return s + i;\n}\n");
+        EXPECT_FALSE(LoopFolding().run(func)) << body;
+        EXPECT_EQ(CountLoops(func), 1);
+    }
+}
+
+} // namespace minic
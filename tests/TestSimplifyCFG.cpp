@@ -0,0 +1,125 @@
+#include "TestUtils.hpp"
+#include "minic/CFG.hpp"
+#include "minic/SSA.hpp"
+#include "minic/SimplifyCFG.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+namespace minic
+{
+
+class SimplifyCFGTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source, bool ssa)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        if (ssa)
+            SSAConstruction().run(func);
+        return func;
+    }
+
+    // Simplify and check every input, also out of SSA form.
+    void Simplify(IRFunction& func, const Inputs& inputs)
+    {
+        ExpectPreservedInSSA(func, inputs, [](IRFunction& f) { EXPECT_TRUE(SimplifyCFG().run(f)); });
+    }
+
+    size_t JumpOnlyBlocks(const IRFunction& func)
+    {
+        size_t count = 0;
+        for (BlockId id = 1; id < static_cast<BlockId>(func.blocks.size()); ++id)
+            count += func.blocks[id].size == 1 && func.terminator(id).opcode == IROpcode::JUMP;
+        return count;
+    }
+
+    Inputs Singles() { return { { -2 }, { 0 }, { 1 }, { 5 } }; }
+};
+
+TEST_F(SimplifyCFGTest, RemovesEmptyElseAndEndBlocks)
+{
+    // IRGenerator emits an if_else block with nothing but a jump to if_end.
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int x = 3;\n"
+                                "    if (a > 0) { x = a; }\n"
+                                "    return x;\n"
+                                "}\n",
+        false);
+    size_t before = func.blocks.size();
+    Simplify(func, Singles());
+    EXPECT_EQ(JumpOnlyBlocks(func), 0);
+    EXPECT_LT(func.blocks.size(), before);
+}
+
+TEST_F(SimplifyCFGTest, MergesStraightLineChains)
+{
+    IRFunction func("main", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "a") });
+    BlockId entry = func.add_block("entry");
+    BlockId middle = func.add_block("middle");
+    BlockId last = func.add_block("last");
+    IROperand t = func.new_temp();
+    func.append(entry, IRInstruction(IROpcode::ADD, t, func.variable("a"), IROperand::imm(1)));
+    func.append(entry, IRInstruction(IROpcode::JUMP, {}, IROperand::block(last)));
+    func.append(middle, IRInstruction(IROpcode::RETURN, {}, IROperand::imm(0)));
+    func.append(last, IRInstruction(IROpcode::MUL, t, t, IROperand::imm(2)));
+    func.append(last, IRInstruction(IROpcode::RETURN, {}, t));
+    Simplify(func, Singles());
+    // The unreachable block is gone and the rest is one block.
+    ASSERT_EQ(func.blocks.size(), 1);
+    EXPECT_EQ(func.block_instructions(0).size(), 3);
+}
+
+TEST_F(SimplifyCFGTest, SkipsEmptyArmsIntoPhis)
+{
+    // In SSA form both arms are empty and the join merges the values with a phi.
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int r = 7;\n"
+                                "    if (a > 0) { r = 1; } else { r = 2; }\n"
+                                "    return r;\n"
+                                "}\n",
+        true);
+    Simplify(func, Singles());
+    // One arm stays, since the phi cannot take two entries from the branching block.
+    EXPECT_EQ(func.blocks.size(), 3);
+    ControlFlowGraph cfg(func);
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        for (const auto& phi : func.blocks[id].phis)
+            EXPECT_EQ(phi.incoming.size(), cfg.predecessors(id).size());
+    }
+}
+
+TEST_F(SimplifyCFGTest, KeepsLoops)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    while (s < n) {\n"
+                                "        if (s > 2) { s = s + 2; }\n"
+                                "        s = s + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n",
+        true);
+    Simplify(func, Singles());
+    EXPECT_EQ(JumpOnlyBlocks(func), 0);
+    EXPECT_FALSE(SimplifyCFG().run(func));
+}
+
+TEST_F(SimplifyCFGTest, BenchEmittedJumps)
+{
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int x = 0;\n"
+                                "    if (a > 0) { x = x + 1; }\n"
+                                "    if (a > 1) { if (a > 2) { x = x + 2; } }\n"
+                                "    if (a > 3) { x = x + 4; } else { if (a < -3) { x = x - 1; } }\n"
+                                "    return x;\n"
+                                "}\n",
+        false);
+    size_t before = JmpInstructions(func);
+    Simplify(func, { { -5 }, { 0 }, { 1 }, { 2 }, { 3 }, { 4 } });
+    size_t after = JmpInstructions(func);
+    std::cout << "[ bench    ] nested ifs without else: " << before << " -> " << after << " jmp instructions emitted\n";
+    EXPECT_LT(after, before);
+}
+
+} // namespace minic
@@ -0,0 +1,206 @@
+#include "TestUtils.hpp"
+#include "minic/CopyPropagation.hpp"
+#include "minic/DCE.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/SSA.hpp"
+#include "minic/StrengthReduction.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <limits>
+
+namespace minic
+{
+
+class StrengthReductionTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        return func;
+    }
+
+    // f(x) = x op c, or c op x when constant_first is set.
+    IRFunction Single(IROpcode op, std::int32_t c, bool constant_first = false)
+    {
+        IRFunction func { "f", TokenType::KEYWORD_INT, { Parameter(TokenType::KEYWORD_INT, "x") } };
+        BlockId entry = func.add_block("entry_0");
+        IROperand x = func.variable("x");
+        IROperand t = func.new_temp();
+        if (constant_first)
+            func.append(entry, IRInstruction(op, t, IROperand::imm(c), x));
+        else
+            func.append(entry, IRInstruction(op, t, x, IROperand::imm(c)));
+        func.append(entry, IRInstruction(IROpcode::RETURN, {}, t));
+        return func;
+    }
+
+    // Dividends around every multiple of c that is likely to go wrong, plus the extremes.
+    std::vector<std::int64_t> Inputs(std::int64_t c)
+    {
+        const std::int64_t min = std::numeric_limits<std::int64_t>::min();
+        const std::int64_t max = std::numeric_limits<std::int64_t>::max();
+        std::vector<std::int64_t> inputs = { 0, 1, -1, 2, -2, min, min + 1, max, max - 1, max / c };
+        for (std::int64_t k : { 1, 2, 3, 1000, 123456789 })
+        {
+            for (std::int64_t delta = -1; delta <= 1; ++delta)
+            {
+                inputs.push_back(k * c + delta);
+                inputs.push_back(-k * c + delta);
+            }
+        }
+        std::uint64_t seed = 0x9E3779B97F4A7C15ULL * static_cast<std::uint64_t>(c);
+        for (int i = 0; i < 32; ++i)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            inputs.push_back(static_cast<std::int64_t>(seed) >> (i % 48));
+        }
+        return inputs;
+    }
+
+    std::vector<std::int32_t> Constants()
+    {
+        std::vector<std::int32_t> constants;
+        for (std::int32_t c = -130; c <= 130; ++c)
+            constants.push_back(c);
+        for (std::int32_t c : { 641, 1000, -1000, 65536, 1 << 30, 1000000007, std::numeric_limits<std::int32_t>::max(), std::numeric_limits<std::int32_t>::min() })
+            constants.push_back(c);
+        return constants;
+    }
+
+    void ExpectSameResults(IROpcode op, bool constant_first)
+    {
+        IRInterpreter interp;
+        for (std::int32_t c : Constants())
+        {
+            IRFunction func = Single(op, c, constant_first);
+            StrengthReduction().run(func);
+            func.verify();
+            for (std::int64_t x : Inputs(c == 0 ? 1 : c))
+            {
+                auto expected = constant_first ? evaluate(op, c, x) : evaluate(op, x, c);
+                if (!expected)
+                {
+                    EXPECT_THROW(interp.run(func, { x }), std::runtime_error) << x << ", " << c;
+                    continue;
+                }
+                EXPECT_EQ(interp.run(func, { x }).value, *expected) << x << ", " << c;
+            }
+        }
+    }
+};
+
+TEST_F(StrengthReductionTest, DivisionMagicMatchesKnownValues)
+{
+    auto magic = division_magic(3);
+    EXPECT_EQ(magic.multiplier, 0x5555555555555556LL);
+    EXPECT_EQ(magic.shift, 0);
+    magic = division_magic(7);
+    EXPECT_EQ(magic.multiplier, 0x4924924924924925LL);
+    EXPECT_EQ(magic.shift, 1);
+    magic = division_magic(-5);
+    EXPECT_EQ(static_cast<std::uint64_t>(magic.multiplier), 0x9999999999999999ULL);
+    EXPECT_EQ(magic.shift, 1);
+}
+
+TEST_F(StrengthReductionTest, DividesExactlyByEveryConstant)
+{
+    ExpectSameResults(IROpcode::DIV, false);
+}
+
+TEST_F(StrengthReductionTest, MultipliesExactlyByEveryConstant)
+{
+    ExpectSameResults(IROpcode::MUL, false);
+    ExpectSameResults(IROpcode::MUL, true);
+}
+
+TEST_F(StrengthReductionTest, ReplacesExpensiveInstructions)
+{
+    IRFunction div = Single(IROpcode::DIV, 7);
+    EXPECT_TRUE(StrengthReduction().run(div));
+    EXPECT_EQ(Count(div, IROpcode::DIV), 0);
+    EXPECT_EQ(Count(div, IROpcode::MULH), 1);
+
+    IRFunction halve = Single(IROpcode::DIV, -8);
+    EXPECT_TRUE(StrengthReduction().run(halve));
+    EXPECT_EQ(Count(halve, IROpcode::DIV), 0);
+    EXPECT_EQ(Count(halve, IROpcode::MULH), 0);
+
+    IRFunction shift = Single(IROpcode::MUL, 16);
+    EXPECT_TRUE(StrengthReduction().run(shift));
+    EXPECT_EQ(Count(shift, IROpcode::MUL), 0);
+    EXPECT_EQ(Count(shift, IROpcode::SHL), 1);
+
+    IRFunction scaled = Single(IROpcode::MUL, 24);
+    EXPECT_TRUE(StrengthReduction().run(scaled));
+    auto code = scaled.block_instructions(0);
+    EXPECT_EQ(code[0].opcode, IROpcode::MUL);
+    EXPECT_EQ(code[0].operand2, IROperand::imm(3));
+    EXPECT_EQ(code[1].opcode, IROpcode::SHL);
+}
+
+TEST_F(StrengthReductionTest, KeepsWhatIsAlreadyCheap)
+{
+    // Three becomes one lea; eleven is cheaper as one imul than three simple
+    // instructions; zero is left to constant folding; the trapping divisions
+    // must still trap.
+    for (auto [op, c] : { std::pair { IROpcode::MUL, 3 }, { IROpcode::MUL, 11 }, { IROpcode::MUL, 0 }, { IROpcode::DIV, 0 }, { IROpcode::DIV, -1 }, { IROpcode::DIV, 1 } })
+    {
+        IRFunction func = Single(op, c);
+        EXPECT_FALSE(StrengthReduction().run(func)) << c;
+        EXPECT_EQ(func.block_instructions(0).size(), 2);
+    }
+}
+
+TEST_F(StrengthReductionTest, SharesMultiplierBetweenDivisions)
+{
+    IRFunction& func = Generate("int main(int a, int b) {\n"
+                                "    int q = 0;\n"
+                                "    if (a > b) { q = a / 10; } else { q = b / 10 + a / 10; }\n"
+                                "    return q;\n"
+                                "}\n");
+    EXPECT_TRUE(StrengthReduction().run(func));
+    func.verify();
+    EXPECT_EQ(Count(func, IROpcode::DIV), 0);
+    EXPECT_EQ(Count(func, IROpcode::MULH), 3);
+    // The 64-bit multiplier is built once, in the entry block.
+    size_t builds = 0;
+    for (const auto& instr : func.block_instructions(0))
+        builds += instr.opcode == IROpcode::SHL && instr.operand2 == IROperand::imm(32);
+    EXPECT_EQ(builds, 1);
+    IRInterpreter interp;
+    for (std::int64_t a : { -25, -9, 0, 9, 31 })
+    {
+        for (std::int64_t b : { -13, 0, 17 })
+            EXPECT_EQ(interp.run(func, { a, b }).value, a > b ? a / 10 : b / 10 + a / 10);
+    }
+}
+
+TEST_F(StrengthReductionTest, BenchDivisionInLoop)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) { s = s + i / 10 + i * 8; i = i + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    IRInterpreter interp;
+    IRFunction plain = func;
+    SSADestruction().run(plain);
+    auto before = interp.run(plain, { 1000 });
+
+    EXPECT_TRUE(StrengthReduction().run(func));
+    CopyPropagation().run(func);
+    DeadCodeElimination().run(func);
+    SSADestruction().run(func);
+    func.verify();
+    auto after = interp.run(func, { 1000 });
+    EXPECT_EQ(after.value, before.value);
+    // Three more instructions per iteration, but no idiv and no imul.
+    std::cout << "[ bench    ] i / 10 + i * 8, n = 1000: " << before.steps << " -> " << after.steps << " steps, "
+              << before.cycles << " -> " << after.cycles << " cycles\n";
+    EXPECT_LT(after.cycles * 3, before.cycles);
+}
+
+} // namespace minic
@@ -0,0 +1,200 @@
+#ifndef MINIC_TESTUTILS_HPP
+#define MINIC_TESTUTILS_HPP
+
+#include "minic/CFG.hpp"
+#include "minic/CodeGenerator.hpp"
+#include "minic/IRGenerator.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/Loops.hpp"
+#include "minic/Parser.hpp"
+#include "minic/SSA.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace minic
+{
+
+/// Argument lists to run a function with, one per call.
+using Inputs = std::vector<std::vector<std::int64_t>>;
+
+/// Interpreter counts summed over all inputs, before and after a transformation.
+using RunTotals = std::pair<IRInterpreter::Result, IRInterpreter::Result>;
+
+/**
+ * @class IRTest
+ * @brief Fixture base for tests on the IR of a miniC source; keeps the program alive.
+ */
+class IRTest : public ::testing::Test
+{
+protected:
+    std::unique_ptr<IRProgram> ir_;
+
+    // The first function of source, as the IRGenerator emits it.
+    IRFunction& Generate(const std::string& source)
+    {
+        Lexer lexer(source);
+        auto tokens = lexer.Lex();
+        Parser parser(tokens);
+        auto program = parser.parse();
+        IRGenerator generator;
+        ir_ = generator.generate(*program);
+        return *ir_->functions[0];
+    }
+};
+
+inline void Accumulate(IRInterpreter::Result& total, const IRInterpreter::Result& run)
+{
+    total.steps += run.steps;
+    total.cycles += run.cycles;
+    total.branches += run.branches;
+}
+
+// Transform func, verify it and check every input returns what it did before.
+template <typename Transform>
+RunTotals ExpectPreserved(IRFunction& func, const Inputs& inputs, Transform transform)
+{
+    IRInterpreter interp;
+    std::vector<std::int64_t> expected;
+    RunTotals totals;
+    for (const auto& args : inputs)
+    {
+        auto result = interp.run(func, args);
+        expected.push_back(result.value);
+        Accumulate(totals.first, result);
+    }
+    transform(func);
+    func.verify();
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        auto result = interp.run(func, inputs[i]);
+        EXPECT_EQ(result.value, expected[i]) << "input " << i;
+        Accumulate(totals.second, result);
+    }
+    return totals;
+}
+
+// The same for a function in SSA form, checked in SSA form and after
+// SSADestruction; the counts are taken out of SSA, where phis become copies.
+template <typename Transform>
+RunTotals ExpectPreservedInSSA(IRFunction& func, const Inputs& inputs, Transform transform)
+{
+    IRInterpreter interp;
+    IRFunction plain = func;
+    SSADestruction().run(plain);
+    std::vector<std::int64_t> expected;
+    RunTotals totals;
+    for (const auto& args : inputs)
+    {
+        auto result = interp.run(plain, args);
+        expected.push_back(result.value);
+        Accumulate(totals.first, result);
+    }
+    transform(func);
+    func.verify();
+    for (size_t i = 0; i < inputs.size(); ++i)
+        EXPECT_EQ(interp.run(func, inputs[i]).value, expected[i]) << "SSA form, input " << i;
+
+    IRFunction lowered = func;
+    SSADestruction().run(lowered);
+    lowered.verify();
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        auto result = interp.run(lowered, inputs[i]);
+        EXPECT_EQ(result.value, expected[i]) << "after SSA, input " << i;
+        Accumulate(totals.second, result);
+    }
+    return totals;
+}
+
+inline size_t Count(const IRFunction& func, IROpcode op)
+{
+    size_t count = 0;
+    for (const auto& block : func.blocks)
+    {
+        for (const auto& instr : func.block_instructions(block))
+            count += instr.opcode == op;
+    }
+    return count;
+}
+
+inline size_t CountBranches(const IRFunction& func)
+{
+    return Count(func, IROpcode::JUMPIF) + Count(func, IROpcode::JUMPIFNOT);
+}
+
+inline size_t CountLoops(const IRFunction& func)
+{
+    ControlFlowGraph cfg(func);
+    return LoopInfo(cfg).loops().size();
+}
+
+// Number of instructions with the opcode inside any loop.
+inline size_t CountInLoops(const IRFunction& func, IROpcode op)
+{
+    ControlFlowGraph cfg(func);
+    LoopInfo info(cfg);
+    size_t count = 0;
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (info.loop_of(id) < 0)
+            continue;
+        for (const auto& instr : func.block_instructions(id))
+            count += instr.opcode == op;
+    }
+    return count;
+}
+
+inline size_t PhiCount(const IRFunction& func)
+{
+    size_t count = 0;
+    for (const auto& block : func.blocks)
+        count += block.phis.size();
+    return count;
+}
+
+// The nth block whose label starts with prefix, or -1.
+inline BlockId FindBlock(const IRFunction& func, const std::string& prefix, int nth = 0)
+{
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        if (func.blocks[id].label.find(prefix) == 0 && nth-- == 0)
+            return id;
+    }
+    return -1;
+}
+
+// The block computing the first instruction with the opcode, or -1.
+inline BlockId BlockOf(const IRFunction& func, IROpcode op)
+{
+    for (BlockId id = 0; id < static_cast<BlockId>(func.blocks.size()); ++id)
+    {
+        for (const auto& instr : func.block_instructions(id))
+        {
+            if (instr.opcode == op)
+                return id;
+        }
+    }
+    return -1;
+}
+
+// jmp instructions in the assembly the CodeGenerator emits for func.
+inline size_t JmpInstructions(const IRFunction& func)
+{
+    IRProgram program;
+    program.functions.push_back(std::make_unique<IRFunction>(func));
+    std::ostringstream out;
+    CodeGenerator(out).generate(program);
+    std::string text = out.str();
+    size_t count = 0;
+    for (size_t at = text.find("    jmp "); at != std::string::npos; at = text.find("    jmp ", at + 1))
+        ++count;
+    return count;
+}
+
+} // namespace minic
+
+#endif // MINIC_TESTUTILS_HPP
@@ -0,0 +1,147 @@
+#include "TestUtils.hpp"
+#include "minic/DCE.hpp"
+#include "minic/IRInterpreter.hpp"
+#include "minic/SSA.hpp"
+#include "minic/VRP.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <limits>
+
+namespace minic
+{
+
+class VRPTest : public IRTest
+{
+protected:
+    IRFunction& Generate(const std::string& source)
+    {
+        IRFunction& func = IRTest::Generate(source);
+        SSAConstruction().run(func);
+        return func;
+    }
+
+    // Propagate ranges, clean up and check every input; returns the summed
+    // step counts before and after.
+    std::pair<std::uint64_t, std::uint64_t> Propagate(IRFunction& func, const Inputs& inputs)
+    {
+        auto [before, after] = ExpectPreserved(func, inputs, [](IRFunction& f) {
+            ValueRangePropagation().run(f);
+            f.verify();
+            DeadCodeElimination().run(f);
+        });
+        return { before.steps, after.steps };
+    }
+
+    Inputs Pairs(std::int64_t from, std::int64_t to)
+    {
+        Inputs inputs;
+        for (std::int64_t a = from; a <= to; ++a)
+        {
+            for (std::int64_t b = from; b <= to; ++b)
+                inputs.push_back({ a, b });
+        }
+        return inputs;
+    }
+};
+
+TEST_F(VRPTest, GuardImpliesComparisonInLoop)
+{
+    IRFunction& func = Generate("int main(int x, int n) {\n"
+                                "    int s = 0;\n"
+                                "    if (x >= 1) {\n"
+                                "        int i = 0;\n"
+                                "        while (i < n) {\n"
+                                "            if (x > 0) { s = s + i; } else { s = s - 1000; }\n"
+                                "            i = i + 1;\n"
+                                "        }\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    size_t branches = CountBranches(func);
+    Propagate(func, Pairs(-3, 5));
+    EXPECT_EQ(CountBranches(func), branches - 1);
+}
+
+TEST_F(VRPTest, LoopCounterStaysInBounds)
+{
+    IRFunction& func = Generate("int main(int a) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < 10) {\n"
+                                "        if (i < 0) { s = s + 100; }\n"
+                                "        if (i <= 9) { s = s + i * a; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    if (i == 10) { s = s + 1; }\n"
+                                "    return s;\n"
+                                "}\n");
+    Propagate(func, { { 0 }, { 3 }, { -7 } });
+    // Only the loop test is left.
+    EXPECT_EQ(CountBranches(func), 1);
+}
+
+TEST_F(VRPTest, ElseSideKnowsTheOpposite)
+{
+    IRFunction& func = Generate("int main(int x, int y) {\n"
+                                "    int r = 0;\n"
+                                "    if (x < 5) { r = 1; }\n"
+                                "    else {\n"
+                                "        if (x >= 5) { r = 2; } else { r = 3; }\n"
+                                "        if (y != 4) { r = r + 10; } else { if (y == 4) { r = r + 20; } }\n"
+                                "    }\n"
+                                "    return r;\n"
+                                "}\n");
+    Propagate(func, Pairs(2, 7));
+    EXPECT_EQ(CountBranches(func), 2);
+}
+
+TEST_F(VRPTest, KeepsUndecidedComparisons)
+{
+    IRFunction& func = Generate("int main(int x, int y) {\n"
+                                "    int r = 0;\n"
+                                "    if (x > 0) {\n"
+                                "        if (x > 3) { r = 1; }\n"
+                                "        if (x < y) { r = r + 2; }\n"
+                                "    }\n"
+                                "    return r;\n"
+                                "}\n");
+    size_t branches = CountBranches(func);
+    EXPECT_FALSE(ValueRangePropagation().run(func));
+    EXPECT_EQ(CountBranches(func), branches);
+}
+
+TEST_F(VRPTest, OverflowWidensToFullRange)
+{
+    // x + 1 wraps for the largest x, so y > 0 is not implied.
+    IRFunction& func = Generate("int main(int x) {\n"
+                                "    int r = 0;\n"
+                                "    if (x > 0) {\n"
+                                "        int y = x + 1;\n"
+                                "        if (y > 0) { r = 1; } else { r = 2; }\n"
+                                "    }\n"
+                                "    return r;\n"
+                                "}\n");
+    size_t branches = CountBranches(func);
+    Propagate(func, { { 5 }, { -5 }, { std::numeric_limits<std::int64_t>::max() } });
+    EXPECT_EQ(CountBranches(func), branches);
+    EXPECT_EQ(IRInterpreter().run(func, { std::numeric_limits<std::int64_t>::max() }).value, 2);
+}
+
+TEST_F(VRPTest, BenchRedundantBoundsCheck)
+{
+    IRFunction& func = Generate("int main(int n) {\n"
+                                "    int s = 0;\n"
+                                "    int i = 0;\n"
+                                "    while (i < n) {\n"
+                                "        if (i >= 0) { s = s + i; }\n"
+                                "        i = i + 1;\n"
+                                "    }\n"
+                                "    return s;\n"
+                                "}\n");
+    auto [before, after] = Propagate(func, { { 1000 } });
+    // The comparison is gone from every iteration and the branch is a jump.
+    std::cout << "[ bench    ] bounds check in loop, n = 1000: " << before << " -> " << after << " steps\n";
+    EXPECT_LT(after + 900, before);
+}
+
+} // namespace minic